@@ -0,0 +1,83 @@
+/**
+ * @file bench_atomic_shared_ptr.cpp
+ * @author whoami (13003827890@163.com)
+ * @brief reader scaling of atomic<SharedPtr> against a mutex-guarded SharedPtr
+ * @version 0.1
+ * @date 2026-10-15
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * One writer republishes the table every few microseconds while N readers
+ * load it in a loop.
+ */
+
+#include <mutex>
+
+#include "bench_util.h"
+#include "smart_ptr/shared_ptr.h"
+
+namespace {
+
+constexpr int kLoads = 1000000;
+
+struct RoutingTable {
+    long routes[8] = {};
+};
+
+template <typename Holder>
+void Run(const char* name, unsigned readers) {
+    Holder holder;
+    std::atomic<bool> done{false};
+    std::thread writer([&] {
+        while (!done.load(std::memory_order_relaxed)) {
+            holder.Store(tiny_std::MakeShared<RoutingTable>());
+            std::this_thread::sleep_for(std::chrono::microseconds(5));
+        }
+    });
+    double ns = bench::RunThreads(readers, [&](unsigned) {
+        for (int i = 0; i < kLoads; ++i) {
+            auto table = holder.Load();
+            bench::DoNotOptimize(table.get());
+        }
+    });
+    done.store(true);
+    writer.join();
+    bench::PrintRow(name, readers, ns / kLoads);
+}
+
+struct MutexHolder {
+    tiny_std::SharedPtr<RoutingTable> Load() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return table_;
+    }
+
+    void Store(tiny_std::SharedPtr<RoutingTable> t) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        table_.swap(t);
+    }
+
+    std::mutex mutex_;
+    tiny_std::SharedPtr<RoutingTable> table_ = tiny_std::MakeShared<RoutingTable>();
+};
+
+struct AtomicHolder {
+    tiny_std::SharedPtr<RoutingTable> Load() {
+        return table_.load();
+    }
+
+    void Store(tiny_std::SharedPtr<RoutingTable> t) {
+        table_.store(std::move(t));
+    }
+
+    tiny_std::atomic<tiny_std::SharedPtr<RoutingTable>> table_{tiny_std::MakeShared<RoutingTable>()};
+};
+
+}  // namespace
+
+int main() {
+    for (unsigned readers = 1; readers <= bench::MaxThreads(); readers *= 2) {
+        Run<MutexHolder>("load mutex + SharedPtr", readers);
+        Run<AtomicHolder>("load atomic<SharedPtr>", readers);
+    }
+    return 0;
+}
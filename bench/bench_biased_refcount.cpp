@@ -0,0 +1,74 @@
+/**
+ * @file bench_biased_refcount.cpp
+ * @author whoami (13003827890@163.com)
+ * @brief BIASED vs ATOMIC control blocks
+ * @version 0.1
+ * @date 2026-10-15
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Copies made on the thread that created the object are plain loads and
+ * stores with the BIASED policy; copies made anywhere else cost the same
+ * atomic RMW as with ATOMIC, plus a check of the owner.
+ */
+
+#include "bench_util.h"
+#include "smart_ptr/shared_ptr.h"
+
+namespace {
+
+constexpr int kIters = 2000000;
+
+struct Payload {
+    long value = 1;
+};
+
+template <tiny_std::LockPolicy Lp>
+void BenchOwnerCopy(const char* name) {
+    double ns = bench::RunOnce([] {
+        auto shared = tiny_std::MakeShared<Payload, Lp>();
+        for (int i = 0; i < kIters; ++i) {
+            tiny_std::SharedPtr<Payload, Lp> copy = shared;
+            bench::DoNotOptimize(copy.get());
+        }
+    });
+    bench::PrintRow(name, 1, ns / kIters);
+}
+
+// The object is created on the main thread, so none of the workers own it.
+template <tiny_std::LockPolicy Lp>
+void BenchForeignCopy(const char* name, unsigned threads) {
+    auto shared = tiny_std::MakeShared<Payload, Lp>();
+    double ns = bench::RunThreads(threads, [&](unsigned) {
+        for (int i = 0; i < kIters; ++i) {
+            tiny_std::SharedPtr<Payload, Lp> copy = shared;
+            bench::DoNotOptimize(copy.get());
+        }
+    });
+    bench::PrintRow(name, threads, ns / kIters);
+}
+
+template <tiny_std::LockPolicy Lp>
+void BenchMakeRelease(const char* name) {
+    double ns = bench::RunOnce([] {
+        for (int i = 0; i < kIters; ++i) {
+            auto p = tiny_std::MakeShared<Payload, Lp>();
+            bench::DoNotOptimize(p.get());
+        }
+    });
+    bench::PrintRow(name, 1, ns / kIters);
+}
+
+}  // namespace
+
+int main() {
+    BenchOwnerCopy<tiny_std::ATOMIC>("owner copy+destroy ATOMIC");
+    BenchOwnerCopy<tiny_std::BIASED>("owner copy+destroy BIASED");
+    BenchMakeRelease<tiny_std::ATOMIC>("make+last release ATOMIC");
+    BenchMakeRelease<tiny_std::BIASED>("make+last release BIASED");
+    for (unsigned threads = 1; threads <= bench::MaxThreads(); threads *= 2) {
+        BenchForeignCopy<tiny_std::ATOMIC>("foreign copy+destroy ATOMIC", threads);
+        BenchForeignCopy<tiny_std::BIASED>("foreign copy+destroy BIASED", threads);
+    }
+    return 0;
+}
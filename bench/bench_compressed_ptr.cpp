@@ -0,0 +1,107 @@
+/**
+ * @file bench_compressed_ptr.cpp
+ * @author whoami (13003827890@163.com)
+ * @brief tree traversal with 8-byte vs 4-byte child pointers
+ * @version 0.1
+ * @date 2026-10-15
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Builds the same complete binary tree twice: once with unique_ptr children
+ * allocated by new, once with arena_unique_ptr children in an arena. The
+ * arena nodes are half the size and packed in allocation order, so a
+ * depth-first walk touches fewer cache lines.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#include "bench_util.h"
+#include "smart_ptr/compressed_ptr.h"
+
+namespace {
+
+constexpr int kDepth = 22;
+constexpr int kWalks = 10;
+
+struct HeapNode {
+    std::uint32_t value;
+    tiny_std::unique_ptr<HeapNode> left;
+    tiny_std::unique_ptr<HeapNode> right;
+};
+
+struct BenchArenaTag {};
+using BenchArena = tiny_std::arena<BenchArenaTag>;
+
+struct ArenaNode {
+    std::uint32_t value;
+    tiny_std::arena_unique_ptr<ArenaNode, BenchArena> left;
+    tiny_std::arena_unique_ptr<ArenaNode, BenchArena> right;
+};
+
+tiny_std::unique_ptr<HeapNode> BuildHeap(int depth, std::uint32_t& next) {
+    auto node = tiny_std::make_unique<HeapNode>();
+    node->value = next++;
+    if (depth > 0) {
+        node->left = BuildHeap(depth - 1, next);
+        node->right = BuildHeap(depth - 1, next);
+    }
+    return node;
+}
+
+tiny_std::arena_unique_ptr<ArenaNode, BenchArena> BuildArena(int depth, std::uint32_t& next) {
+    auto node = tiny_std::make_arena_unique<ArenaNode, BenchArena>();
+    node->value = next++;
+    if (depth > 0) {
+        node->left = BuildArena(depth - 1, next);
+        node->right = BuildArena(depth - 1, next);
+    }
+    return node;
+}
+
+template <typename Node>
+std::uint64_t Walk(const Node* node) {
+    std::uint64_t sum = 0;
+    while (node != nullptr) {
+        sum += node->value;
+        if (node->right)
+            sum += Walk(&*node->right);
+        node = node->left ? &*node->left : nullptr;
+    }
+    return sum;
+}
+
+template <typename Root>
+void BenchWalk(const char* name, const Root& root, std::size_t nodes) {
+    std::uint64_t sum = 0;
+    double ns = bench::RunOnce([&] {
+        for (int i = 0; i < kWalks; ++i) sum += Walk(&*root);
+    });
+    bench::DoNotOptimize(sum);
+    bench::PrintRow(name, 1, ns / (double(nodes) * kWalks));
+}
+
+}  // namespace
+
+int main() {
+    const std::size_t nodes = (std::size_t(1) << (kDepth + 1)) - 1;
+    std::printf("sizeof(HeapNode)=%zu sizeof(ArenaNode)=%zu nodes=%zu\n", sizeof(HeapNode), sizeof(ArenaNode), nodes);
+
+    {
+        std::uint32_t next = 0;
+        tiny_std::unique_ptr<HeapNode> root;
+        double ns = bench::RunOnce([&] { root = BuildHeap(kDepth, next); });
+        bench::PrintRow("build unique_ptr", 1, ns / nodes);
+        BenchWalk("walk unique_ptr", root, nodes);
+    }
+    {
+        BenchArena arena((nodes + 1) * 2 * BenchArena::GRANULE);
+        std::uint32_t next = 0;
+        tiny_std::arena_unique_ptr<ArenaNode, BenchArena> root;
+        double ns = bench::RunOnce([&] { root = BuildArena(kDepth, next); });
+        bench::PrintRow("build arena_unique_ptr", 1, ns / nodes);
+        BenchWalk("walk arena_unique_ptr", root, nodes);
+    }
+    return 0;
+}
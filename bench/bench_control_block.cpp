@@ -0,0 +1,62 @@
+/**
+ * @file bench_control_block.cpp
+ * @author whoami (13003827890@163.com)
+ * @brief Cost of the last release of a control block
+ * @version 0.1
+ * @date 2026-10-15
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * The objects are created up front and only the releases are timed, so the
+ * rows show what the last reference costs once the counts reach zero:
+ * dispatching to the block's dispose and destroy, running the destructor and
+ * freeing the memory. make_shared blocks with no weak references take the
+ * fast path that drops both counts at once. The last row keeps a weak
+ * reference alive, so dispose and destroy run from separate releases.
+ */
+
+#include <cstdio>
+#include <vector>
+
+#include "bench_util.h"
+#include "smart_ptr/shared_ptr.h"
+
+namespace {
+
+constexpr int kObjects = 1 << 16;
+constexpr int kRounds = 20;
+
+struct Payload {
+    long value = 1;
+};
+
+template <typename Make>
+void BenchRelease(const char* name, Make make, bool keep_weak) {
+    double total = 0;
+    for (int round = 0; round < kRounds; ++round) {
+        std::vector<tiny_std::SharedPtr<Payload>> owners;
+        std::vector<tiny_std::WeakPtr<Payload>> weak;
+        owners.reserve(kObjects);
+        for (int i = 0; i < kObjects; ++i) owners.push_back(make());
+        if (keep_weak)
+            weak.assign(owners.begin(), owners.end());
+        total += bench::RunOnce([&] {
+            for (auto& p : owners) p.reset();
+        });
+        bench::DoNotOptimize(weak.size());
+    }
+    bench::PrintRow(name, 1, total / (double(kObjects) * kRounds));
+}
+
+}  // namespace
+
+int main() {
+    std::printf("sizeof(SpCountedBase<ATOMIC>) = %zu\n", sizeof(tiny_std::SpCountedBase<tiny_std::ATOMIC>));
+    BenchRelease(
+        "last release, make_shared", [] { return tiny_std::MakeShared<Payload>(); }, false);
+    BenchRelease(
+        "last release, SharedPtr(new)", [] { return tiny_std::SharedPtr<Payload>(new Payload); }, false);
+    BenchRelease(
+        "last release, weak outstanding", [] { return tiny_std::MakeShared<Payload>(); }, true);
+    return 0;
+}
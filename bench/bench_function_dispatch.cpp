@@ -0,0 +1,98 @@
+/**
+ * @file bench_function_dispatch.cpp
+ * @author whoami (13003827890@163.com)
+ * @brief invoke, copy and move cost of function against std::function
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * A pipeline of kStages callbacks of four different types, all small enough
+ * for the small buffer, so every stage is an indirect call the compiler
+ * cannot see through. "invoke" runs a value through the whole pipeline,
+ * "copy" copies the pipeline (a clone and a destroy per stage), "reverse"
+ * reverses it in place (a swap, so three moves, per pair of stages).
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "bench_util.h"
+#include "functional/function.h"
+
+namespace {
+
+constexpr int kStages = 64;
+constexpr int kRounds = 200000;
+
+template <typename Fn>
+std::vector<Fn> MakePipeline() {
+    std::vector<Fn> stages;
+    long k = 3;
+    for (int i = 0; i < kStages; ++i) {
+        switch (i % 4) {
+            case 0:
+                stages.emplace_back([k](long x) { return x + k; });
+                break;
+            case 1:
+                stages.emplace_back([k](long x) { return x ^ k; });
+                break;
+            case 2:
+                stages.emplace_back([](long x) { return x >> 1; });
+                break;
+            default:
+                stages.emplace_back([k, i](long x) { return x * k - i; });
+                break;
+        }
+    }
+    return stages;
+}
+
+template <typename Fn>
+void Bench(const char* label) {
+    std::vector<Fn> stages = MakePipeline<Fn>();
+    std::string name;
+
+    long value = 0;
+    double ns = bench::RunOnce([&] {
+        for (int r = 0; r < kRounds; ++r) {
+            bench::DoNotOptimize(stages);
+            for (const Fn& stage : stages) value = stage(value);
+        }
+    });
+    bench::DoNotOptimize(value);
+    name = std::string("invoke ") + label;
+    bench::PrintRow(name.c_str(), 1, ns / (double(kRounds) * kStages));
+
+    constexpr int kCopies = kRounds / 20;
+    ns = bench::RunOnce([&] {
+        for (int r = 0; r < kCopies; ++r) {
+            std::vector<Fn> copy = stages;
+            bench::DoNotOptimize(copy);
+        }
+    });
+    name = std::string("copy ") + label;
+    bench::PrintRow(name.c_str(), 1, ns / (double(kCopies) * kStages));
+
+    ns = bench::RunOnce([&] {
+        for (int r = 0; r < kCopies; ++r) {
+            std::reverse(stages.begin(), stages.end());
+            bench::DoNotOptimize(stages);
+        }
+    });
+    name = std::string("reverse ") + label;
+    bench::PrintRow(name.c_str(), 1, ns / (double(kCopies) * kStages));
+}
+
+}  // namespace
+
+int main() {
+    std::printf("sizeof(function) = %zu, sizeof(std::function) = %zu\n", sizeof(tiny_std::function<long(long)>),
+                sizeof(std::function<long(long)>));
+    Bench<std::function<long(long)>>("std::function");
+    Bench<tiny_std::function<long(long)>>("function");
+    return 0;
+}
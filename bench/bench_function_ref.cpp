@@ -0,0 +1,89 @@
+/**
+ * @file bench_function_ref.cpp
+ * @author whoami (13003827890@163.com)
+ * @brief call overhead of function_ref against function
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * A visitor API that is not inlined takes the callback as a function_ref,
+ * a const function&, a function by value, or a template parameter (the
+ * floor). "visit" passes a lambda capturing three pointers, so function
+ * has to wrap it, and copy it to the heap, at every call; "call" measures
+ * the invocations alone, on a wrapper built once.
+ */
+
+#include <vector>
+
+#include "bench_util.h"
+#include "functional/function.h"
+#include "functional/function_ref.h"
+
+namespace {
+
+constexpr int kVisits = 200000;
+constexpr int kValues = 16;
+
+using Values = std::vector<long>;
+
+__attribute__((noinline)) long VisitRef(const Values& values, tiny_std::function_ref<long(long)> f) {
+    long sum = 0;
+    for (long v : values) sum += f(v);
+    return sum;
+}
+
+__attribute__((noinline)) long VisitConstRef(const Values& values, const tiny_std::function<long(long)>& f) {
+    long sum = 0;
+    for (long v : values) sum += f(v);
+    return sum;
+}
+
+__attribute__((noinline)) long VisitValue(const Values& values, tiny_std::function<long(long)> f) {
+    long sum = 0;
+    for (long v : values) sum += f(v);
+    return sum;
+}
+
+template <typename Fn>
+__attribute__((noinline)) long VisitTemplate(const Values& values, Fn f) {
+    long sum = 0;
+    for (long v : values) sum += f(v);
+    return sum;
+}
+
+template <typename Visit>
+void Bench(const char* name, Visit visit) {
+    Values values(kValues, 1);
+    long a = 1, b = 2, c = 3;
+    long sum = 0;
+    double ns = bench::RunOnce([&] {
+        for (int i = 0; i < kVisits; ++i) {
+            bench::DoNotOptimize(a);
+            sum += visit(values, [&a, &b, &c](long v) { return v * a + b - c; });
+        }
+    });
+    bench::DoNotOptimize(sum);
+    bench::PrintRow(name, 1, ns / kVisits);
+}
+
+}  // namespace
+
+int main() {
+    Bench("visit function_ref", [](const Values& v, auto f) { return VisitRef(v, f); });
+    Bench("visit const function&", [](const Values& v, auto f) { return VisitConstRef(v, f); });
+    Bench("visit function", [](const Values& v, auto f) { return VisitValue(v, f); });
+    Bench("visit template", [](const Values& v, auto f) { return VisitTemplate(v, f); });
+
+    long a = 1;
+    auto lambda = [&a](long v) { return v + a; };
+    tiny_std::function<long(long)> function = lambda;
+    tiny_std::function_ref<long(long)> ref = lambda;
+    Values values(kValues * kVisits, 1);
+    bench::DoNotOptimize(a);
+    double ns = bench::RunOnce([&] { bench::DoNotOptimize(VisitRef(values, ref)); });
+    bench::PrintRow("call function_ref", 1, ns / values.size());
+    ns = bench::RunOnce([&] { bench::DoNotOptimize(VisitConstRef(values, function)); });
+    bench::PrintRow("call function", 1, ns / values.size());
+    return 0;
+}
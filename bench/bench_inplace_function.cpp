@@ -0,0 +1,113 @@
+/**
+ * @file bench_inplace_function.cpp
+ * @author whoami (13003827890@163.com)
+ * @brief construct and invoke cost of inplace_function, function and std::function
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Callbacks of 8, 24 and 48 bytes of trivially copyable state, one that
+ * holds a tiny_std::shared_ptr and one that holds a std::string. function
+ * keeps the 8-byte and shared_ptr callbacks in its 16-byte buffer and
+ * allocates for the others; inplace_function with 64 bytes of capacity keeps
+ * all of them inline. "construct" wraps a fresh
+ * callback and calls it once; "invoke" calls a wrapper built beforehand.
+ */
+
+#include <array>
+#include <functional>
+#include <string>
+
+#include "bench_util.h"
+#include "functional/function.h"
+#include "functional/inplace_function.h"
+#include "smart_ptr/shared_ptr.h"
+
+namespace {
+
+constexpr int kIterations = 2000000;
+
+// A callback capturing Bytes of trivially copyable state.
+template <std::size_t Bytes>
+struct Capture {
+    std::array<char, Bytes> state{};
+
+    long operator()(long x) const {
+        return x + state[0];
+    }
+};
+
+// A callback sharing ownership of its state: not trivially copyable, but
+// small and nothrow movable.
+struct SharedCapture {
+    tiny_std::shared_ptr<long> state = tiny_std::make_shared<long>(1);
+
+    long operator()(long x) const {
+        return x + *state;
+    }
+};
+
+// A callback capturing a std::string, which is not trivially copyable.
+struct StringCapture {
+    std::string text = "callback";
+
+    long operator()(long x) const {
+        return x + static_cast<long>(text.size());
+    }
+};
+
+// Build a wrapper around a fresh callback and call it once: the pattern of
+// a callback registered per request.
+template <typename Fn, typename Target>
+void BenchConstruct(const char* name) {
+    Target target;
+    long sum = 0;
+    double ns = bench::RunOnce([&] {
+        for (int i = 0; i < kIterations; ++i) {
+            Fn f = target;
+            bench::DoNotOptimize(f);
+            sum += f(i);
+        }
+    });
+    bench::DoNotOptimize(sum);
+    bench::PrintRow(name, 1, ns / kIterations);
+}
+
+template <typename Fn, typename Target>
+void BenchInvoke(const char* name) {
+    Fn f = Target();
+    long sum = 0;
+    double ns = bench::RunOnce([&] {
+        for (int i = 0; i < kIterations; ++i) {
+            bench::DoNotOptimize(f);
+            sum += f(i);
+        }
+    });
+    bench::DoNotOptimize(sum);
+    bench::PrintRow(name, 1, ns / kIterations);
+}
+
+template <typename Target>
+void BenchAll(const char* label) {
+    using Inplace = tiny_std::inplace_function<long(long), 64>;
+    std::string name = std::string("construct ") + label;
+    BenchConstruct<std::function<long(long)>, Target>((name + " std::function").c_str());
+    BenchConstruct<tiny_std::function<long(long)>, Target>((name + " function").c_str());
+    BenchConstruct<Inplace, Target>((name + " inplace_function").c_str());
+    name = std::string("invoke ") + label;
+    BenchInvoke<std::function<long(long)>, Target>((name + " std::function").c_str());
+    BenchInvoke<tiny_std::function<long(long)>, Target>((name + " function").c_str());
+    BenchInvoke<Inplace, Target>((name + " inplace_function").c_str());
+}
+
+}  // namespace
+
+int main() {
+    BenchAll<Capture<8>>("8B");
+    BenchAll<Capture<24>>("24B");
+    BenchAll<Capture<48>>("48B");
+    BenchAll<SharedCapture>("shared_ptr");
+    BenchAll<StringCapture>("string");
+    return 0;
+}
@@ -0,0 +1,52 @@
+/**
+ * @file bench_make_shared_buffer.cpp
+ * @author whoami (13003827890@163.com)
+ * @brief allocation throughput of scratch buffers
+ * @version 0.1
+ * @date 2026-10-15
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * make_unique<T[]> and make_shared<T[]> value-initialize, which zeroes the
+ * whole buffer; the for_overwrite forms leave it alone. The gap grows with
+ * the buffer size.
+ */
+
+#include <cstddef>
+#include <cstdio>
+
+#include "bench_util.h"
+#include "smart_ptr/shared_ptr.h"
+
+namespace {
+
+constexpr std::size_t kTotalBytes = std::size_t(1) << 30;
+
+template <typename Make>
+void BenchBuffer(const char* name, std::size_t bytes, Make make) {
+    std::size_t iters = kTotalBytes / bytes;
+    double ns = bench::RunOnce([&] {
+        for (std::size_t i = 0; i < iters; ++i) {
+            auto p = make(bytes);
+            p[bytes - 1] = 1;
+            bench::DoNotOptimize(p[0]);
+        }
+    });
+    char label[64];
+    std::snprintf(label, sizeof(label), "%s %zuK", name, bytes / 1024);
+    bench::PrintRow(label, 1, ns / iters);
+}
+
+}  // namespace
+
+int main() {
+    for (std::size_t bytes = 4096; bytes <= (std::size_t(1) << 20); bytes *= 16) {
+        BenchBuffer("make_unique", bytes, [](std::size_t n) { return tiny_std::make_unique<unsigned char[]>(n); });
+        BenchBuffer("make_unique_for_overwrite", bytes,
+                    [](std::size_t n) { return tiny_std::make_unique_for_overwrite<unsigned char[]>(n); });
+        BenchBuffer("make_shared", bytes, [](std::size_t n) { return tiny_std::make_shared<unsigned char[]>(n); });
+        BenchBuffer("make_shared_for_overwrite", bytes,
+                    [](std::size_t n) { return tiny_std::make_shared_for_overwrite<unsigned char[]>(n); });
+    }
+    return 0;
+}
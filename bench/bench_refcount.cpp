@@ -0,0 +1,119 @@
+/**
+ * @file bench_refcount.cpp
+ * @author whoami (13003827890@163.com)
+ * @brief copy/destroy cost of the atomic reference counts
+ * @version 0.1
+ * @date 2026-10-15
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * RMWs per cycle on the control block:
+ *
+ *                                     legacy   tuned
+ *   copy + destroy (not last)           2        2   (relaxed add, acq_rel sub)
+ *   make + last release, no weak refs   2        0   (one acquire load of both counts)
+ *   make + last release, weak alive     2        2   (cold path)
+ *
+ * The legacy column is reproduced by LegacyCount below, which is the counting
+ * scheme SpCountedBase used before: seq_cst on every update and a second RMW
+ * on the weak count when the last strong reference goes away.
+ */
+
+#include <atomic>
+#include <memory>
+
+#include "bench_util.h"
+#include "smart_ptr/shared_ptr.h"
+
+namespace {
+
+constexpr int kIters = 2000000;
+
+struct Payload {
+    long value = 1;
+};
+
+struct LegacyCount {
+    std::atomic<int> use_cnt_{1};
+    std::atomic<int> weak_cnt_{1};
+    Payload payload_;
+
+    void AddRefCopy() {
+        use_cnt_++;
+    }
+
+    void Release() {
+        if (--use_cnt_ == 0) {
+            if (--weak_cnt_ == 0)
+                delete this;
+        }
+    }
+};
+
+void BenchCopyDestroy(unsigned threads) {
+    auto shared = tiny_std::make_shared<Payload>();
+    double ns = bench::RunThreads(threads, [&](unsigned) {
+        for (int i = 0; i < kIters; ++i) {
+            tiny_std::shared_ptr<Payload> copy = shared;
+            bench::DoNotOptimize(copy.get());
+        }
+    });
+    bench::PrintRow("copy+destroy tiny_std::shared_ptr", threads, ns / kIters);
+
+    auto legacy = new LegacyCount;
+    ns = bench::RunThreads(threads, [&](unsigned) {
+        for (int i = 0; i < kIters; ++i) {
+            legacy->AddRefCopy();
+            bench::DoNotOptimize(legacy->payload_);
+            legacy->Release();
+        }
+    });
+    legacy->Release();
+    bench::PrintRow("copy+destroy legacy seq_cst counts", threads, ns / kIters);
+
+    auto std_shared = std::make_shared<Payload>();
+    ns = bench::RunThreads(threads, [&](unsigned) {
+        for (int i = 0; i < kIters; ++i) {
+            std::shared_ptr<Payload> copy = std_shared;
+            bench::DoNotOptimize(copy.get());
+        }
+    });
+    bench::PrintRow("copy+destroy std::shared_ptr", threads, ns / kIters);
+}
+
+void BenchLastRelease(unsigned threads) {
+    double ns = bench::RunThreads(threads, [](unsigned) {
+        for (int i = 0; i < kIters; ++i) {
+            auto p = tiny_std::make_shared<Payload>();
+            bench::DoNotOptimize(p.get());
+        }
+    });
+    bench::PrintRow("make+last release tiny_std::shared_ptr", threads, ns / kIters);
+
+    ns = bench::RunThreads(threads, [](unsigned) {
+        for (int i = 0; i < kIters; ++i) {
+            auto p = new LegacyCount;
+            bench::DoNotOptimize(p->payload_);
+            p->Release();
+        }
+    });
+    bench::PrintRow("make+last release legacy seq_cst counts", threads, ns / kIters);
+
+    ns = bench::RunThreads(threads, [](unsigned) {
+        for (int i = 0; i < kIters; ++i) {
+            auto p = std::make_shared<Payload>();
+            bench::DoNotOptimize(p.get());
+        }
+    });
+    bench::PrintRow("make+last release std::shared_ptr", threads, ns / kIters);
+}
+
+}  // namespace
+
+int main() {
+    for (unsigned threads = 1; threads <= bench::MaxThreads(); threads *= 2) {
+        BenchCopyDestroy(threads);
+        BenchLastRelease(threads);
+    }
+    return 0;
+}
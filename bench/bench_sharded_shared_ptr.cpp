@@ -0,0 +1,52 @@
+/**
+ * @file bench_sharded_shared_ptr.cpp
+ * @author whoami (13003827890@163.com)
+ * @brief copying one hot object from every thread
+ * @version 0.1
+ * @date 2026-10-15
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Every thread copies and drops the same object. With SharedPtr all threads
+ * update one counter; with sharded_shared_ptr each thread updates its own
+ * shard, so the cost per copy should stay flat as threads are added.
+ */
+
+#include "bench_util.h"
+#include "smart_ptr/shared_ptr.h"
+#include "smart_ptr/sharded_shared_ptr.h"
+
+namespace {
+
+constexpr int kIters = 2000000;
+
+struct Config {
+    long value = 1;
+};
+
+void BenchCopy(unsigned threads) {
+    auto shared = tiny_std::MakeShared<Config>();
+    double ns = bench::RunThreads(threads, [&](unsigned) {
+        for (int i = 0; i < kIters; ++i) {
+            tiny_std::SharedPtr<Config> copy = shared;
+            bench::DoNotOptimize(copy.get());
+        }
+    });
+    bench::PrintRow("copy+destroy SharedPtr", threads, ns / kIters);
+
+    auto sharded = tiny_std::make_sharded_shared<Config>();
+    ns = bench::RunThreads(threads, [&](unsigned) {
+        for (int i = 0; i < kIters; ++i) {
+            tiny_std::sharded_shared_ptr<Config> copy = sharded;
+            bench::DoNotOptimize(copy.get());
+        }
+    });
+    bench::PrintRow("copy+destroy sharded_shared_ptr", threads, ns / kIters);
+}
+
+}  // namespace
+
+int main() {
+    for (unsigned threads = 1; threads <= bench::MaxThreads(); threads *= 2) BenchCopy(threads);
+    return 0;
+}
@@ -0,0 +1,68 @@
+/**
+ * @file bench_shared_fanout.cpp
+ * @author whoami (13003827890@163.com)
+ * @brief Fanning one SharedPtr out to N queues: N copies vs share_n
+ * @version 0.1
+ * @date 2026-10-15
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Every thread publishes the same message to N queues and then drains them,
+ * as a dispatcher does. The plain version copies the pointer N times and
+ * drops the copies one by one: 2N atomic updates of the shared use count.
+ * share_n() and release_batch() do one update each, so the cost per message
+ * stays flat as N grows, and the cache line of the count moves between
+ * threads twice per message instead of 2N times.
+ */
+
+#include <cstdio>
+#include <iterator>
+#include <vector>
+
+#include "bench_util.h"
+#include "smart_ptr/shared_ptr.h"
+
+namespace {
+
+constexpr int kMessages = 200000;
+
+struct Message {
+    long payload = 1;
+};
+
+using MessagePtr = tiny_std::SharedPtr<Message>;
+
+void BenchFanout(const char* name, unsigned threads, std::size_t width, bool batched) {
+    MessagePtr message(new Message);
+    double ns = bench::RunThreads(threads, [&](unsigned) {
+        std::vector<MessagePtr> queues;
+        queues.reserve(width);
+        for (int i = 0; i < kMessages; ++i) {
+            if (batched) {
+                message.share_n(width, std::back_inserter(queues));
+                bench::DoNotOptimize(queues.back());
+                tiny_std::release_batch(queues.begin(), queues.end());
+            } else {
+                for (std::size_t q = 0; q < width; ++q) queues.push_back(message);
+                bench::DoNotOptimize(queues.back());
+                for (auto& q : queues) q.reset();
+            }
+            queues.clear();
+        }
+    });
+    char label[64];
+    std::snprintf(label, sizeof(label), "%s N=%zu", name, width);
+    bench::PrintRow(label, threads, ns / kMessages);
+}
+
+}  // namespace
+
+int main() {
+    for (unsigned threads = 1; threads <= bench::MaxThreads(); threads *= 2) {
+        for (std::size_t width : {4, 16, 64}) {
+            BenchFanout("copy + reset", threads, width, false);
+            BenchFanout("share_n + release_batch", threads, width, true);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,70 @@
+/**
+ * @file bench_util.h
+ * @author whoami (13003827890@163.com)
+ * @brief helpers shared by the micro benchmarks
+ * @version 0.1
+ * @date 2026-10-15
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace bench {
+
+// Keep the optimizer from discarding a value.
+template <typename Tp>
+inline void DoNotOptimize(const Tp& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Run fn(thread_index) on `threads` threads released at the same time and
+// return the wall time in nanoseconds.
+template <typename Fn>
+inline double RunThreads(unsigned threads, Fn fn) {
+    std::atomic<unsigned> ready{0};
+    std::atomic<bool> go{false};
+    std::vector<std::thread> pool;
+    pool.reserve(threads);
+    for (unsigned i = 0; i < threads; ++i) {
+        pool.emplace_back([&, i] {
+            ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire)) {
+            }
+            fn(i);
+        });
+    }
+    while (ready.load() != threads) {
+    }
+    auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& t : pool) t.join();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(stop - start).count();
+}
+
+template <typename Fn>
+inline double RunOnce(Fn fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(stop - start).count();
+}
+
+inline unsigned MaxThreads() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : n;
+}
+
+inline void PrintRow(const char* name, unsigned threads, double ns_per_op) {
+    std::printf("%-40s threads=%-3u %10.2f ns/op\n", name, threads, ns_per_op);
+}
+
+}  // namespace bench
@@ -0,0 +1,73 @@
+/**
+ * @file bench_weak_upgrade.cpp
+ * @author whoami (13003827890@163.com)
+ * @brief WeakPtr::Lock throughput while the objects expire
+ * @version 0.1
+ * @date 2026-10-15
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Every thread upgrades the same set of weak references over and over, the
+ * way cache hits do. With expiry on, thread 0 also drops the owners a slice
+ * per pass, so that by the end of the run every object is gone and the
+ * upgrades race with the last releases. A failed upgrade of an expired
+ * object is a single load; a successful one is a CAS that can lose to other
+ * upgraders and has to retry. BIASED is left out: releases on a thread that
+ * does not own the block only expire it once the owner collects.
+ */
+
+#include <cstdio>
+#include <vector>
+
+#include "bench_util.h"
+#include "smart_ptr/shared_ptr.h"
+
+namespace {
+
+constexpr int kObjects = 1024;
+constexpr int kPasses = 2000;
+
+struct Payload {
+    long value = 1;
+};
+
+template <tiny_std::LockPolicy Lp>
+void BenchUpgrade(const char* name, unsigned threads, bool expire) {
+    std::vector<tiny_std::SharedPtr<Payload, Lp>> owners;
+    for (int i = 0; i < kObjects; ++i) owners.push_back(tiny_std::SharedPtr<Payload, Lp>(new Payload));
+    std::vector<std::vector<tiny_std::WeakPtr<Payload, Lp>>> weak(threads);
+    for (auto& w : weak) w.assign(owners.begin(), owners.end());
+
+    std::vector<long> hits(threads);
+    double ns = bench::RunThreads(threads, [&](unsigned t) {
+        long hit = 0;
+        for (int pass = 0; pass < kPasses; ++pass) {
+            if (expire && t == 0) {
+                for (int i = pass * kObjects / kPasses; i < (pass + 1) * kObjects / kPasses; ++i) owners[i].reset();
+            }
+            for (const auto& w : weak[t]) {
+                if (auto p = w.Lock())
+                    hit += p->value;
+            }
+        }
+        hits[t] = hit;
+    });
+
+    long total = 0;
+    for (long h : hits) total += h;
+    const double attempts = double(kObjects) * kPasses;
+    char label[64];
+    std::snprintf(label, sizeof(label), "%s hit=%.0f%%", name, 100.0 * total / (attempts * threads));
+    bench::PrintRow(label, threads, ns / attempts);
+}
+
+}  // namespace
+
+int main() {
+    for (unsigned threads = 1; threads <= bench::MaxThreads(); threads *= 2) {
+        BenchUpgrade<tiny_std::ATOMIC>("Lock live ATOMIC", threads, false);
+        BenchUpgrade<tiny_std::ATOMIC>("Lock expiring ATOMIC", threads, true);
+        BenchUpgrade<tiny_std::MUTEX>("Lock expiring MUTEX", threads, true);
+    }
+    return 0;
+}
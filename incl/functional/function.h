@@ -9,15 +9,23 @@
  *
  */
 
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <new>
 #include <type_traits>
+#include <typeinfo>
+#include <utility>
 
 namespace tiny_std {
 
 /**
  *  Trait identifying "location-invariant" types, meaning that the
- *  address of the object (or any of its members) will not escape.
- *  Trivially copyable types are location-invariant and users can
- *  specialize this trait for other types.
+ *  address of the object (or any of its members) will not escape, so
+ *  the object can be relocated with memcpy. Trivially copyable types are
+ *  location-invariant and users can specialize this trait for other types.
  */
 template <typename Tp>
 struct IsLocationInvariant : std::is_trivially_copyable<Tp>::type {};
@@ -31,7 +39,12 @@ union NocopyTypes {
     void (UndefinedClass::*member_pointer_)();
 };
 
-union AnyData {
+/**
+ *  Small buffer of a function wrapper: Len bytes aligned to Align, and never
+ *  smaller than NocopyTypes, since the manager returns pointers through it.
+ */
+template <std::size_t Len, std::size_t Align = alignof(NocopyTypes)>
+union AnyStorage {
     void* Access() noexcept {
         return &pod_data_[0];
     }
@@ -51,180 +64,296 @@ union AnyData {
     }
 
     NocopyTypes unused_;
-    char pod_data_[sizeof(NocopyTypes)];
+    alignas(Align) char pod_data_[Len];
 };
 
-enum ManagerOperation {
-    GET_TYPE_INFO,
-    GET_FUNCTOR_PTR,
-    CLONE_FUNCTOR,
-    DESTROY_FUNCTOR
-};
+// TINY_STD_FUNCTION_SBO_SIZE sets the bytes of function's small buffer;
+// the default is sizeof(NocopyTypes), enough for two pointers.
+#ifdef TINY_STD_FUNCTION_SBO_SIZE
+using AnyData = AnyStorage<(TINY_STD_FUNCTION_SBO_SIZE > sizeof(NocopyTypes) ? TINY_STD_FUNCTION_SBO_SIZE
+                                                                               : sizeof(NocopyTypes))>;
+#else
+using AnyData = AnyStorage<sizeof(NocopyTypes)>;
+#endif
 
 template <typename Signature>
 class function;
 
+/**
+ *  What a function wrapper does with its target, as one constant table per
+ *  target type and signature: the wrapper keeps a single pointer to it next
+ *  to its small buffer Storage. A null clone_ or move_ stands for a copy of
+ *  the Storage, a null destroy_ for nothing to do, so the common cases cost
+ *  no indirect call.
+ */
+template <typename Storage, typename Res, typename... ArgTypes>
+struct FunctionOps {
+    using InvokerType = Res (*)(const Storage&, ArgTypes&&...);
+    using CloneType = void (*)(Storage&, const Storage&);
+    using MoveType = void (*)(Storage&, Storage&);
+    using DestroyType = void (*)(Storage&) noexcept;
+    using TargetType = const void* (*)(const Storage&) noexcept;
+
+    void Clone(Storage& dest, const Storage& source) const {
+        if (clone_)
+            clone_(dest, source);
+        else
+            dest = source;
+    }
+
+    // Relocate the target from source to dest and end it in source. Only
+    // inplace_function stores targets whose move may throw.
+    void Move(Storage& dest, Storage& source) const {
+        if (move_)
+            move_(dest, source);
+        else
+            dest = source;
+    }
+
+    void Destroy(Storage& victim) const noexcept {
+        if (destroy_)
+            destroy_(victim);
+    }
+
+    InvokerType invoke_;
+    CloneType clone_;
+    MoveType move_;
+    DestroyType destroy_;
+    TargetType target_;
+    const std::type_info* type_;
+};
+
+/**
+ *  Creates, copies, moves and destroys a Functor in the small buffer Storage
+ *  of a function wrapper, or on the heap. A Functor is stored in the buffer
+ *  when it fits and moving it cannot throw, since moving the wrapper must
+ *  not throw; location-invariant ones are moved by copying the buffer, the
+ *  others by Move. With Inplace, the target is always stored in the buffer;
+ *  the wrapper checks that it fits.
+ */
+template <typename Functor, typename Storage, bool Inplace = false>
+class FunctionManager {
+public:
+    using StorageType = Storage;
+
+protected:
+    static const bool stored_locally_ =
+        Inplace || ((IsLocationInvariant<Functor>::value || std::is_nothrow_move_constructible<Functor>::value) &&
+                    sizeof(Functor) <= sizeof(Storage) &&
+                    alignof(Functor) <= alignof(Storage) && (alignof(Storage) % alignof(Functor) == 0));
+
+    using LocalStorage = std::integral_constant<bool, stored_locally_>;
+
+    // Whether Clone and Move are plain copies of the Storage, and Destroy
+    // does nothing.
+    static const bool bitwise_copy_ = stored_locally_ && std::is_trivially_copyable<Functor>::value;
+    static const bool bitwise_move_ = !stored_locally_ || IsLocationInvariant<Functor>::value;
+    static const bool trivial_destroy_ = stored_locally_ && std::is_trivially_destructible<Functor>::value;
+
+    // Retrieve a pointer to the function object
+    static Functor* GetPointer(const Storage& source) noexcept {
+        if constexpr (stored_locally_) {
+            const Functor& f = source.template Access<Functor>();
+            return const_cast<Functor*>(std::__addressof(f));
+        } else  // have stored a pointer
+            return source.template Access<Functor*>();
+    }
+
+private:
+    // Construct a function object that fits within the Storage.
+    template <typename Fn>
+    static void Create(Storage& dest, Fn&& f, std::true_type) {
+        ::new (dest.Access()) Functor(std::forward<Fn>(f));
+    }
+
+    // Construct a function object on the heap and store a pointer.
+    template <typename Fn>
+    static void Create(Storage& dest, Fn&& f, std::false_type) {
+        dest.template Access<Functor*>() = new Functor(std::forward<Fn>(f));
+    }
+
+    // Destroy an object stored in the internal buffer.
+    static void Destroy(Storage& victim, std::true_type) noexcept {
+        victim.template Access<Functor>().~Functor();
+    }
+
+    // Destroy an object located on the heap.
+    static void Destroy(Storage& victim, std::false_type) noexcept {
+        delete victim.template Access<Functor*>();
+    }
+
+public:
+    static void Clone(Storage& dest, const Storage& source) {
+        InitFunctor(dest, *const_cast<const Functor*>(GetPointer(source)));
+    }
+
+    static void Move(Storage& dest, Storage& source) noexcept(
+        bitwise_move_ || std::is_nothrow_move_constructible<Functor>::value) {
+        if constexpr (bitwise_move_) {
+            dest = source;
+        } else {
+            Functor& f = *GetPointer(source);
+            ::new (dest.Access()) Functor(std::move(f));
+            f.~Functor();
+        }
+    }
+
+    static void Destroy(Storage& victim) noexcept {
+        Destroy(victim, LocalStorage());
+    }
+
+    template <typename Fn>
+    static void InitFunctor(Storage& functor, Fn&& f) noexcept(
+        std::__and_<LocalStorage, std::is_nothrow_constructible<Functor, Fn>>::value) {
+        Create(functor, std::forward<Fn>(f), LocalStorage());
+    }
+
+    template <typename Signature>
+    static bool NotEmptyFunction(const function<Signature>& f) noexcept {
+        return static_cast<bool>(f);
+    }
+
+    template <typename Tp>
+    static bool NotEmptyFunction(Tp* fp) noexcept {
+        return fp != nullptr;
+    }
+
+    template <typename Class, typename Tp>
+    static bool NotEmptyFunction(Tp Class::* mp) noexcept {
+        return mp != nullptr;
+    }
+
+    template <typename Tp>
+    static bool NotEmptyFunction(const Tp&) noexcept {
+        return true;
+    }
+};
+
 /// Base class of all polymorphic function object wrappers.
 class FunctionBase {
 public:
-    static const size_t max_size_ = sizeof(NocopyTypes);
-    static const size_t max_align_ = __alignof__(NocopyTypes);
+    static const size_t max_size_ = sizeof(AnyData);
+    static const size_t max_align_ = __alignof__(AnyData);
 
     template <typename Functor>
-    class BaseManager {
-    protected:
-        static const bool stored_locally_ =
-            (IsLocationInvariant<Functor>::value && sizeof(Functor) <= max_size_ &&
-             __alignof__(Functor) <= max_align_ && (max_align_ % __alignof__(Functor) == 0));
+    using BaseManager = FunctionManager<Functor, AnyData>;
 
-        using LocalStorage = std::integral_constant<bool, stored_locally_>;
+    /**
+     *  Manager for targets constructed with an allocator. A target that fits
+     *  in AnyData is stored there as usual; otherwise it is placed, together
+     *  with a copy of the allocator, in memory from that allocator. Copies
+     *  of the %function allocate from the same allocator.
+     */
+    template <typename Functor, typename Alloc>
+    class AllocManager : public BaseManager<Functor> {
+        using Base = BaseManager<Functor>;
+
+        struct Box {
+            template <typename Fn>
+            Box(const Alloc& a, Fn&& f) : alloc_(a), functor_(std::forward<Fn>(f)) {}
+
+            Alloc alloc_;
+            Functor functor_;
+        };
+
+        using BoxAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Box>;
+        using BoxAllocTraits = std::allocator_traits<BoxAlloc>;
+
+    protected:
+        using typename Base::LocalStorage;
 
-        // Retrieve a pointer to the function object
         static Functor* GetPointer(const AnyData& source) noexcept {
-            if constexpr (stored_locally_) {
-                const Functor& f = source.Access<Functor>();
-                return const_cast<Functor*>(std::__addressof(f));
-            } else  // have stored a pointer
-                return source.Access<Functor*>();
+            if constexpr (Base::stored_locally_)
+                return Base::GetPointer(source);
+            else
+                return &source.Access<Box*>()->functor_;
         }
 
     private:
-        // Construct a location-invariant function object that fits within
-        // an AnyData structure.
         template <typename Fn>
-        static void Create(AnyData& dest, Fn&& f, std::true_type) {
+        static void Create(AnyData& dest, const Alloc&, Fn&& f, std::true_type) {
             ::new (dest.Access()) Functor(std::forward<Fn>(f));
         }
 
-        // Construct a function object on the heap and store a pointer.
         template <typename Fn>
-        static void Create(AnyData& dest, Fn&& f, std::false_type) {
-            dest.Access<Functor*>() = new Functor(std::forward<Fn>(f));
+        static void Create(AnyData& dest, const Alloc& a, Fn&& f, std::false_type) {
+            BoxAlloc box_alloc(a);
+            Box* box = BoxAllocTraits::allocate(box_alloc, 1);
+            try {
+                ::new (static_cast<void*>(box)) Box(a, std::forward<Fn>(f));
+            } catch (...) {
+                BoxAllocTraits::deallocate(box_alloc, box, 1);
+                throw;
+            }
+            dest.Access<Box*>() = box;
         }
 
-        // Destroy an object stored in the internal buffer.
-        static void Destroy(AnyData& victim, std::true_type) {
+        static void Destroy(AnyData& victim, std::true_type) noexcept {
             victim.Access<Functor>().~Functor();
         }
 
-        // Destroy an object located on the heap.
-        static void Destroy(AnyData& victim, std::false_type) {
-            delete victim.Access<Functor*>();
+        static void Destroy(AnyData& victim, std::false_type) noexcept {
+            Box* box = victim.Access<Box*>();
+            BoxAlloc box_alloc(box->alloc_);
+            box->~Box();
+            BoxAllocTraits::deallocate(box_alloc, box, 1);
         }
 
     public:
-        static bool Manager(AnyData& dest, const AnyData& source, ManagerOperation op) {
-            switch (op) {
-                case GET_TYPE_INFO:
-                    dest.Access<const std::type_info*>() = &typeid(Functor);
-                    break;
-                case GET_FUNCTOR_PTR:
-                    dest.Access<Functor*>() = GetPointer(source);
-                    break;
-                case CLONE_FUNCTOR:
-                    InitFunctor(dest, *const_cast<const Functor*>(GetPointer(source)));
-                    break;
-                case DESTROY_FUNCTOR:
-                    Destroy(dest, LocalStorage());
-                    break;
+        // A boxed target is moved with the pointer to its box, as in Base.
+        static void Clone(AnyData& dest, const AnyData& source) {
+            if constexpr (Base::stored_locally_) {
+                Base::Clone(dest, source);
+            } else {
+                const Box* box = source.Access<Box*>();
+                Create(dest, box->alloc_, box->functor_, LocalStorage());
             }
-            return false;
-        }
-
-        template <typename Fn>
-        static void InitFunctor(AnyData& functor, Fn&& f) noexcept(
-            std::__and_<LocalStorage, std::is_nothrow_constructible<Functor, Fn>>::value) {
-            Create(functor, std::forward<Fn>(f), LocalStorage());
         }
 
-        template <typename Signature>
-        static bool NotEmptyFunction(const function<Signature>& f) noexcept {
-            return static_cast<bool>(f);
+        static void Destroy(AnyData& victim) noexcept {
+            Destroy(victim, LocalStorage());
         }
 
-        template <typename Tp>
-        static bool NotEmptyFunction(Tp* fp) noexcept {
-            return fp != nullptr;
-        }
-
-        template <typename Class, typename Tp>
-        static bool NotEmptyFunction(Tp Class::* mp) noexcept {
-            return mp != nullptr;
-        }
-
-        template <typename Tp>
-        static bool NotEmptyFunction(const Tp&) noexcept {
-            return true;
+        template <typename Fn>
+        static void InitFunctor(AnyData& functor, const Alloc& a, Fn&& f) {
+            Create(functor, a, std::forward<Fn>(f), LocalStorage());
         }
     };
-
-    FunctionBase() = default;
-
-    ~FunctionBase() {
-        if (manager_)
-            manager_(functor_, functor_, DESTROY_FUNCTOR);
-    }
-
-    bool Empty() const {
-        return !manager_;
-    }
-
-    using ManagerType = bool (*)(AnyData&, const AnyData&, ManagerOperation);
-
-    AnyData functor_{};
-    ManagerType manager_{};
 };
 
-template <typename Signature, typename Functor>
+template <typename Signature, typename Functor, typename Base = FunctionBase::BaseManager<Functor>>
 class FunctionHandler;
 
-template <typename Res, typename Functor, typename... ArgTypes>
-class FunctionHandler<Res(ArgTypes...), Functor> : public FunctionBase::BaseManager<Functor> {
-    using Base = FunctionBase::BaseManager<Functor>;
+template <typename Res, typename Functor, typename Base, typename... ArgTypes>
+class FunctionHandler<Res(ArgTypes...), Functor, Base> : public Base {
+    using Storage = typename Base::StorageType;
 
 public:
-    static bool Manager(AnyData& dest, const AnyData& source, ManagerOperation op) {
-        switch (op) {
-            case GET_TYPE_INFO:
-                dest.Access<const std::type_info*>() = &typeid(Functor);
-                break;
-            case GET_FUNCTOR_PTR:
-                dest.Access<Functor*>() = Base::GetPointer(source);
-                break;
-            default:
-                Base::Manager(dest, source, op);
-        }
-        return false;
+    static Res Invoke(const Storage& functor, ArgTypes&&... args) {
+        return std::__invoke_r<Res>(*Base::GetPointer(functor), std::forward<ArgTypes>(args)...);
     }
 
-    static Res Invoke(const AnyData& functor, ArgTypes&&... args) {
-        return std::__invoke_r<Res>(*Base::GetPointer(functor), std::forward<ArgTypes>(args)...);
+    static const void* Target(const Storage& source) noexcept {
+        return Base::GetPointer(source);
     }
 
     template <typename Fn>
-    static constexpr bool NoThrowInit() noexcept {
+    static constexpr bool NothrowInit() noexcept {
         return std::__and_<typename Base::LocalStorage, std::is_nothrow_constructible<Functor, Fn>>::value;
     }
-};
 
-// Specialization for invalid types
-template <>
-class FunctionHandler<void, void> {
-public:
-    static bool Manager(AnyData&, const AnyData&, ManagerOperation) {
-        return false;
-    }
-};
+    using Ops = FunctionOps<Storage, Res, ArgTypes...>;
 
-// Avoids instantiating ill-formed specializations of _Function_handler
-// in std::function<Signature>::target<Functor>().
-// e.g. _Function_handler<Sig, void()> and _Function_handler<Sig, void>
-// would be ill-formed.
-template <typename Signature, typename Functor, bool valid = std::is_object<Functor>::value>
-struct TargetHandler : FunctionHandler<Signature, typename std::remove_cv<Functor>::type> {};
-
-template <typename Signature, typename Functor>
-struct TargetHandler<Signature, Functor, false> : FunctionHandler<void, void> {};
+    // The table every wrapper targeting a Functor points to.
+    static constexpr Ops ops_ = {
+        &Invoke,
+        Base::bitwise_copy_ ? nullptr : &Base::Clone,
+        Base::bitwise_move_ ? nullptr : &Base::Move,
+        Base::trivial_destroy_ ? nullptr : static_cast<typename Ops::DestroyType>(&Base::Destroy),
+        &Target,
+        &typeid(Functor),
+    };
+};
 
 /**
  *  @brief Polymorphic function wrapper.
@@ -236,10 +365,10 @@ class function<Res(ArgTypes...)> : private FunctionBase {
     // Equivalent to std::decay_t except that it produces an invalid type
     // if the decayed type is the current specialization of std::function.
     template <typename Func, bool Self = std::is_same<std::__remove_cvref_t<Func>, function>::value>
-    using Decay = typename std::enable_if<!Self, std::decay<Func>>::type;
+    using Decay = typename std::enable_if<!Self, std::decay_t<Func>>::type;
 
-    template <typename Func, typename DFunc = Decay<Func>, typename Res2 = std::invoke_result<DFunc&, ArgTypes...>>
-    struct Callable : std::is_invocable<Res2, Res>::type {};
+    template <typename Func, typename DFunc = Decay<Func>>
+    struct Callable : std::is_invocable_r<Res, DFunc&, ArgTypes...>::type {};
 
     template <typename Cond, typename Tp = void>
     using Requires = std::__enable_if_t<Cond::value, Tp>;
@@ -247,6 +376,8 @@ class function<Res(ArgTypes...)> : private FunctionBase {
     template <typename Functor>
     using Handler = FunctionHandler<Res(ArgTypes...), std::__decay_t<Functor>>;
 
+    using Ops = FunctionOps<AnyData, Res, ArgTypes...>;
+
 public:
     using result_type = Res;
 
@@ -274,9 +405,8 @@ public:
      */
     function(const function& x) : FunctionBase() {
         if (static_cast<bool>(x)) {
-            x.Manager(functor_, x.functor_, CLONE_FUNCTOR);
-            invoker_ = x.invoker_;
-            manager_ = x.manager_;
+            x.ops_->Clone(functor_, x.functor_);
+            ops_ = x.ops_;
         }
     }
 
@@ -287,12 +417,10 @@ public:
      *  The newly-created %function contains the target of `x`
      *  (if it has one).
      */
-    function(function&& x) noexcept : FunctionBase(), invoker_(x.invoker_) {
+    function(function&& x) noexcept : FunctionBase(), ops_(x.ops_) {
         if (static_cast<bool>(x)) {
-            functor_ = x.functor_;
-            manager_ = x.manager_;
-            x.manager_ = nullptr;
-            x.invoker_ = nullptr;
+            ops_->Move(functor_, x.functor_);
+            x.ops_ = nullptr;
         }
     }
 
@@ -323,11 +451,40 @@ public:
 
         if (MyHandler::NotEmptyFunction(f)) {
             MyHandler::InitFunctor(functor_, std::forward<Functor>(f));
-            invoker_ = &MyHandler::invoke_;
-            manager_ = &MyHandler::manager_;
+            ops_ = &MyHandler::ops_;
+        }
+    }
+
+    /**
+     *  @brief Builds a %function that targets a copy of @a f, allocated
+     *  from @a a if it does not fit in the small buffer.
+     *  @param a An allocator, e.g. a pmr::polymorphic_allocator.
+     *  @param f A %function object callable like the plain constructor's.
+     *
+     *  Copies of the %function allocate from (a copy of) the same
+     *  allocator, so its memory must outlive all of them.
+     */
+    template <typename Alloc, typename Functor, typename Constraints = Requires<Callable<Functor>>>
+    function(std::allocator_arg_t, const Alloc& a, Functor&& f) : FunctionBase() {
+        static_assert(std::is_copy_constructible<std::__decay_t<Functor>>::value,
+                      "std::function target must be copy-constructible");
+        static_assert(std::is_constructible<std::__decay_t<Functor>, Functor>::value,
+                      "std::function target must be constructible from the constructor argument");
+
+        using MyHandler = FunctionHandler<Res(ArgTypes...), std::__decay_t<Functor>,
+                                          FunctionBase::AllocManager<std::__decay_t<Functor>, Alloc>>;
+
+        if (MyHandler::NotEmptyFunction(f)) {
+            MyHandler::InitFunctor(functor_, a, std::forward<Functor>(f));
+            ops_ = &MyHandler::ops_;
         }
     }
 
+    ~function() {
+        if (ops_)
+            ops_->Destroy(functor_);
+    }
+
     /**
      *  @brief Function assignment operator.
      *  @param x A %function with identical call signature.
@@ -369,10 +526,9 @@ public:
      *  The target of `*this` is deallocated, leaving it empty.
      */
     function& operator=(nullptr_t) noexcept {
-        if (manager_) {
-            manager_(functor_, functor_, DESTROY_FUNCTOR);
-            manager_ = nullptr;
-            invoker_ = nullptr;
+        if (ops_) {
+            ops_->Destroy(functor_);
+            ops_ = nullptr;
         }
         return *this;
     }
@@ -418,9 +574,14 @@ public:
      *  This function will not throw exceptions.
      */
     void swap(function& x) noexcept {
-        std::swap(functor_, x.functor_);
-        std::swap(manager_, x.manager_);
-        std::swap(invoker_, x.invoker_);
+        AnyData tmp;
+        if (ops_)
+            ops_->Move(tmp, functor_);
+        if (x.ops_)
+            x.ops_->Move(functor_, x.functor_);
+        if (ops_)
+            ops_->Move(x.functor_, tmp);
+        std::swap(ops_, x.ops_);
     }
 
     // [3.7.2.3] function capacity
@@ -434,7 +595,7 @@ public:
      *  This function will not throw exceptions.
      */
     explicit operator bool() const noexcept {
-        return !Empty();
+        return ops_ != nullptr;
     }
 
     // [3.7.2.4] function invocation
@@ -447,7 +608,7 @@ public:
      *  stored by `this`.
      */
     Res operator()(ArgTypes... args) const {
-        return invoker_(functor_, std::forward<ArgTypes>(args)...);
+        return ops_->invoke_(functor_, std::forward<ArgTypes>(args)...);
     }
 
     // [3.7.2.5] function target access
@@ -461,13 +622,7 @@ public:
      *  This function will not throw exceptions.
      */
     const std::type_info& target_type() const noexcept {
-        if (manager_) {
-            AnyData typeinfo_result;
-            manager_(typeinfo_result, functor_, GET_TYPE_INFO);
-            if (auto ti = typeinfo_result.Access<const std::type_info*>())
-                return *ti;
-        }
-        return typeid(void);
+        return ops_ ? *ops_->type_ : typeid(void);
     }
 
     /**
@@ -493,23 +648,16 @@ public:
     template <typename Functor>
     const Functor* target() const noexcept {
         if constexpr (std::is_object<Functor>::value) {
-            // For C++11 and C++14 if-constexpr is not used above, so
-            // TargetHandler avoids ill-formed _Function_handler types.
-            using Handler = TargetHandler<Res(ArgTypes...), Functor>;
-
-            if (manager_ == &Handler::manager_ || (manager_ && typeid(Functor) == target_type())) {
-                AnyData ptr;
-                manager_(ptr, functor_, GET_FUNCTOR_PTR);
-                return ptr.Access<const Functor*>();
-            }
+            if (ops_ && *ops_->type_ == typeid(Functor))
+                return static_cast<const Functor*>(ops_->target_(functor_));
         }
         return nullptr;
     }
     /// @}
 
 private:
-    using InvokerType = Res (*)(const AnyData&, ArgTypes&&...);
-    InvokerType invoker_ = nullptr;
+    AnyData functor_{};
+    const Ops* ops_ = nullptr;
 };
 
 template <typename>
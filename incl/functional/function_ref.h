@@ -0,0 +1,106 @@
+/**
+ * @file function_ref.h
+ * @author whoami (13003827890@163.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <cassert>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace tiny_std {
+
+template <typename Signature>
+class function_ref;
+
+template <typename Tp>
+struct IsFunctionRef : std::false_type {};
+
+template <typename Signature>
+struct IsFunctionRef<function_ref<Signature>> : std::true_type {};
+
+/**
+ *  @brief A non-owning reference to a callable.
+ *
+ *  Two words: what is bound (the address of a callable object, or a
+ *  function pointer) and a thunk that invokes it. Copying is trivial and
+ *  nothing is ever allocated or destroyed, which makes it the cheap way to
+ *  take a callback that is only called during the call, like a visitor or
+ *  a comparator. The referenced callable must outlive the function_ref,
+ *  so do not bind one to a temporary that it outlives.
+ *
+ *  A noexcept signature only binds nothrow-invocable callables, and its
+ *  call operator is noexcept.
+ */
+template <typename Res, typename... ArgTypes, bool Nx>
+class function_ref<Res(ArgTypes...) noexcept(Nx)> {
+    union Bound {
+        void* object_;
+        void (*function_)();
+    };
+
+    template <typename Func>
+    using Callable = typename std::conditional<Nx, std::is_nothrow_invocable_r<Res, Func, ArgTypes...>,
+                                               std::is_invocable_r<Res, Func, ArgTypes...>>::type;
+
+    template <typename Func, typename Tp = std::remove_reference_t<Func>>
+    using RequiresObject = std::__enable_if_t<!IsFunctionRef<std::remove_cv_t<Tp>>::value &&
+                                              !std::is_function<Tp>::value && !std::is_pointer<Tp>::value &&
+                                              Callable<Tp&>::value>;
+
+public:
+    using result_type = Res;
+
+    // Binds a function; @a f must not be null.
+    template <typename Fn, typename = std::__enable_if_t<std::is_function<Fn>::value && Callable<Fn*>::value>>
+    function_ref(Fn* f) noexcept : thunk_(&FunctionThunk<Fn>) {
+        assert(f != nullptr);
+        bound_.function_ = reinterpret_cast<void (*)()>(f);
+    }
+
+    // Binds a callable object, which is invoked as an lvalue.
+    template <typename Func, typename = RequiresObject<Func>>
+    function_ref(Func&& f) noexcept : thunk_(&ObjectThunk<std::remove_reference_t<Func>>) {
+        bound_.object_ = const_cast<void*>(static_cast<const volatile void*>(std::addressof(f)));
+    }
+
+    function_ref(const function_ref&) noexcept = default;
+    function_ref& operator=(const function_ref&) noexcept = default;
+
+    Res operator()(ArgTypes... args) const noexcept(Nx) {
+        return thunk_(bound_, std::forward<ArgTypes>(args)...);
+    }
+
+private:
+    template <typename Tp>
+    static Res ObjectThunk(Bound bound, ArgTypes&&... args) noexcept(Nx) {
+        return std::__invoke_r<Res>(*static_cast<Tp*>(bound.object_), std::forward<ArgTypes>(args)...);
+    }
+
+    template <typename Fn>
+    static Res FunctionThunk(Bound bound, ArgTypes&&... args) noexcept(Nx) {
+        return std::__invoke_r<Res>(reinterpret_cast<Fn*>(bound.function_), std::forward<ArgTypes>(args)...);
+    }
+
+    using ThunkType = Res (*)(Bound, ArgTypes&&...) noexcept(Nx);
+
+    Bound bound_;
+    ThunkType thunk_;
+};
+
+template <typename Res, typename... ArgTypes>
+function_ref(Res (*)(ArgTypes...)) -> function_ref<Res(ArgTypes...)>;
+
+template <typename Res, typename... ArgTypes>
+function_ref(Res (*)(ArgTypes...) noexcept) -> function_ref<Res(ArgTypes...) noexcept>;
+
+}  // namespace tiny_std
@@ -0,0 +1,223 @@
+/**
+ * @file inplace_function.h
+ * @author whoami (13003827890@163.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+
+#include "functional/function.h"
+
+namespace tiny_std {
+
+// Default capacity of inplace_function: room for four pointers.
+inline constexpr std::size_t INPLACE_FUNCTION_CAPACITY = 4 * sizeof(void*);
+
+template <typename Signature, std::size_t Capacity = INPLACE_FUNCTION_CAPACITY,
+          std::size_t Align = alignof(std::max_align_t)>
+class inplace_function;
+
+/**
+ *  @brief Polymorphic function wrapper that never allocates.
+ *
+ *  Like function, but every target lives in a buffer of Capacity bytes
+ *  aligned to Align inside the wrapper, whether or not it is trivially
+ *  copyable. A target that does not fit is a compile-time error.
+ *
+ *  Like function, it holds one pointer to the FunctionOps of its target:
+ *  moving a wrapper copies the buffer for location-invariant targets and
+ *  moves and destroys the target otherwise.
+ */
+template <typename Res, typename... ArgTypes, std::size_t Capacity, std::size_t Align>
+class inplace_function<Res(ArgTypes...), Capacity, Align> {
+    using Storage = AnyStorage<Capacity, Align>;
+
+    template <typename Func, bool Self = std::is_same<std::__remove_cvref_t<Func>, inplace_function>::value>
+    using Decay = typename std::enable_if<!Self, std::decay_t<Func>>::type;
+
+    template <typename Func, typename DFunc = Decay<Func>>
+    struct Callable : std::is_invocable_r<Res, DFunc&, ArgTypes...>::type {};
+
+    template <typename Cond, typename Tp = void>
+    using Requires = std::__enable_if_t<Cond::value, Tp>;
+
+    template <typename Functor>
+    using Handler = FunctionHandler<Res(ArgTypes...), std::__decay_t<Functor>,
+                                    FunctionManager<std::__decay_t<Functor>, Storage, true>>;
+
+    using Ops = FunctionOps<Storage, Res, ArgTypes...>;
+
+public:
+    using result_type = Res;
+
+    static constexpr std::size_t capacity = Capacity;
+    static constexpr std::size_t alignment = Align;
+
+    inplace_function() noexcept = default;
+
+    inplace_function(std::nullptr_t) noexcept {}
+
+    inplace_function(const inplace_function& x) {
+        CopyFrom(x);
+    }
+
+    inplace_function(inplace_function&& x) {
+        MoveFrom(x);
+    }
+
+    /**
+     *  @brief Builds an %inplace_function that targets a copy of @a f.
+     *
+     *  Null function pointers, null pointers to members and empty
+     *  %function objects give an empty wrapper.
+     */
+    template <typename Functor, typename Constraints = Requires<Callable<Functor>>>
+    inplace_function(Functor&& f) noexcept(std::is_nothrow_constructible<std::__decay_t<Functor>, Functor>::value) {
+        Init(std::forward<Functor>(f));
+    }
+
+    ~inplace_function() {
+        if (ops_)
+            ops_->Destroy(functor_);
+    }
+
+    // If copying the target throws, *this is left empty.
+    inplace_function& operator=(const inplace_function& x) {
+        if (this != &x) {
+            *this = nullptr;
+            CopyFrom(x);
+        }
+        return *this;
+    }
+
+    inplace_function& operator=(inplace_function&& x) {
+        if (this != &x) {
+            *this = nullptr;
+            MoveFrom(x);
+        }
+        return *this;
+    }
+
+    inplace_function& operator=(std::nullptr_t) noexcept {
+        if (ops_) {
+            ops_->Destroy(functor_);
+            ops_ = nullptr;
+        }
+        return *this;
+    }
+
+    template <typename Functor>
+    Requires<Callable<Functor>, inplace_function&> operator=(Functor&& f) {
+        *this = nullptr;
+        Init(std::forward<Functor>(f));
+        return *this;
+    }
+
+    void swap(inplace_function& x) {
+        inplace_function tmp(std::move(x));
+        x = std::move(*this);
+        *this = std::move(tmp);
+    }
+
+    explicit operator bool() const noexcept {
+        return ops_ != nullptr;
+    }
+
+    Res operator()(ArgTypes... args) const {
+        return ops_->invoke_(functor_, std::forward<ArgTypes>(args)...);
+    }
+
+    const std::type_info& target_type() const noexcept {
+        return ops_ ? *ops_->type_ : typeid(void);
+    }
+
+    template <typename Functor>
+    Functor* target() noexcept {
+        const inplace_function* const_this = this;
+        const Functor* func = const_this->template target<Functor>();
+        return *const_cast<Functor**>(&func);
+    }
+
+    template <typename Functor>
+    const Functor* target() const noexcept {
+        if constexpr (std::is_object<Functor>::value) {
+            if (ops_ && *ops_->type_ == typeid(Functor))
+                return static_cast<const Functor*>(ops_->target_(functor_));
+        }
+        return nullptr;
+    }
+
+private:
+    template <typename Functor>
+    void Init(Functor&& f) {
+        using DFunctor = std::__decay_t<Functor>;
+        static_assert(std::is_copy_constructible<DFunctor>::value,
+                      "inplace_function target must be copy-constructible");
+        static_assert(sizeof(DFunctor) <= sizeof(Storage), "inplace_function target does not fit its capacity");
+        static_assert(alignof(Storage) % alignof(DFunctor) == 0, "inplace_function target is over-aligned");
+
+        using MyHandler = Handler<Functor>;
+
+        if (MyHandler::NotEmptyFunction(f)) {
+            MyHandler::InitFunctor(functor_, std::forward<Functor>(f));
+            ops_ = &MyHandler::ops_;
+        }
+    }
+
+    void CopyFrom(const inplace_function& x) {
+        if (x.ops_) {
+            x.ops_->Clone(functor_, x.functor_);
+            ops_ = x.ops_;
+        }
+    }
+
+    // If moving the target throws, x keeps it.
+    void MoveFrom(inplace_function& x) {
+        if (x.ops_) {
+            x.ops_->Move(functor_, x.functor_);
+            ops_ = x.ops_;
+            x.ops_ = nullptr;
+        }
+    }
+
+    Storage functor_{};
+    const Ops* ops_ = nullptr;
+};
+
+template <typename Res, typename... Args, std::size_t Capacity, std::size_t Align>
+inline bool operator==(const inplace_function<Res(Args...), Capacity, Align>& f, std::nullptr_t) noexcept {
+    return !static_cast<bool>(f);
+}
+
+template <typename Res, typename... Args, std::size_t Capacity, std::size_t Align>
+inline bool operator==(std::nullptr_t, const inplace_function<Res(Args...), Capacity, Align>& f) noexcept {
+    return !static_cast<bool>(f);
+}
+
+template <typename Res, typename... Args, std::size_t Capacity, std::size_t Align>
+inline bool operator!=(const inplace_function<Res(Args...), Capacity, Align>& f, std::nullptr_t) noexcept {
+    return static_cast<bool>(f);
+}
+
+template <typename Res, typename... Args, std::size_t Capacity, std::size_t Align>
+inline bool operator!=(std::nullptr_t, const inplace_function<Res(Args...), Capacity, Align>& f) noexcept {
+    return static_cast<bool>(f);
+}
+
+template <typename Res, typename... Args, std::size_t Capacity, std::size_t Align>
+inline void swap(inplace_function<Res(Args...), Capacity, Align>& x,
+                 inplace_function<Res(Args...), Capacity, Align>& y) {
+    x.swap(y);
+}
+
+}  // namespace tiny_std
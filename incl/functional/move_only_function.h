@@ -0,0 +1,289 @@
+/**
+ * @file move_only_function.h
+ * @author whoami (13003827890@163.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include "functional/function.h"
+
+namespace tiny_std {
+
+template <typename Signature>
+class move_only_function;
+
+/**
+ *  Relocates and destroys a Functor stored in AnyData, locally when it fits
+ *  and is nothrow move constructible, on the heap otherwise. There is no
+ *  clone operation: Manager(&dest, source) moves the target into dest and
+ *  ends it in source, Manager(nullptr, source) destroys it.
+ */
+template <typename Functor>
+class MoveOnlyManager {
+public:
+    static const bool stored_locally_ = std::is_nothrow_move_constructible<Functor>::value &&
+                                        sizeof(Functor) <= sizeof(AnyData) &&
+                                        (alignof(AnyData) % alignof(Functor) == 0);
+
+    static Functor* GetPointer(AnyData& source) noexcept {
+        if constexpr (stored_locally_)
+            return &source.Access<Functor>();
+        else
+            return source.Access<Functor*>();
+    }
+
+    template <typename... Args>
+    static void InitFunctor(AnyData& dest, Args&&... args) {
+        if constexpr (stored_locally_)
+            ::new (dest.Access()) Functor(std::forward<Args>(args)...);
+        else
+            dest.Access<Functor*>() = new Functor(std::forward<Args>(args)...);
+    }
+
+    static void Manager(AnyData* dest, AnyData& source) noexcept {
+        if constexpr (stored_locally_) {
+            Functor& f = source.Access<Functor>();
+            if (dest)
+                ::new (dest->Access()) Functor(std::move(f));
+            f.~Functor();
+        } else {
+            if (dest)
+                dest->Access<Functor*>() = source.Access<Functor*>();
+            else
+                delete source.Access<Functor*>();
+        }
+    }
+};
+
+template <typename Tp>
+struct IsMoveOnlyFunction : std::false_type {};
+
+template <typename Signature>
+struct IsMoveOnlyFunction<move_only_function<Signature>> : std::true_type {};
+
+template <typename Tp>
+struct IsInPlaceType : std::false_type {};
+
+template <typename Tp>
+struct IsInPlaceType<std::in_place_type_t<Tp>> : std::true_type {};
+
+// How a target is invoked under each cv/ref qualification of the signature.
+template <typename Tp>
+using MoveOnlyLvalue = Tp&;
+
+template <typename Tp>
+using MoveOnlyConstLvalue = const Tp&;
+
+template <typename Tp>
+using MoveOnlyRvalue = Tp&&;
+
+template <typename Tp>
+using MoveOnlyConstRvalue = const Tp&&;
+
+/**
+ *  Everything of a move_only_function but its call operator. Derived is
+ *  the move_only_function, InvQuals<F> the type a target F is invoked as.
+ */
+template <typename Derived, typename Res, bool Noex, template <typename> class InvQuals, typename... ArgTypes>
+class MoveOnlyFunctionBase {
+    template <typename Func>
+    using Decay = std::__decay_t<Func>;
+
+    template <typename Func, typename DFunc = Decay<Func>>
+    using Callable =
+        typename std::conditional<Noex, std::is_nothrow_invocable_r<Res, InvQuals<DFunc>, ArgTypes...>,
+                                  std::is_invocable_r<Res, InvQuals<DFunc>, ArgTypes...>>::type;
+
+    template <typename Func>
+    using Requires =
+        std::__enable_if_t<std::conjunction<std::negation<std::is_same<Decay<Func>, Derived>>,
+                                            std::negation<IsInPlaceType<Decay<Func>>>, Callable<Func>>::value>;
+
+public:
+    using result_type = Res;
+
+    MoveOnlyFunctionBase() noexcept = default;
+
+    MoveOnlyFunctionBase(std::nullptr_t) noexcept {}
+
+    MoveOnlyFunctionBase(MoveOnlyFunctionBase&& x) noexcept : manager_(x.manager_), invoker_(x.invoker_) {
+        if (manager_) {
+            manager_(&functor_, x.functor_);
+            x.manager_ = nullptr;
+            x.invoker_ = nullptr;
+        }
+    }
+
+    MoveOnlyFunctionBase(const MoveOnlyFunctionBase&) = delete;
+
+    /**
+     *  @brief Builds a %move_only_function that targets @a f, moved or
+     *  copied in. Null function pointers, null pointers to members and empty
+     *  function wrappers give an empty %move_only_function.
+     */
+    template <typename Functor, typename Constraints = Requires<Functor>>
+    MoveOnlyFunctionBase(Functor&& f) noexcept(MoveOnlyManager<Decay<Functor>>::stored_locally_ &&
+                                               std::is_nothrow_constructible<Decay<Functor>, Functor>::value) {
+        static_assert(std::is_constructible<Decay<Functor>, Functor>::value,
+                      "move_only_function target must be constructible from the constructor argument");
+        if (NotEmptyFunction<Decay<Functor>>(f))
+            Init<Decay<Functor>>(std::forward<Functor>(f));
+    }
+
+    // Builds the target in place from @a args.
+    template <typename Tp, typename... Args>
+    explicit MoveOnlyFunctionBase(std::in_place_type_t<Tp>, Args&&... args) {
+        static_assert(std::is_same<Tp, std::decay_t<Tp>>::value, "target type must be an object type");
+        static_assert(Callable<Tp>::value, "target type must be callable with the signature");
+        Init<Tp>(std::forward<Args>(args)...);
+    }
+
+    ~MoveOnlyFunctionBase() {
+        if (manager_)
+            manager_(nullptr, functor_);
+    }
+
+    MoveOnlyFunctionBase& operator=(MoveOnlyFunctionBase&& x) noexcept {
+        if (this != &x) {
+            *this = nullptr;
+            MoveOnlyFunctionBase tmp(std::move(x));
+            swap(tmp);
+        }
+        return *this;
+    }
+
+    Derived& operator=(std::nullptr_t) noexcept {
+        if (manager_) {
+            manager_(nullptr, functor_);
+            manager_ = nullptr;
+            invoker_ = nullptr;
+        }
+        return static_cast<Derived&>(*this);
+    }
+
+    template <typename Functor, typename Constraints = Requires<Functor>>
+    Derived& operator=(Functor&& f) {
+        Derived(std::forward<Functor>(f)).swap(static_cast<Derived&>(*this));
+        return static_cast<Derived&>(*this);
+    }
+
+    void swap(MoveOnlyFunctionBase& x) noexcept {
+        AnyData tmp;
+        if (manager_)
+            manager_(&tmp, functor_);
+        if (x.manager_)
+            x.manager_(&functor_, x.functor_);
+        if (manager_)
+            manager_(&x.functor_, tmp);
+        std::swap(manager_, x.manager_);
+        std::swap(invoker_, x.invoker_);
+    }
+
+    explicit operator bool() const noexcept {
+        return manager_ != nullptr;
+    }
+
+    friend void swap(Derived& x, Derived& y) noexcept {
+        x.swap(y);
+    }
+
+    friend bool operator==(const Derived& f, std::nullptr_t) noexcept {
+        return !f;
+    }
+
+    friend bool operator==(std::nullptr_t, const Derived& f) noexcept {
+        return !f;
+    }
+
+    friend bool operator!=(const Derived& f, std::nullptr_t) noexcept {
+        return static_cast<bool>(f);
+    }
+
+    friend bool operator!=(std::nullptr_t, const Derived& f) noexcept {
+        return static_cast<bool>(f);
+    }
+
+protected:
+    Res Call(ArgTypes&&... args) const noexcept(Noex) {
+        return invoker_(functor_, std::forward<ArgTypes>(args)...);
+    }
+
+private:
+    template <typename Functor>
+    static Res Invoke(AnyData& functor, ArgTypes&&... args) noexcept(Noex) {
+        return std::__invoke_r<Res>(static_cast<InvQuals<Functor>>(*MoveOnlyManager<Functor>::GetPointer(functor)),
+                                    std::forward<ArgTypes>(args)...);
+    }
+
+    template <typename Functor, typename... Args>
+    void Init(Args&&... args) {
+        MoveOnlyManager<Functor>::InitFunctor(functor_, std::forward<Args>(args)...);
+        manager_ = &MoveOnlyManager<Functor>::Manager;
+        invoker_ = &Invoke<Functor>;
+    }
+
+    template <typename Tp>
+    static bool NotEmptyFunction(const Tp& f) noexcept {
+        if constexpr (IsMoveOnlyFunction<Tp>::value)
+            return static_cast<bool>(f);
+        else
+            return FunctionBase::BaseManager<Tp>::NotEmptyFunction(f);
+    }
+
+    using ManagerType = void (*)(AnyData*, AnyData&) noexcept;
+    using InvokerType = Res (*)(AnyData&, ArgTypes&&...) noexcept(Noex);
+
+    mutable AnyData functor_{};
+    ManagerType manager_ = nullptr;
+    InvokerType invoker_ = nullptr;
+};
+
+/**
+ *  @brief Polymorphic wrapper of a callable that may be move-only.
+ *
+ *  Like function, but the target only has to be move constructible, and
+ *  the signature may carry const, & or && and noexcept: a
+ *  move_only_function<void() const> invokes its target as const, and a
+ *  move_only_function<void() noexcept> only takes nothrow-invocable
+ *  targets. Targets that fit in AnyData and are nothrow move constructible
+ *  are stored inline; moving the wrapper then moves the target.
+ *
+ *  Each qualification gets a partial specialization that only adds the
+ *  matching call operator to MoveOnlyFunctionBase.
+ */
+#define TINY_STD_MOVE_ONLY_FUNCTION(CV_REF, INV_QUALS)                                                              \
+    template <typename Res, typename... ArgTypes, bool Nx>                                                          \
+    class move_only_function<Res(ArgTypes...) CV_REF noexcept(Nx)>                                                 \
+        : public MoveOnlyFunctionBase<move_only_function<Res(ArgTypes...) CV_REF noexcept(Nx)>, Res, Nx, INV_QUALS, \
+                                      ArgTypes...> {                                                                \
+        using Base = MoveOnlyFunctionBase<move_only_function, Res, Nx, INV_QUALS, ArgTypes...>;                     \
+                                                                                                                    \
+    public:                                                                                                         \
+        using Base::Base;                                                                                           \
+        using Base::operator=;                                                                                      \
+                                                                                                                    \
+        Res operator()(ArgTypes... args) CV_REF noexcept(Nx) {                                                      \
+            return Base::Call(std::forward<ArgTypes>(args)...);                                                     \
+        }                                                                                                           \
+    };
+
+TINY_STD_MOVE_ONLY_FUNCTION(, MoveOnlyLvalue)
+TINY_STD_MOVE_ONLY_FUNCTION(const, MoveOnlyConstLvalue)
+TINY_STD_MOVE_ONLY_FUNCTION(&, MoveOnlyLvalue)
+TINY_STD_MOVE_ONLY_FUNCTION(const&, MoveOnlyConstLvalue)
+TINY_STD_MOVE_ONLY_FUNCTION(&&, MoveOnlyRvalue)
+TINY_STD_MOVE_ONLY_FUNCTION(const&&, MoveOnlyConstRvalue)
+
+#undef TINY_STD_MOVE_ONLY_FUNCTION
+
+}  // namespace tiny_std
@@ -0,0 +1,520 @@
+/**
+ * @file memory_resource.h
+ * @author whoami (13003827890@163.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+
+namespace tiny_std {
+namespace pmr {
+
+/**
+ *  @brief Abstract source of raw memory, selected at run time.
+ *
+ *  allocate() and deallocate() forward to the private virtual functions; a
+ *  block must be given back to the resource it came from with the same size
+ *  and alignment.
+ */
+class memory_resource {
+public:
+    virtual ~memory_resource() = default;
+
+    void* allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t)) {
+        return do_allocate(bytes, alignment);
+    }
+
+    void deallocate(void* p, std::size_t bytes, std::size_t alignment = alignof(std::max_align_t)) {
+        do_deallocate(p, bytes, alignment);
+    }
+
+    // Whether memory allocated from one resource can be freed by the other.
+    bool is_equal(const memory_resource& other) const noexcept {
+        return do_is_equal(other);
+    }
+
+private:
+    virtual void* do_allocate(std::size_t bytes, std::size_t alignment) = 0;
+    virtual void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) = 0;
+    virtual bool do_is_equal(const memory_resource& other) const noexcept = 0;
+};
+
+inline bool operator==(const memory_resource& a, const memory_resource& b) noexcept {
+    return &a == &b || a.is_equal(b);
+}
+
+inline bool operator!=(const memory_resource& a, const memory_resource& b) noexcept {
+    return !(a == b);
+}
+
+// Global operator new and delete, honouring over-alignment.
+class NewDeleteResource final : public memory_resource {
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+            return ::operator new(bytes, std::align_val_t(alignment));
+        return ::operator new(bytes);
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+        if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+            ::operator delete(p, bytes, std::align_val_t(alignment));
+        else
+            ::operator delete(p, bytes);
+    }
+
+    bool do_is_equal(const memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+// Throws std::bad_alloc on every allocation.
+class NullMemoryResource final : public memory_resource {
+    void* do_allocate(std::size_t, std::size_t) override {
+        throw std::bad_alloc();
+    }
+
+    void do_deallocate(void*, std::size_t, std::size_t) override {}
+
+    bool do_is_equal(const memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+inline memory_resource* new_delete_resource() noexcept {
+    static NewDeleteResource resource;
+    return &resource;
+}
+
+inline memory_resource* null_memory_resource() noexcept {
+    static NullMemoryResource resource;
+    return &resource;
+}
+
+inline std::atomic<memory_resource*>& DefaultResource() noexcept {
+    static std::atomic<memory_resource*> resource{new_delete_resource()};
+    return resource;
+}
+
+// The resource of default-constructed allocators; new_delete_resource() at start.
+inline memory_resource* get_default_resource() noexcept {
+    return DefaultResource().load(std::memory_order_acquire);
+}
+
+// Replace the default resource (nullptr restores new_delete_resource()) and return the old one.
+inline memory_resource* set_default_resource(memory_resource* r) noexcept {
+    return DefaultResource().exchange(r ? r : new_delete_resource(), std::memory_order_acq_rel);
+}
+
+/**
+ *  @brief An allocator that gets its memory from a memory_resource.
+ *
+ *  All polymorphic_allocator<Tp> have one type whatever the resource, so a
+ *  container, a shared_ptr control block or a function target can be pointed
+ *  at an arena without changing its type. Like std::pmr, a copy keeps the
+ *  resource but assignment is deleted, and containers that copy themselves
+ *  go back to the default resource (select_on_container_copy_construction).
+ */
+template <typename Tp = std::byte>
+class polymorphic_allocator {
+public:
+    using value_type = Tp;
+
+    polymorphic_allocator() noexcept : resource_(get_default_resource()) {}
+
+    polymorphic_allocator(memory_resource* r) noexcept : resource_(r) {}
+
+    polymorphic_allocator(const polymorphic_allocator&) = default;
+
+    template <typename Up>
+    polymorphic_allocator(const polymorphic_allocator<Up>& other) noexcept : resource_(other.resource()) {}
+
+    polymorphic_allocator& operator=(const polymorphic_allocator&) = delete;
+
+    Tp* allocate(std::size_t n) {
+        if (n > std::numeric_limits<std::size_t>::max() / sizeof(Tp))
+            throw std::bad_array_new_length();
+        return static_cast<Tp*>(resource_->allocate(n * sizeof(Tp), alignof(Tp)));
+    }
+
+    void deallocate(Tp* p, std::size_t n) {
+        resource_->deallocate(p, n * sizeof(Tp), alignof(Tp));
+    }
+
+    polymorphic_allocator select_on_container_copy_construction() const noexcept {
+        return polymorphic_allocator();
+    }
+
+    memory_resource* resource() const noexcept {
+        return resource_;
+    }
+
+private:
+    memory_resource* resource_;
+};
+
+template <typename Tp, typename Up>
+inline bool operator==(const polymorphic_allocator<Tp>& a, const polymorphic_allocator<Up>& b) noexcept {
+    return *a.resource() == *b.resource();
+}
+
+template <typename Tp, typename Up>
+inline bool operator!=(const polymorphic_allocator<Tp>& a, const polymorphic_allocator<Up>& b) noexcept {
+    return !(a == b);
+}
+
+/**
+ *  @brief An arena: allocation bumps a pointer, deallocation does nothing
+ *  and release() frees everything at once.
+ *
+ *  Memory comes from an optional initial buffer and then from chunks of the
+ *  upstream resource, each GROWTH times bigger than the last. Not thread safe.
+ */
+class monotonic_buffer_resource : public memory_resource {
+public:
+    static constexpr std::size_t INITIAL_SIZE = 1024;
+    static constexpr std::size_t GROWTH = 2;
+
+    explicit monotonic_buffer_resource(memory_resource* upstream = get_default_resource()) noexcept
+        : upstream_(upstream) {}
+
+    explicit monotonic_buffer_resource(std::size_t initial_size,
+                                       memory_resource* upstream = get_default_resource()) noexcept
+        : upstream_(upstream), next_size_(initial_size ? initial_size : 1) {}
+
+    monotonic_buffer_resource(void* buffer, std::size_t buffer_size,
+                              memory_resource* upstream = get_default_resource()) noexcept
+        : upstream_(upstream),
+          buffer_(buffer),
+          buffer_size_(buffer_size),
+          current_(static_cast<char*>(buffer)),
+          avail_(buffer_size),
+          next_size_(buffer_size > INITIAL_SIZE / GROWTH ? buffer_size * GROWTH : INITIAL_SIZE) {}
+
+    monotonic_buffer_resource(const monotonic_buffer_resource&) = delete;
+    monotonic_buffer_resource& operator=(const monotonic_buffer_resource&) = delete;
+
+    ~monotonic_buffer_resource() override {
+        release();
+    }
+
+    // Free every chunk and start over from the initial buffer.
+    void release() noexcept {
+        while (Chunk* chunk = chunks_) {
+            chunks_ = chunk->prev_;
+            void* base = reinterpret_cast<char*>(chunk) - chunk->size_;
+            upstream_->deallocate(base, chunk->size_ + sizeof(Chunk), chunk->align_);
+        }
+        current_ = static_cast<char*>(buffer_);
+        avail_ = buffer_size_;
+    }
+
+    memory_resource* upstream_resource() const noexcept {
+        return upstream_;
+    }
+
+protected:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        void* p = current_;
+        std::size_t space = avail_;
+        if (!std::align(alignment, bytes, p, space)) {
+            NewChunk(bytes, alignment);
+            p = current_;
+            space = avail_;
+        }
+        current_ = static_cast<char*>(p) + bytes;
+        avail_ = space - bytes;
+        return p;
+    }
+
+    void do_deallocate(void*, std::size_t, std::size_t) override {}
+
+    bool do_is_equal(const memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+private:
+    // Kept at the end of each chunk, so that the data starts at the
+    // alignment the chunk was allocated with.
+    struct Chunk {
+        Chunk* prev_;
+        std::size_t size_;
+        std::size_t align_;
+    };
+
+    void NewChunk(std::size_t bytes, std::size_t alignment) {
+        std::size_t size = next_size_ > bytes ? next_size_ : bytes;
+        size = (size + alignof(Chunk) - 1) & ~(alignof(Chunk) - 1);
+        std::size_t align = alignment > alignof(std::max_align_t) ? alignment : alignof(std::max_align_t);
+        char* base = static_cast<char*>(upstream_->allocate(size + sizeof(Chunk), align));
+        chunks_ = ::new (base + size) Chunk{chunks_, size, align};
+        current_ = base;
+        avail_ = size;
+        if (size <= std::numeric_limits<std::size_t>::max() / GROWTH)
+            next_size_ = size * GROWTH;
+    }
+
+    memory_resource* upstream_;
+    void* buffer_ = nullptr;
+    std::size_t buffer_size_ = 0;
+    char* current_ = nullptr;
+    std::size_t avail_ = 0;
+    std::size_t next_size_ = INITIAL_SIZE;
+    Chunk* chunks_ = nullptr;
+};
+
+// Tuning of the pool resources; a zero field picks the default.
+struct pool_options {
+    // Most blocks a pool takes from upstream at once.
+    std::size_t max_blocks_per_chunk = 0;
+    // Larger requests bypass the pools and go straight upstream.
+    std::size_t largest_required_pool_block = 0;
+};
+
+/**
+ *  @brief Free lists of fixed-size blocks, one per power-of-two size class.
+ *
+ *  A freed block goes back to its pool and is reused by the next request of
+ *  its class; chunks go back upstream only on release() or destruction.
+ *  Requests above largest_required_pool_block, or aligned beyond
+ *  max_align_t, are passed to the upstream resource. Not thread safe.
+ */
+class unsynchronized_pool_resource : public memory_resource {
+public:
+    static constexpr std::size_t MIN_BLOCK = 8;
+    static constexpr std::size_t MAX_BLOCK = std::size_t(1) << 20;
+    static constexpr std::size_t DEFAULT_MAX_BLOCKS = 1024;
+    static constexpr std::size_t DEFAULT_LARGEST_BLOCK = 4096;
+
+    unsynchronized_pool_resource() : unsynchronized_pool_resource(pool_options(), get_default_resource()) {}
+
+    explicit unsynchronized_pool_resource(memory_resource* upstream)
+        : unsynchronized_pool_resource(pool_options(), upstream) {}
+
+    explicit unsynchronized_pool_resource(const pool_options& opts)
+        : unsynchronized_pool_resource(opts, get_default_resource()) {}
+
+    unsynchronized_pool_resource(const pool_options& opts, memory_resource* upstream) : upstream_(upstream) {
+        max_blocks_ = opts.max_blocks_per_chunk ? opts.max_blocks_per_chunk : DEFAULT_MAX_BLOCKS;
+        std::size_t largest = opts.largest_required_pool_block ? opts.largest_required_pool_block
+                                                               : DEFAULT_LARGEST_BLOCK;
+        largest_ = largest < MAX_BLOCK ? RoundUp(largest) : MAX_BLOCK;
+    }
+
+    unsynchronized_pool_resource(const unsynchronized_pool_resource&) = delete;
+    unsynchronized_pool_resource& operator=(const unsynchronized_pool_resource&) = delete;
+
+    ~unsynchronized_pool_resource() override {
+        release();
+    }
+
+    // Give every chunk and every large block back upstream.
+    void release() noexcept {
+        for (std::size_t i = 0; i < POOLS; ++i) {
+            Pool& pool = pools_[i];
+            std::size_t block = MIN_BLOCK << i;
+            while (Chunk* chunk = pool.chunks_) {
+                pool.chunks_ = chunk->next_;
+                void* base = reinterpret_cast<char*>(chunk) - chunk->blocks_ * block;
+                upstream_->deallocate(base, chunk->blocks_ * block + sizeof(Chunk), ChunkAlign(block));
+            }
+            pool = Pool();
+        }
+        while (Large* large = large_) {
+            large_ = large->next_;
+            upstream_->deallocate(LargeBase(large), LargeSize(large->bytes_, large->align_), LargeAlign(large->align_));
+        }
+    }
+
+    memory_resource* upstream_resource() const noexcept {
+        return upstream_;
+    }
+
+    pool_options options() const noexcept {
+        return pool_options{max_blocks_, largest_};
+    }
+
+protected:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        std::size_t block = RoundUp(bytes > alignment ? bytes : alignment);
+        if (block > largest_ || alignment > alignof(std::max_align_t))
+            return AllocateLarge(bytes, alignment);
+        Pool& pool = pools_[IndexOf(block)];
+        if (!pool.free_)
+            Refill(pool, block);
+        FreeBlock* head = pool.free_;
+        pool.free_ = head->next_;
+        return head;
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+        std::size_t block = RoundUp(bytes > alignment ? bytes : alignment);
+        if (block > largest_ || alignment > alignof(std::max_align_t))
+            return DeallocateLarge(p, bytes, alignment);
+        Pool& pool = pools_[IndexOf(block)];
+        pool.free_ = ::new (p) FreeBlock{pool.free_};
+    }
+
+    bool do_is_equal(const memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+private:
+    static constexpr std::size_t POOLS = 18;  // MIN_BLOCK << (POOLS - 1) == MAX_BLOCK
+    static_assert((MIN_BLOCK << (POOLS - 1)) == MAX_BLOCK, "one pool per size class");
+
+    struct FreeBlock {
+        FreeBlock* next_;
+    };
+
+    // Kept after the last block of each chunk.
+    struct Chunk {
+        Chunk* next_;
+        std::size_t blocks_;
+    };
+
+    struct Pool {
+        FreeBlock* free_ = nullptr;
+        Chunk* chunks_ = nullptr;
+        std::size_t next_blocks_ = 1;
+    };
+
+    // Header in front of a block that bypassed the pools.
+    struct Large {
+        Large* prev_;
+        Large* next_;
+        std::size_t bytes_;
+        std::size_t align_;
+    };
+
+    static std::size_t RoundUp(std::size_t n) {
+        std::size_t block = MIN_BLOCK;
+        while (block < n && block < MAX_BLOCK * 2) block <<= 1;
+        return block;
+    }
+
+    static std::size_t IndexOf(std::size_t block) {
+        std::size_t i = 0;
+        while ((MIN_BLOCK << i) < block) ++i;
+        return i;
+    }
+
+    static std::size_t ChunkAlign(std::size_t block) {
+        return block < alignof(std::max_align_t) ? block : alignof(std::max_align_t);
+    }
+
+    static std::size_t LargeAlign(std::size_t alignment) {
+        return alignment > alignof(Large) ? alignment : alignof(Large);
+    }
+
+    // Bytes in front of the user block: the header, padded to its alignment.
+    static std::size_t LargeOffset(std::size_t alignment) {
+        std::size_t align = LargeAlign(alignment);
+        return (sizeof(Large) + align - 1) / align * align;
+    }
+
+    static std::size_t LargeSize(std::size_t bytes, std::size_t alignment) {
+        return LargeOffset(alignment) + bytes;
+    }
+
+    static void* LargeBase(Large* large) {
+        return reinterpret_cast<char*>(large + 1) - LargeOffset(large->align_);
+    }
+
+    void Refill(Pool& pool, std::size_t block) {
+        std::size_t blocks = pool.next_blocks_;
+        char* base = static_cast<char*>(upstream_->allocate(blocks * block + sizeof(Chunk), ChunkAlign(block)));
+        pool.chunks_ = ::new (base + blocks * block) Chunk{pool.chunks_, blocks};
+        for (std::size_t i = blocks; i != 0;) pool.free_ = ::new (base + --i * block) FreeBlock{pool.free_};
+        if (blocks < max_blocks_)
+            pool.next_blocks_ = blocks * 2 < max_blocks_ ? blocks * 2 : max_blocks_;
+    }
+
+    void* AllocateLarge(std::size_t bytes, std::size_t alignment) {
+        char* base = static_cast<char*>(upstream_->allocate(LargeSize(bytes, alignment), LargeAlign(alignment)));
+        char* p = base + LargeOffset(alignment);
+        Large* large = ::new (p - sizeof(Large)) Large{nullptr, large_, bytes, alignment};
+        if (large_)
+            large_->prev_ = large;
+        large_ = large;
+        return p;
+    }
+
+    void DeallocateLarge(void* p, std::size_t bytes, std::size_t alignment) {
+        Large* large = reinterpret_cast<Large*>(static_cast<char*>(p) - sizeof(Large));
+        if (large->prev_)
+            large->prev_->next_ = large->next_;
+        else
+            large_ = large->next_;
+        if (large->next_)
+            large->next_->prev_ = large->prev_;
+        upstream_->deallocate(LargeBase(large), LargeSize(bytes, alignment), LargeAlign(alignment));
+    }
+
+    memory_resource* upstream_;
+    std::size_t max_blocks_;
+    std::size_t largest_;
+    Pool pools_[POOLS];
+    Large* large_ = nullptr;
+};
+
+/**
+ *  @brief unsynchronized_pool_resource behind a mutex, for a pool shared by
+ *  several threads.
+ */
+class synchronized_pool_resource : public memory_resource {
+public:
+    synchronized_pool_resource() = default;
+
+    explicit synchronized_pool_resource(memory_resource* upstream) : pool_(upstream) {}
+
+    explicit synchronized_pool_resource(const pool_options& opts) : pool_(opts) {}
+
+    synchronized_pool_resource(const pool_options& opts, memory_resource* upstream) : pool_(opts, upstream) {}
+
+    void release() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pool_.release();
+    }
+
+    memory_resource* upstream_resource() const noexcept {
+        return pool_.upstream_resource();
+    }
+
+    pool_options options() const noexcept {
+        return pool_.options();
+    }
+
+protected:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return pool_.allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pool_.deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+private:
+    std::mutex mutex_;
+    unsynchronized_pool_resource pool_;
+};
+
+}  // namespace pmr
+}  // namespace tiny_std
@@ -0,0 +1,232 @@
+/**
+ * @file compressed_ptr.h
+ * @author whoami (13003827890@163.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-15
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "smart_ptr/unique_ptr.h"
+
+namespace tiny_std {
+
+/**
+ *  @brief A bump allocator over one reserved region, registered under Tag.
+ *
+ *  compressed_ptr<T, arena<Tag>> stores offsets into the region of the live
+ *  arena<Tag>, so at most one arena per Tag may exist at a time; creating a
+ *  second one throws std::logic_error. Offsets count GRANULE-byte units,
+ *  which lets 32 bits address up to MAX_CAPACITY = 32 GiB; asking for more
+ *  throws std::length_error.
+ *
+ *  An arena is single-threaded: allocate(), deallocate() and the statistics
+ *  are not synchronized, so only one thread at a time may use a given Tag.
+ *
+ *  Memory is handed back only as a whole, by reset() or by destroying the
+ *  arena; deallocate() just keeps the statistics. That suits large graphs
+ *  that are built and torn down together.
+ */
+template <typename Tag>
+class arena {
+public:
+    static constexpr std::size_t GRANULE = 8;
+    static constexpr std::size_t MAX_CAPACITY = (std::size_t(1) << 32) * GRANULE;
+
+    explicit arena(std::size_t capacity) {
+        if (base_ != nullptr)
+            throw std::logic_error("arena: one live arena per Tag");
+        if (capacity > MAX_CAPACITY)
+            throw std::length_error("arena: capacity beyond what compressed_ptr can address");
+        base_ = static_cast<char*>(::operator new(RoundUp(capacity), std::align_val_t(GRANULE)));
+        capacity_ = RoundUp(capacity);
+        // Offset 0 is the null compressed_ptr, so never hand it out.
+        used_ = GRANULE;
+    }
+
+    arena(const arena&) = delete;
+    arena& operator=(const arena&) = delete;
+
+    ~arena() {
+        ::operator delete(base_, std::align_val_t(GRANULE));
+        base_ = nullptr;
+    }
+
+    static void* allocate(std::size_t bytes, std::size_t align = alignof(std::max_align_t)) {
+        assert(base_ != nullptr && "no live arena for this Tag");
+        assert(align <= GRANULE || align % GRANULE == 0);
+        std::size_t offset = align > GRANULE ? (used_ + align - 1) / align * align : used_;
+        std::size_t end = offset + RoundUp(bytes);
+        if (end > capacity_)
+            throw std::bad_alloc();
+        used_ = end;
+        ++live_;
+        return base_ + offset;
+    }
+
+    // Takes no size: an arena_delete<Base> may free what was allocated as a
+    // larger Derived.
+    static void deallocate(void*) {
+        --live_;
+    }
+
+    // Forget every allocation; the objects must have been destroyed already.
+    static void reset() {
+        used_ = GRANULE;
+        live_ = 0;
+    }
+
+    static std::size_t used() {
+        return used_;
+    }
+
+    // Allocations not yet deallocated.
+    static std::size_t live() {
+        return live_;
+    }
+
+    static char* base() {
+        return base_;
+    }
+
+private:
+    static std::size_t RoundUp(std::size_t bytes) {
+        return (bytes + GRANULE - 1) / GRANULE * GRANULE;
+    }
+
+    static inline char* base_ = nullptr;
+    static inline std::size_t capacity_ = 0;
+    static inline std::size_t used_ = 0;
+    static inline std::size_t live_ = 0;
+};
+
+/**
+ *  @brief A 32-bit pointer into the live Arena.
+ *
+ *  Holds the distance from Arena::base() in units of Arena::GRANULE; 0 is
+ *  null. Only GRANULE-aligned objects inside the arena can be pointed to.
+ *  Satisfies NullablePointer, so it can be the pointer type of a deleter.
+ */
+template <typename Tp, typename Arena>
+class compressed_ptr {
+public:
+    using element_type = Tp;
+    using offset_type = std::uint32_t;
+
+    compressed_ptr() : offset_(0) {}
+
+    compressed_ptr(std::nullptr_t) : offset_(0) {}
+
+    explicit compressed_ptr(Tp* p) : offset_(Compress(p)) {}
+
+    template <typename Up, typename = typename std::enable_if<std::is_convertible<Up*, Tp*>::value>::type>
+    compressed_ptr(const compressed_ptr<Up, Arena>& r) : compressed_ptr(static_cast<Tp*>(r.get())) {}
+
+    compressed_ptr& operator=(std::nullptr_t) {
+        offset_ = 0;
+        return *this;
+    }
+
+    Tp* get() const {
+        return offset_ == 0 ? nullptr : reinterpret_cast<Tp*>(Arena::base() + std::size_t(offset_) * Arena::GRANULE);
+    }
+
+    typename std::add_lvalue_reference<Tp>::type operator*() const {
+        return *get();
+    }
+
+    Tp* operator->() const {
+        return get();
+    }
+
+    explicit operator bool() const {
+        return offset_ != 0;
+    }
+
+    offset_type offset() const {
+        return offset_;
+    }
+
+    static compressed_ptr pointer_to(Tp& r) {
+        return compressed_ptr(std::addressof(r));
+    }
+
+    friend bool operator==(const compressed_ptr& a, const compressed_ptr& b) {
+        return a.offset_ == b.offset_;
+    }
+
+    friend bool operator!=(const compressed_ptr& a, const compressed_ptr& b) {
+        return a.offset_ != b.offset_;
+    }
+
+    friend bool operator==(const compressed_ptr& a, std::nullptr_t) {
+        return a.offset_ == 0;
+    }
+
+    friend bool operator!=(const compressed_ptr& a, std::nullptr_t) {
+        return a.offset_ != 0;
+    }
+
+private:
+    static offset_type Compress(Tp* p) {
+        if (p == nullptr)
+            return 0;
+        std::size_t distance = reinterpret_cast<const char*>(p) - Arena::base();
+        assert(distance % Arena::GRANULE == 0);
+        return static_cast<offset_type>(distance / Arena::GRANULE);
+    }
+
+    offset_type offset_;
+};
+
+/**
+ *  @brief Deleter for objects created in an Arena. Its pointer type is
+ *  compressed_ptr, so unique_ptr<Tp, arena_delete<Tp, Arena>> is 4 bytes.
+ */
+template <typename Tp, typename Arena>
+struct arena_delete {
+    using pointer = compressed_ptr<Tp, Arena>;
+
+    arena_delete() = default;
+
+    template <typename Up, typename = typename std::enable_if<std::is_convertible<Up*, Tp*>::value>::type>
+    arena_delete(const arena_delete<Up, Arena>&) {}
+
+    void operator()(pointer p) const {
+        Tp* raw = p.get();
+        raw->~Tp();
+        Arena::deallocate(raw);
+    }
+};
+
+template <typename Tp, typename Arena>
+using arena_unique_ptr = unique_ptr<Tp, arena_delete<Tp, Arena>>;
+
+template <typename Tp, typename Arena, typename... Args>
+inline arena_unique_ptr<Tp, Arena> make_arena_unique(Args&&... args) {
+    static_assert(alignof(Tp) <= Arena::GRANULE || alignof(Tp) % Arena::GRANULE == 0,
+                  "compressed_ptr needs granule aligned objects");
+    void* mem = Arena::allocate(sizeof(Tp), alignof(Tp));
+    Tp* p;
+    try {
+        p = ::new (mem) Tp(std::forward<Args>(args)...);
+    } catch (...) {
+        Arena::deallocate(mem);
+        throw;
+    }
+    return arena_unique_ptr<Tp, Arena>(compressed_ptr<Tp, Arena>(p));
+}
+
+}  // namespace tiny_std
@@ -0,0 +1,379 @@
+/**
+ * @file intrusive_ptr.h
+ * @author whoami (13003827890@163.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-15
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "smart_ptr/shared_ptr_base.h"
+
+namespace tiny_std {
+
+template <typename Derived, LockPolicy Lp = DEFAULT_LOCK_POLICY>
+class intrusive_ref_counter;
+
+/**
+ *  Control block embedded in an intrusive_ref_counter. It is an ordinary
+ *  SpCountedBase, so the object can also be owned through SharedPtr and
+ *  observed through WeakPtr. Dispose() only runs the destructor; the memory
+ *  (and with it the counts) is released by Destroy() once the weak count
+ *  drops to zero as well, without looking at the dead object again.
+ *
+ *  make_intrusive records the complete object's address, destructor and
+ *  deallocation function when it creates it. For objects made some other
+ *  way, Dispose() notes the address itself and runs ~Derived().
+ */
+template <typename Derived, LockPolicy Lp>
+class SpCountedIntrusive final : public SpCountedBase<Lp> {
+public:
+    // Ends or frees a complete object, given its address.
+    using Disposer = void (*)(void*);
+    using Deallocator = void (*)(void*);
+
+    // Nobody owns the object until the first intrusive_ptr (or SharedPtr).
+    SpCountedIntrusive() : SpCountedBase<Lp>(&SpCountedOpsOf<SpCountedIntrusive, Lp>::TABLE, 0) {}
+
+    void Dispose();
+
+    void Destroy();
+
+    void* GetDeleter(SpTypeId) {
+        return nullptr;
+    }
+
+    void Adopt(void* mem, Disposer dispose, Deallocator dealloc) {
+        mem_ = mem;
+        dispose_ = dispose;
+        dealloc_ = dealloc;
+    }
+
+private:
+    Derived* GetOwner();
+
+    // What a plain `new Derived(...)` needs: the unsized delete, aligned
+    // if Derived is over-aligned.
+    static void DeleteUnsized(void* mem) {
+        if constexpr (alignof(Derived) > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+            ::operator delete(mem, std::align_val_t(alignof(Derived)));
+        else
+            ::operator delete(mem);
+    }
+
+    void* mem_ = nullptr;
+    Disposer dispose_ = nullptr;
+    Deallocator dealloc_ = &DeleteUnsized;
+};
+
+/**
+ *  @brief Base class that embeds the reference counts in the object.
+ *
+ *  Create derived objects with make_intrusive, which allocates them with the
+ *  global operator new and frees them with the matching sized, and if need
+ *  be aligned, operator delete once the last strong and weak references are
+ *  gone. A plain `new Derived(...)` also works as long as Derived has no
+ *  class-specific operator new or delete and is the type actually created,
+ *  or has a virtual destructor. Copying an object does not copy its counts.
+ */
+template <typename Derived, LockPolicy Lp>
+class intrusive_ref_counter {
+    using Counter = SpCountedIntrusive<Derived, Lp>;
+
+public:
+    static constexpr LockPolicy lock_policy = Lp;
+
+    int use_count() const {
+        return GetCounter()->GetUseCnt();
+    }
+
+protected:
+    intrusive_ref_counter() {
+        ::new (static_cast<void*>(storage_)) Counter();
+        TINY_STD_SP_HOOK(GetCounter()->InstrumentAttach(SpInstrument::StatsOf<Derived>(), sizeof(Derived)));
+    }
+
+    intrusive_ref_counter(const intrusive_ref_counter&) : intrusive_ref_counter() {}
+
+    intrusive_ref_counter& operator=(const intrusive_ref_counter&) {
+        return *this;
+    }
+
+    // The counter is torn down by Destroy(), not here: weak references may
+    // still need it after the object itself is gone.
+    ~intrusive_ref_counter() = default;
+
+private:
+    Counter* GetCounter() const {
+        return const_cast<Counter*>(reinterpret_cast<const Counter*>(storage_));
+    }
+
+    friend SpCountedBase<Lp>* IntrusiveCount(const intrusive_ref_counter* p) {
+        return p->GetCounter();
+    }
+
+    friend void intrusive_ptr_add_ref(const intrusive_ref_counter* p) {
+        p->GetCounter()->AddRefCopy();
+    }
+
+    friend void intrusive_ptr_release(const intrusive_ref_counter* p) {
+        p->GetCounter()->Release();
+    }
+
+    // Used by make_intrusive to destroy and free the object as the type it
+    // created, from the address it allocated.
+    friend void IntrusiveAdopt(const intrusive_ref_counter* p, void* mem, typename Counter::Disposer dispose,
+                               typename Counter::Deallocator dealloc) {
+        p->GetCounter()->Adopt(mem, dispose, dealloc);
+    }
+
+    friend class SpCountedIntrusive<Derived, Lp>;
+
+    alignas(Counter) unsigned char storage_[sizeof(Counter)];
+};
+
+template <typename Derived, LockPolicy Lp>
+inline Derived* SpCountedIntrusive<Derived, Lp>::GetOwner() {
+    // The counter is the only member of intrusive_ref_counter.
+    auto base = reinterpret_cast<intrusive_ref_counter<Derived, Lp>*>(this);
+    return static_cast<Derived*>(base);
+}
+
+template <typename Derived, LockPolicy Lp>
+inline void SpCountedIntrusive<Derived, Lp>::Dispose() {
+    if (dispose_ != nullptr) {
+        dispose_(mem_);
+        return;
+    }
+    Derived* owner = GetOwner();
+    // The object may be a more derived type, with Derived not at its start.
+    if constexpr (std::is_polymorphic<Derived>::value)
+        mem_ = dynamic_cast<void*>(owner);
+    else
+        mem_ = owner;
+    owner->~Derived();
+}
+
+template <typename Derived, LockPolicy Lp>
+inline void SpCountedIntrusive<Derived, Lp>::Destroy() {
+    void* mem = mem_;
+    Deallocator dealloc = dealloc_;
+    this->~SpCountedIntrusive();
+    dealloc(mem);
+}
+
+/**
+ *  @brief A smart pointer to an object that carries its own reference count.
+ *
+ *  The count is found through the unqualified calls intrusive_ptr_add_ref(p)
+ *  and intrusive_ptr_release(p), so any type that provides them can be used;
+ *  intrusive_ref_counter provides them for its derived classes.
+ */
+template <typename Tp>
+class intrusive_ptr {
+public:
+    using element_type = Tp;
+
+    intrusive_ptr() : px_(nullptr) {}
+
+    intrusive_ptr(Tp* p, bool add_ref = true) : px_(p) {
+        if (px_ != nullptr && add_ref)
+            intrusive_ptr_add_ref(px_);
+    }
+
+    intrusive_ptr(const intrusive_ptr& r) : intrusive_ptr(r.px_) {}
+
+    template <typename Yp, typename = typename std::enable_if<std::is_convertible<Yp*, Tp*>::value>::type>
+    intrusive_ptr(const intrusive_ptr<Yp>& r) : intrusive_ptr(r.get()) {}
+
+    intrusive_ptr(intrusive_ptr&& r) : px_(r.px_) {
+        r.px_ = nullptr;
+    }
+
+    template <typename Yp, typename = typename std::enable_if<std::is_convertible<Yp*, Tp*>::value>::type>
+    intrusive_ptr(intrusive_ptr<Yp>&& r) : px_(r.detach()) {}
+
+    ~intrusive_ptr() {
+        if (px_ != nullptr)
+            intrusive_ptr_release(px_);
+    }
+
+    intrusive_ptr& operator=(const intrusive_ptr& r) {
+        intrusive_ptr(r).swap(*this);
+        return *this;
+    }
+
+    intrusive_ptr& operator=(intrusive_ptr&& r) {
+        intrusive_ptr(std::move(r)).swap(*this);
+        return *this;
+    }
+
+    intrusive_ptr& operator=(Tp* p) {
+        intrusive_ptr(p).swap(*this);
+        return *this;
+    }
+
+    void reset() {
+        intrusive_ptr().swap(*this);
+    }
+
+    void reset(Tp* p, bool add_ref = true) {
+        intrusive_ptr(p, add_ref).swap(*this);
+    }
+
+    // Give up ownership without touching the count.
+    Tp* detach() {
+        Tp* p = px_;
+        px_ = nullptr;
+        return p;
+    }
+
+    Tp* get() const {
+        return px_;
+    }
+
+    Tp& operator*() const {
+        return *px_;
+    }
+
+    Tp* operator->() const {
+        return px_;
+    }
+
+    explicit operator bool() const {
+        return px_ != nullptr;
+    }
+
+    void swap(intrusive_ptr& r) {
+        std::swap(px_, r.px_);
+    }
+
+    /**
+     *  @brief Share the same count through a SharedPtr.
+     *
+     *  Only available for intrusive_ref_counter based types. The SharedPtr
+     *  and the intrusive_ptr keep each other's object alive.
+     */
+    template <typename Up = Tp, LockPolicy Lp = Up::lock_policy>
+    SharedPtr<Tp, Lp> to_shared() const {
+        if (px_ == nullptr)
+            return SharedPtr<Tp, Lp>();
+        SpCountedBase<Lp>* count = IntrusiveCount(px_);
+        count->AddRefCopy();
+        return SpAccess::MakeShared<Tp, Lp>(SharedCount<Lp>(count, SpAdoptCount()), px_);
+    }
+
+    template <typename Up = Tp, LockPolicy Lp = Up::lock_policy>
+    WeakPtr<Tp, Lp> to_weak() const {
+        return WeakPtr<Tp, Lp>(to_shared());
+    }
+
+private:
+    Tp* px_;
+};
+
+template <typename Tp, typename Up>
+inline bool operator==(const intrusive_ptr<Tp>& a, const intrusive_ptr<Up>& b) {
+    return a.get() == b.get();
+}
+
+template <typename Tp, typename Up>
+inline bool operator!=(const intrusive_ptr<Tp>& a, const intrusive_ptr<Up>& b) {
+    return a.get() != b.get();
+}
+
+template <typename Tp>
+inline bool operator==(const intrusive_ptr<Tp>& a, nullptr_t) {
+    return !a;
+}
+
+template <typename Tp>
+inline bool operator==(nullptr_t, const intrusive_ptr<Tp>& a) {
+    return !a;
+}
+
+template <typename Tp>
+inline bool operator!=(const intrusive_ptr<Tp>& a, nullptr_t) {
+    return static_cast<bool>(a);
+}
+
+template <typename Tp>
+inline bool operator!=(nullptr_t, const intrusive_ptr<Tp>& a) {
+    return static_cast<bool>(a);
+}
+
+template <typename Tp>
+inline void swap(intrusive_ptr<Tp>& a, intrusive_ptr<Tp>& b) {
+    a.swap(b);
+}
+
+template <typename Tp, typename Up>
+inline intrusive_ptr<Tp> static_pointer_cast(const intrusive_ptr<Up>& r) {
+    return intrusive_ptr<Tp>(static_cast<Tp*>(r.get()));
+}
+
+// Ends a Tp that make_intrusive<Tp> created.
+template <typename Tp>
+void IntrusiveDispose(void* mem) {
+    static_cast<Tp*>(mem)->~Tp();
+}
+
+// Frees memory that make_intrusive<Tp> allocated.
+template <typename Tp>
+void IntrusiveDeallocate(void* mem) {
+    if constexpr (alignof(Tp) > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+        ::operator delete(mem, sizeof(Tp), std::align_val_t(alignof(Tp)));
+    else
+        ::operator delete(mem, sizeof(Tp));
+}
+
+template <typename Tp, typename = void>
+struct HasIntrusiveCounter : std::false_type {};
+
+template <typename Tp>
+struct HasIntrusiveCounter<Tp, std::void_t<decltype(IntrusiveAdopt(std::declval<Tp*>(), nullptr, nullptr, nullptr))>>
+    : std::true_type {};
+
+/**
+ *  @brief Create a Tp owned by an intrusive_ptr.
+ *
+ *  For intrusive_ref_counter based types the memory comes from the global
+ *  operator new, aligned for Tp, whatever Tp's own allocation functions.
+ *  When the counts drop to zero the object is destroyed as a Tp, even if the
+ *  counter's class has no virtual destructor, and the memory goes back to
+ *  the matching operator delete.
+ *  Other types are created with `new Tp(...)` and freed by their own
+ *  intrusive_ptr_release.
+ */
+template <typename Tp, typename... Args>
+inline intrusive_ptr<Tp> make_intrusive(Args&&... args) {
+    if constexpr (HasIntrusiveCounter<Tp>::value) {
+        void* mem;
+        if constexpr (alignof(Tp) > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+            mem = ::operator new(sizeof(Tp), std::align_val_t(alignof(Tp)));
+        else
+            mem = ::operator new(sizeof(Tp));
+        Tp* p;
+        try {
+            p = ::new (mem) Tp(std::forward<Args>(args)...);
+        } catch (...) {
+            IntrusiveDeallocate<Tp>(mem);
+            throw;
+        }
+        IntrusiveAdopt(p, mem, &IntrusiveDispose<Tp>, &IntrusiveDeallocate<Tp>);
+        return intrusive_ptr<Tp>(p);
+    } else {
+        return intrusive_ptr<Tp>(new Tp(std::forward<Args>(args)...));
+    }
+}
+
+}  // namespace tiny_std
@@ -0,0 +1,325 @@
+/**
+ * @file local_shared_ptr.h
+ * @author whoami (13003827890@163.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-15
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include "smart_ptr/shared_ptr_base.h"
+
+namespace tiny_std {
+
+/**
+ *  Shared ownership for object graphs that never leave their thread, such as
+ *  the per-connection state of an event loop.
+ *
+ *  local_shared_ptr and local_weak_ptr have the interface of shared_ptr and
+ *  weak_ptr on a SINGLE control block: reference counts are updated with
+ *  plain loads and stores, no atomic read-modify-write and no lock. In debug
+ *  builds every count update asserts that it runs on the thread that created
+ *  the block.
+ */
+template <typename Tp>
+class local_shared_ptr;
+
+template <typename Tp>
+class local_weak_ptr;
+
+template <typename Tp>
+class local_shared_ptr : public SharedPtr<Tp, SINGLE> {
+    template <typename... Args>
+    using Constructible = typename std::enable_if<std::is_constructible<SharedPtr<Tp, SINGLE>, Args...>::value>::type;
+
+    template <typename Arg>
+    using Assignable =
+        typename std::enable_if<std::is_assignable<SharedPtr<Tp, SINGLE>&, Arg>::value, local_shared_ptr&>::type;
+
+public:
+    using element_type = typename SharedPtr<Tp, SINGLE>::element_type;
+
+    using weak_type = local_weak_ptr<Tp>;
+
+    local_shared_ptr() : SharedPtr<Tp, SINGLE>() {}
+
+    local_shared_ptr(const local_shared_ptr&) = default;
+
+    template <typename Yp, typename = Constructible<Yp*>>
+    explicit local_shared_ptr(Yp* p) : SharedPtr<Tp, SINGLE>(p) {}
+
+    template <typename Yp, typename Deleter, typename = Constructible<Yp*, Deleter>>
+    local_shared_ptr(Yp* p, Deleter d) : SharedPtr<Tp, SINGLE>(p, std::move(d)) {}
+
+    template <typename Yp, typename Deleter, typename Alloc, typename = Constructible<Yp*, Deleter, Alloc>>
+    local_shared_ptr(Yp* p, Deleter d, Alloc a) : SharedPtr<Tp, SINGLE>(p, std::move(d), std::move(a)) {}
+
+    template <typename Deleter>
+    local_shared_ptr(nullptr_t p, Deleter d) : SharedPtr<Tp, SINGLE>(p, std::move(d)) {}
+
+    template <typename Yp>
+    local_shared_ptr(const local_shared_ptr<Yp>& r, element_type* p) : SharedPtr<Tp, SINGLE>(r, p) {}
+
+    template <typename Yp>
+    local_shared_ptr(local_shared_ptr<Yp>&& r, element_type* p) noexcept : SharedPtr<Tp, SINGLE>(std::move(r), p) {}
+
+    template <typename Yp, typename = Constructible<const local_shared_ptr<Yp>&>>
+    local_shared_ptr(const local_shared_ptr<Yp>& r) : SharedPtr<Tp, SINGLE>(r) {}
+
+    local_shared_ptr(local_shared_ptr&& r) noexcept : SharedPtr<Tp, SINGLE>(std::move(r)) {}
+
+    template <typename Yp, typename = Constructible<local_shared_ptr<Yp>>>
+    local_shared_ptr(local_shared_ptr<Yp>&& r) noexcept : SharedPtr<Tp, SINGLE>(std::move(r)) {}
+
+    // Throws bad_weak_ptr if r has expired.
+    template <typename Yp, typename = Constructible<const local_weak_ptr<Yp>&>>
+    explicit local_shared_ptr(const local_weak_ptr<Yp>& r) : SharedPtr<Tp, SINGLE>(r) {}
+
+    template <typename Yp, typename Del, typename = Constructible<unique_ptr<Yp, Del>>>
+    local_shared_ptr(unique_ptr<Yp, Del>&& r) : SharedPtr<Tp, SINGLE>(std::move(r)) {}
+
+    local_shared_ptr(nullptr_t) : local_shared_ptr() {}
+
+    local_shared_ptr& operator=(const local_shared_ptr&) = default;
+
+    template <typename Yp>
+    Assignable<const local_shared_ptr<Yp>&> operator=(const local_shared_ptr<Yp>& r) {
+        this->SharedPtr<Tp, SINGLE>::operator=(r);
+        return *this;
+    }
+
+    local_shared_ptr& operator=(local_shared_ptr&& r) noexcept {
+        this->SharedPtr<Tp, SINGLE>::operator=(std::move(r));
+        return *this;
+    }
+
+    template <typename Yp>
+    Assignable<local_shared_ptr<Yp>> operator=(local_shared_ptr<Yp>&& r) noexcept {
+        this->SharedPtr<Tp, SINGLE>::operator=(std::move(r));
+        return *this;
+    }
+
+    template <typename Yp, typename Del>
+    Assignable<unique_ptr<Yp, Del>> operator=(unique_ptr<Yp, Del>&& r) {
+        this->SharedPtr<Tp, SINGLE>::operator=(std::move(r));
+        return *this;
+    }
+
+    // Write n copies to out, taking the n references with one update.
+    template <typename OutputIt>
+    OutputIt share_n(std::size_t n, OutputIt out) const {
+        return this->template ShareN<local_shared_ptr>(n, out);
+    }
+
+private:
+    template <typename Alloc, typename... Args>
+    local_shared_ptr(SpAllocShared<Alloc> tag, Args&&... args)
+        : SharedPtr<Tp, SINGLE>(tag, std::forward<Args>(args)...) {}
+
+    template <typename Yp, typename Alloc, typename... Args>
+    friend local_shared_ptr<typename std::enable_if<!std::is_array<Yp>::value, Yp>::type> allocate_local_shared(
+        const Alloc&, Args&&...);
+
+    local_shared_ptr(const local_weak_ptr<Tp>& r, std::nothrow_t) noexcept : SharedPtr<Tp, SINGLE>(r, std::nothrow) {}
+
+    friend class local_weak_ptr<Tp>;
+};
+
+template <typename Tp>
+inline void swap(local_shared_ptr<Tp>& a, local_shared_ptr<Tp>& b) {
+    a.swap(b);
+}
+
+template <typename Tp, typename Up>
+inline local_shared_ptr<Tp> static_pointer_cast(const local_shared_ptr<Up>& r) {
+    using Sp = local_shared_ptr<Tp>;
+    return Sp(r, static_cast<typename Sp::element_type*>(r.get()));
+}
+
+template <typename Tp, typename Up>
+inline local_shared_ptr<Tp> static_pointer_cast(local_shared_ptr<Up>&& r) {
+    using Sp = local_shared_ptr<Tp>;
+    return Sp(std::move(r), static_cast<typename Sp::element_type*>(r.get()));
+}
+
+template <typename Tp, typename Up>
+inline local_shared_ptr<Tp> const_pointer_cast(const local_shared_ptr<Up>& r) {
+    using Sp = local_shared_ptr<Tp>;
+    return Sp(r, const_cast<typename Sp::element_type*>(r.get()));
+}
+
+template <typename Tp, typename Up>
+inline local_shared_ptr<Tp> const_pointer_cast(local_shared_ptr<Up>&& r) {
+    using Sp = local_shared_ptr<Tp>;
+    return Sp(std::move(r), const_cast<typename Sp::element_type*>(r.get()));
+}
+
+template <typename Tp, typename Up>
+inline local_shared_ptr<Tp> dynamic_pointer_cast(const local_shared_ptr<Up>& r) {
+    using Sp = local_shared_ptr<Tp>;
+    if (auto* p = dynamic_cast<typename Sp::element_type*>(r.get()))
+        return Sp(r, p);
+    return Sp();
+}
+
+template <typename Tp, typename Up>
+inline local_shared_ptr<Tp> dynamic_pointer_cast(local_shared_ptr<Up>&& r) {
+    using Sp = local_shared_ptr<Tp>;
+    if (auto* p = dynamic_cast<typename Sp::element_type*>(r.get()))
+        return Sp(std::move(r), p);
+    return Sp();
+}
+
+template <typename Tp, typename Up>
+inline local_shared_ptr<Tp> reinterpret_pointer_cast(const local_shared_ptr<Up>& r) {
+    using Sp = local_shared_ptr<Tp>;
+    return Sp(r, reinterpret_cast<typename Sp::element_type*>(r.get()));
+}
+
+template <typename Tp, typename Up>
+inline local_shared_ptr<Tp> reinterpret_pointer_cast(local_shared_ptr<Up>&& r) {
+    using Sp = local_shared_ptr<Tp>;
+    return Sp(std::move(r), reinterpret_cast<typename Sp::element_type*>(r.get()));
+}
+
+template <typename Tp>
+class local_weak_ptr : public WeakPtr<Tp, SINGLE> {
+private:
+    template <typename Arg>
+    using Constructible = typename std::enable_if<std::is_constructible<WeakPtr<Tp, SINGLE>, Arg>::value>::type;
+
+    template <typename Arg>
+    using Assignable =
+        typename std::enable_if<std::is_assignable<WeakPtr<Tp, SINGLE>&, Arg>::value, local_weak_ptr&>::type;
+
+public:
+    local_weak_ptr() = default;
+
+    template <typename Yp, typename = Constructible<const local_shared_ptr<Yp>&>>
+    local_weak_ptr(const local_shared_ptr<Yp>& r) : WeakPtr<Tp, SINGLE>(r) {}
+
+    local_weak_ptr(const local_weak_ptr&) = default;
+
+    template <typename Yp, typename = Constructible<const local_weak_ptr<Yp>&>>
+    local_weak_ptr(const local_weak_ptr<Yp>& r) : WeakPtr<Tp, SINGLE>(r) {}
+
+    local_weak_ptr(local_weak_ptr&&) = default;
+
+    template <typename Yp, typename = Constructible<local_weak_ptr<Yp>>>
+    local_weak_ptr(local_weak_ptr<Yp>&& r) noexcept : WeakPtr<Tp, SINGLE>(std::move(r)) {}
+
+    local_weak_ptr& operator=(const local_weak_ptr& r) = default;
+
+    template <typename Yp>
+    Assignable<const local_weak_ptr<Yp>&> operator=(const local_weak_ptr<Yp>& r) {
+        this->WeakPtr<Tp, SINGLE>::operator=(r);
+        return *this;
+    }
+
+    template <typename Yp>
+    Assignable<const local_shared_ptr<Yp>&> operator=(const local_shared_ptr<Yp>& r) {
+        this->WeakPtr<Tp, SINGLE>::operator=(r);
+        return *this;
+    }
+
+    local_weak_ptr& operator=(local_weak_ptr&& r) = default;
+
+    template <typename Yp>
+    Assignable<local_weak_ptr<Yp>> operator=(local_weak_ptr<Yp>&& r) noexcept {
+        this->WeakPtr<Tp, SINGLE>::operator=(std::move(r));
+        return *this;
+    }
+
+    local_shared_ptr<Tp> lock() const noexcept {
+        return local_shared_ptr<Tp>(*this, std::nothrow);
+    }
+};
+
+template <typename Tp>
+inline void swap(local_weak_ptr<Tp>& a, local_weak_ptr<Tp>& b) {
+    a.swap(b);
+}
+
+/**
+ *  @brief Base class that lets an object owned by local_shared_ptr hand out
+ *  more owners of itself, like enable_shared_from_this.
+ */
+template <typename Tp>
+class enable_local_shared_from_this {
+protected:
+    enable_local_shared_from_this() {}
+
+    enable_local_shared_from_this(const enable_local_shared_from_this&) {}
+
+    enable_local_shared_from_this& operator=(const enable_local_shared_from_this&) {
+        return *this;
+    }
+
+    ~enable_local_shared_from_this() {}
+
+public:
+    local_shared_ptr<Tp> shared_from_this() {
+        return local_shared_ptr<Tp>(this->_weak_this_);
+    }
+
+    local_shared_ptr<const Tp> shared_from_this() const {
+        return local_shared_ptr<const Tp>(this->_weak_this_);
+    }
+
+    local_weak_ptr<Tp> weak_from_this() {
+        return this->_weak_this_;
+    }
+
+    local_weak_ptr<const Tp> weak_from_this() const {
+        return this->_weak_this_;
+    }
+
+private:
+    template <typename Tp1>
+    void WeakAssign(Tp1* p, const SharedCount<SINGLE>& n) const {
+        _weak_this_.Assign(p, n);
+    }
+
+    friend const enable_local_shared_from_this* EnableSharedFromThisBase(const SharedCount<SINGLE>&,
+                                                                         const enable_local_shared_from_this* p) {
+        return p;
+    }
+
+    template <typename, LockPolicy>
+    friend class SharedPtr;
+
+    mutable local_weak_ptr<Tp> _weak_this_;
+};
+
+/**
+ *  @brief Create an object that is owned by a local_shared_ptr.
+ *  @param a An allocator.
+ *  @param args Arguments for the @a Tp object's constructor.
+ *  @return A local_shared_ptr that owns the newly created object.
+ *
+ *  The object and the reference counts are placed in a single block
+ *  obtained from a copy of @a a.
+ */
+template <typename Tp, typename Alloc, typename... Args>
+inline local_shared_ptr<typename std::enable_if<!std::is_array<Tp>::value, Tp>::type> allocate_local_shared(
+    const Alloc& a, Args&&... args) {
+    return local_shared_ptr<Tp>(SpAllocShared<Alloc>{a}, std::forward<Args>(args)...);
+}
+
+/**
+ *  @brief Create an object that is owned by a local_shared_ptr.
+ *  @param args Arguments for the @a Tp object's constructor.
+ *  @return A local_shared_ptr that owns the newly created object.
+ */
+template <typename Tp, typename... Args>
+inline local_shared_ptr<typename std::enable_if<!std::is_array<Tp>::value, Tp>::type> make_local_shared(
+    Args&&... args) {
+    using TpNoCv = typename std::remove_cv<Tp>::type;
+    return tiny_std::allocate_local_shared<Tp>(std::allocator<TpNoCv>(), std::forward<Args>(args)...);
+}
+
+}  // namespace tiny_std
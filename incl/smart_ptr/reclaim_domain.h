@@ -0,0 +1,255 @@
+/**
+ * @file reclaim_domain.h
+ * @author whoami (13003827890@163.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-15
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+
+#include "smart_ptr/shared_ptr_base.h"
+
+namespace tiny_std {
+
+// Entry of a reclaim_domain retire list.
+class SpRetiredBlock {
+public:
+    // Run the deferred Dispose(), and Destroy() if it was already requested.
+    virtual void Reclaim() = 0;
+
+protected:
+    ~SpRetiredBlock() = default;
+
+private:
+    friend class reclaim_domain;
+
+    SpRetiredBlock* retired_next_ = nullptr;
+};
+
+struct reclaim_stats {
+    size_t retired;     // blocks handed to the domain so far
+    size_t reclaimed;   // blocks whose Dispose() has run so far
+    size_t backlog;     // retired but not yet reclaimed
+    size_t batches;     // non-empty drain() calls
+    size_t last_batch;  // size of the last non-empty batch
+    size_t max_batch;   // largest batch seen
+};
+
+/**
+ *  @brief Takes destructor work off the threads that drop the last SharedPtr.
+ *
+ *  Control blocks created by make_deferred_shared() push themselves onto the
+ *  domain's lock-free retire list when their strong count reaches zero.
+ *  The objects are destroyed later, either by drain() or by the background
+ *  reclaimer started with start(). The domain must outlive those blocks.
+ */
+class reclaim_domain {
+public:
+    reclaim_domain() = default;
+
+    reclaim_domain(const reclaim_domain&) = delete;
+    reclaim_domain& operator=(const reclaim_domain&) = delete;
+
+    ~reclaim_domain() {
+        stop();
+        drain();
+    }
+
+    // Reclaim everything retired so far and return how many blocks that was.
+    size_t drain() {
+        SpRetiredBlock* head = head_.exchange(nullptr, std::memory_order_acquire);
+        size_t batch = 0;
+        while (head != nullptr) {
+            // Reclaim() may free the entry.
+            SpRetiredBlock* next = head->retired_next_;
+            head->Reclaim();
+            head = next;
+            ++batch;
+        }
+        if (batch != 0) {
+            reclaimed_.fetch_add(batch, std::memory_order_relaxed);
+            batches_.fetch_add(1, std::memory_order_relaxed);
+            last_batch_.store(batch, std::memory_order_relaxed);
+            size_t max = max_batch_.load(std::memory_order_relaxed);
+            while (batch > max && !max_batch_.compare_exchange_weak(max, batch, std::memory_order_relaxed)) {
+            }
+        }
+        return batch;
+    }
+
+    // Start a background thread that drains the domain every `interval`.
+    void start(std::chrono::microseconds interval = std::chrono::milliseconds(1)) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (reclaimer_.joinable())
+            return;
+        running_ = true;
+        reclaimer_ = std::thread([this, interval] {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (running_) {
+                cv_.wait_for(lock, interval, [this] { return !running_; });
+                lock.unlock();
+                drain();
+                lock.lock();
+            }
+        });
+    }
+
+    void stop() {
+        std::thread reclaimer;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_ = false;
+            reclaimer.swap(reclaimer_);
+        }
+        cv_.notify_all();
+        if (reclaimer.joinable())
+            reclaimer.join();
+    }
+
+    reclaim_stats stats() const {
+        reclaim_stats result;
+        result.reclaimed = reclaimed_.load(std::memory_order_relaxed);
+        result.retired = retired_.load(std::memory_order_relaxed);
+        result.backlog = result.retired > result.reclaimed ? result.retired - result.reclaimed : 0;
+        result.batches = batches_.load(std::memory_order_relaxed);
+        result.last_batch = last_batch_.load(std::memory_order_relaxed);
+        result.max_batch = max_batch_.load(std::memory_order_relaxed);
+        return result;
+    }
+
+    // Lock-free push; drain() takes the whole list at once, so there is no ABA.
+    void Retire(SpRetiredBlock* block) {
+        SpRetiredBlock* head = head_.load(std::memory_order_relaxed);
+        do {
+            block->retired_next_ = head;
+        } while (!head_.compare_exchange_weak(head, block, std::memory_order_release, std::memory_order_relaxed));
+        retired_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<SpRetiredBlock*> head_{nullptr};
+
+    std::atomic<size_t> retired_{0};
+    std::atomic<size_t> reclaimed_{0};
+    std::atomic<size_t> batches_{0};
+    std::atomic<size_t> last_batch_{0};
+    std::atomic<size_t> max_batch_{0};
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool running_ = false;
+    std::thread reclaimer_;
+};
+
+/**
+ *  In-place control block whose Dispose() only hands the block to a
+ *  reclaim_domain. Destroy() can be requested before the domain has run the
+ *  real dispose (always the case when there are no weak references), so the
+ *  two are ordered through state_: whichever side comes second frees the block.
+ */
+template <typename Tp, typename Alloc, LockPolicy Lp>
+class SpCountedDeferred final : public SpCountedBase<Lp>, public SpRetiredBlock {
+    using TpAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Tp>;
+    using TpAllocTraits = std::allocator_traits<TpAlloc>;
+
+    class Impl : private TpAlloc {
+    public:
+        explicit Impl(const TpAlloc& a) : TpAlloc(a) {}
+
+        TpAlloc& GetAlloc() {
+            return *this;
+        }
+
+        alignas(Tp) unsigned char storage_[sizeof(Tp)];
+    };
+
+    enum : unsigned {
+        DISPOSED = 1,
+        DESTROY_REQUESTED = 2
+    };
+
+public:
+    using BlockAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<SpCountedDeferred>;
+    using BlockAllocTraits = std::allocator_traits<BlockAlloc>;
+
+    template <typename... Args>
+    SpCountedDeferred(reclaim_domain& domain, const Alloc& a, Args&&... args)
+        : SpCountedBase<Lp>(&SpCountedOpsOf<SpCountedDeferred, Lp>::TABLE), impl_(TpAlloc(a)), domain_(domain) {
+        TpAllocTraits::construct(impl_.GetAlloc(), GetPtr(), std::forward<Args>(args)...);
+    }
+
+    void Dispose() {
+        domain_.Retire(this);
+    }
+
+    void Destroy() {
+        if (state_.fetch_or(DESTROY_REQUESTED, std::memory_order_acq_rel) & DISPOSED)
+            DestroyNow();
+    }
+
+    void Reclaim() override {
+        TpAllocTraits::destroy(impl_.GetAlloc(), GetPtr());
+        if (state_.fetch_or(DISPOSED, std::memory_order_acq_rel) & DESTROY_REQUESTED)
+            DestroyNow();
+    }
+
+    void* GetDeleter(SpTypeId) {
+        return nullptr;
+    }
+
+    Tp* GetPtr() {
+        return reinterpret_cast<Tp*>(impl_.storage_);
+    }
+
+private:
+    void DestroyNow() {
+        BlockAlloc a(impl_.GetAlloc());
+        this->~SpCountedDeferred();
+        BlockAllocTraits::deallocate(a, this, 1);
+    }
+
+    Impl impl_;
+    reclaim_domain& domain_;
+    std::atomic<unsigned> state_{0};
+};
+
+/**
+ *  @brief Create an object owned by a SharedPtr whose destruction is deferred
+ *  to @a domain.
+ *
+ *  Like allocate_shared, the object and the counts share one allocation.
+ */
+template <typename Tp, LockPolicy Lp = DEFAULT_LOCK_POLICY, typename Alloc, typename... Args>
+inline SharedPtr<Tp, Lp> allocate_deferred_shared(reclaim_domain& domain, const Alloc& a, Args&&... args) {
+    static_assert(!std::is_array<Tp>::value, "make_deferred_shared<T[]> not supported");
+    using Block = SpCountedDeferred<typename std::remove_cv<Tp>::type, Alloc, Lp>;
+    typename Block::BlockAlloc block_alloc(a);
+    Block* mem = Block::BlockAllocTraits::allocate(block_alloc, 1);
+    try {
+        ::new (static_cast<void*>(mem)) Block(domain, a, std::forward<Args>(args)...);
+    } catch (...) {
+        Block::BlockAllocTraits::deallocate(block_alloc, mem, 1);
+        throw;
+    }
+    TINY_STD_SP_HOOK(mem->InstrumentAttach(SpInstrument::StatsOf<Tp>(), sizeof(Tp)));
+    return SpAccess::MakeShared<Tp, Lp>(SharedCount<Lp>(mem, SpAdoptCount()), mem->GetPtr());
+}
+
+template <typename Tp, LockPolicy Lp = DEFAULT_LOCK_POLICY, typename... Args>
+inline SharedPtr<Tp, Lp> make_deferred_shared(reclaim_domain& domain, Args&&... args) {
+    using TpNoCv = typename std::remove_cv<Tp>::type;
+    return allocate_deferred_shared<Tp, Lp>(domain, std::allocator<TpNoCv>(), std::forward<Args>(args)...);
+}
+
+}  // namespace tiny_std
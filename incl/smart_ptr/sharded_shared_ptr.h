@@ -0,0 +1,263 @@
+/**
+ * @file sharded_shared_ptr.h
+ * @author whoami (13003827890@163.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-15
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace tiny_std {
+
+/**
+ *  Control block of sharded_shared_ptr, with the object in place.
+ *
+ *  While the anchor reference (the one make_sharded_shared returned) is alive,
+ *  copies and releases only touch the calling thread's shard, a counter on a
+ *  cache line of its own. Shards can go negative; only their sum matters.
+ *  Meanwhile global_ holds BIAS plus the anchor, so it cannot reach zero.
+ *
+ *  Releasing the anchor reconciles the shards: each one is swapped for DEAD
+ *  and its value moved into global_, then the bias is dropped. A thread whose
+ *  shard update lands on a DEAD shard redoes it on global_ instead, so from
+ *  then on the block counts like an ordinary atomic counter and whoever takes
+ *  global_ to zero destroys the object.
+ *
+ *  The shards are allocated with the block, one per hardware thread rounded
+ *  up to a power of two and capped at MAX_SHARDS, so a block costs up to
+ *  ShardBytes() = 256 * 64 bytes = 16 KiB on top of the object.
+ */
+template <typename Tp>
+class SpCountedSharded {
+    struct alignas(64) Shard {
+        std::atomic<long> count{0};
+    };
+
+    static constexpr long BIAS = 1L << 40;
+    static constexpr long DEAD = 1L << 62;
+    // Anything this close to DEAD is a DEAD shard that late updates moved a bit.
+    static constexpr long DEAD_MIN = 1L << 61;
+
+public:
+    static constexpr unsigned MAX_SHARDS = 256;
+
+    template <typename... Args>
+    explicit SpCountedSharded(Args&&... args)
+        : global_(BIAS + 1), shard_mask_(ShardCount() - 1), shards_(new Shard[ShardCount()]) {
+        ::new (static_cast<void*>(storage_)) Tp(std::forward<Args>(args)...);
+    }
+
+    Tp* GetPtr() {
+        return reinterpret_cast<Tp*>(storage_);
+    }
+
+    void AddRefCopy() {
+        if (MyShard().fetch_add(1, std::memory_order_relaxed) >= DEAD_MIN)
+            global_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void Release() {
+        if (MyShard().fetch_sub(1, std::memory_order_release) >= DEAD_MIN)
+            ReleaseGlobal(1);
+    }
+
+    // Release the anchor reference and reconcile the shards.
+    void ReleaseAnchor() {
+        long sum = 0;
+        for (unsigned i = 0; i <= shard_mask_; ++i)
+            sum += shards_[i].count.exchange(DEAD, std::memory_order_acq_rel);
+        // The shards held `sum` references; we drop BIAS and the anchor.
+        ReleaseGlobal(BIAS + 1 - sum);
+    }
+
+    // Only exact when no other thread is copying or releasing.
+    long GetUseCount() const {
+        long global = global_.load(std::memory_order_relaxed);
+        if (global < BIAS)
+            return global;
+        long sum = 0;
+        for (unsigned i = 0; i <= shard_mask_; ++i)
+            sum += shards_[i].count.load(std::memory_order_relaxed);
+        return global - BIAS + sum;
+    }
+
+    static unsigned ShardCount() {
+        static const unsigned count = [] {
+            unsigned hw = std::thread::hardware_concurrency();
+            unsigned n = 1;
+            while (n < hw && n < MAX_SHARDS)
+                n <<= 1;
+            return n;
+        }();
+        return count;
+    }
+
+    // Memory taken by the shards of each block.
+    static std::size_t ShardBytes() {
+        return ShardCount() * sizeof(Shard);
+    }
+
+private:
+    std::atomic<long>& MyShard() {
+        static std::atomic<unsigned> next_thread{0};
+        thread_local unsigned index = next_thread.fetch_add(1, std::memory_order_relaxed);
+        return shards_[index & shard_mask_].count;
+    }
+
+    void ReleaseGlobal(long n) {
+        if (global_.fetch_sub(n, std::memory_order_acq_rel) == n) {
+            GetPtr()->~Tp();
+            delete this;
+        }
+    }
+
+    std::atomic<long> global_;
+    unsigned shard_mask_;
+    std::unique_ptr<Shard[]> shards_;
+    alignas(Tp) unsigned char storage_[sizeof(Tp)];
+};
+
+/**
+ *  @brief A shared pointer for read-mostly objects that every thread copies.
+ *
+ *  Copies and releases update a per-thread shard of the count instead of one
+ *  shared counter, so they do not bounce a cache line between cores. The
+ *  shards are reconciled once, when the anchor reference is released: the
+ *  pointer returned by make_sharded_shared, or whatever it was moved into.
+ *  Copies of the anchor are ordinary references. After the anchor is gone
+ *  the remaining copies share one atomic count until the last one frees the
+ *  object, so the anchor should live as long as the object stays hot (for
+ *  example in the variable holding the current config).
+ *
+ *  The price is memory: every object carries a 64-byte shard per hardware
+ *  thread (SpCountedSharded::ShardBytes(), at most 16 KiB), so this is for a
+ *  few hot objects, not for large numbers of small ones.
+ */
+template <typename Tp>
+class sharded_shared_ptr {
+    using Block = SpCountedSharded<Tp>;
+
+    static constexpr std::uintptr_t ANCHOR = 1;
+
+public:
+    using element_type = Tp;
+
+    sharded_shared_ptr() : ptr_(nullptr), block_(0) {}
+
+    sharded_shared_ptr(std::nullptr_t) : sharded_shared_ptr() {}
+
+    sharded_shared_ptr(const sharded_shared_ptr& r) : ptr_(r.ptr_), block_(reinterpret_cast<std::uintptr_t>(r.GetBlock())) {
+        if (block_ != 0)
+            GetBlock()->AddRefCopy();
+    }
+
+    sharded_shared_ptr(sharded_shared_ptr&& r) : ptr_(r.ptr_), block_(r.block_) {
+        r.ptr_ = nullptr;
+        r.block_ = 0;
+    }
+
+    ~sharded_shared_ptr() {
+        if (Block* block = GetBlock()) {
+            if (is_anchor())
+                block->ReleaseAnchor();
+            else
+                block->Release();
+        }
+    }
+
+    sharded_shared_ptr& operator=(const sharded_shared_ptr& r) {
+        sharded_shared_ptr(r).swap(*this);
+        return *this;
+    }
+
+    sharded_shared_ptr& operator=(sharded_shared_ptr&& r) {
+        sharded_shared_ptr(std::move(r)).swap(*this);
+        return *this;
+    }
+
+    void reset() {
+        sharded_shared_ptr().swap(*this);
+    }
+
+    void swap(sharded_shared_ptr& r) {
+        std::swap(ptr_, r.ptr_);
+        std::swap(block_, r.block_);
+    }
+
+    Tp* get() const {
+        return ptr_;
+    }
+
+    Tp& operator*() const {
+        return *ptr_;
+    }
+
+    Tp* operator->() const {
+        return ptr_;
+    }
+
+    explicit operator bool() const {
+        return ptr_ != nullptr;
+    }
+
+    bool is_anchor() const {
+        return (block_ & ANCHOR) != 0;
+    }
+
+    // Sums all shards; exact only while no other thread copies or releases.
+    long use_count() const {
+        Block* block = GetBlock();
+        return block ? block->GetUseCount() : 0;
+    }
+
+private:
+    template <typename Up, typename... Args>
+    friend sharded_shared_ptr<Up> make_sharded_shared(Args&&... args);
+
+    explicit sharded_shared_ptr(Block* block)
+        : ptr_(block->GetPtr()), block_(reinterpret_cast<std::uintptr_t>(block) | ANCHOR) {}
+
+    Block* GetBlock() const {
+        return reinterpret_cast<Block*>(block_ & ~ANCHOR);
+    }
+
+    Tp* ptr_;
+    std::uintptr_t block_;
+};
+
+template <typename Tp>
+inline bool operator==(const sharded_shared_ptr<Tp>& a, const sharded_shared_ptr<Tp>& b) {
+    return a.get() == b.get();
+}
+
+template <typename Tp>
+inline bool operator!=(const sharded_shared_ptr<Tp>& a, const sharded_shared_ptr<Tp>& b) {
+    return a.get() != b.get();
+}
+
+template <typename Tp>
+inline void swap(sharded_shared_ptr<Tp>& a, sharded_shared_ptr<Tp>& b) {
+    a.swap(b);
+}
+
+/// @brief Create an object owned by the returned anchor sharded_shared_ptr.
+template <typename Tp, typename... Args>
+inline sharded_shared_ptr<Tp> make_sharded_shared(Args&&... args) {
+    static_assert(!std::is_array<Tp>::value, "make_sharded_shared<T[]> not supported");
+    return sharded_shared_ptr<Tp>(new SpCountedSharded<Tp>(std::forward<Args>(args)...));
+}
+
+}  // namespace tiny_std
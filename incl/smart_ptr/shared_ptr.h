@@ -11,18 +11,29 @@
 
 #pragma once
 
+#include "smart_ptr/shared_ptr_atomic.h"
 #include "smart_ptr/shared_ptr_base.h"
 
 namespace tiny_std {
 
-template <typename Del, typename Tp>
-inline Del* get_deleter(const SharedPtr<Tp>& p) {
-    return static_cast<Del*>(p.GetDeleter(typeid(Del)));
-}
-
 template <typename Tp>
 using NonArray = std::__enable_if_t<!std::is_array<Tp>::value, Tp>;
 
+template <typename Tp>
+using UnboundedArray = std::__enable_if_t<std::is_array<Tp>::value && std::extent<Tp>::value == 0, Tp>;
+
+template <typename Tp>
+using BoundedArray = std::__enable_if_t<std::extent<Tp>::value != 0, Tp>;
+
+template <typename Tp>
+using NotUnboundedArray = std::__enable_if_t<!std::is_array<Tp>::value || std::extent<Tp>::value != 0, Tp>;
+
+template <typename Tp>
+class shared_ptr;
+
+template <typename Tp, typename Alloc, typename Init>
+shared_ptr<Tp> AllocateSharedArray(const Alloc& a, std::size_t n, Init init);
+
 template <typename Tp>
 class shared_ptr : public SharedPtr<Tp> {
     template <typename... Args>
@@ -46,22 +57,28 @@ public:
     template <typename Yp, typename Deleter, typename = Constructible<Yp*, Deleter>>
     shared_ptr(Yp* p, Deleter d) : SharedPtr<Tp>(p, std::move(d)) {}
 
+    template <typename Yp, typename Deleter, typename Alloc, typename = Constructible<Yp*, Deleter, Alloc>>
+    shared_ptr(Yp* p, Deleter d, Alloc a) : SharedPtr<Tp>(p, std::move(d), std::move(a)) {}
+
     template <typename Deleter>
     shared_ptr(nullptr_t p, Deleter d) : SharedPtr<Tp>(p, std::move(d)) {}
 
+    template <typename Deleter, typename Alloc>
+    shared_ptr(nullptr_t p, Deleter d, Alloc a) : SharedPtr<Tp>(p, std::move(d), std::move(a)) {}
+
     template <typename Yp>
     shared_ptr(const shared_ptr<Yp>& r, element_type* p) : SharedPtr<Tp>(r, p) {}
 
     template <typename Yp>
-    shared_ptr(shared_ptr<Yp>&& r, element_type* p) : SharedPtr<Tp>(std::move(r), p) {}
+    shared_ptr(shared_ptr<Yp>&& r, element_type* p) noexcept : SharedPtr<Tp>(std::move(r), p) {}
 
     template <typename Yp, typename = Constructible<const shared_ptr<Yp>&>>
     shared_ptr(const shared_ptr<Yp>& r) : SharedPtr<Tp>(r) {}
 
-    shared_ptr(shared_ptr&& r) : SharedPtr<Tp>(std::move(r)) {}
+    shared_ptr(shared_ptr&& r) noexcept : SharedPtr<Tp>(std::move(r)) {}
 
     template <typename Yp, typename = Constructible<shared_ptr<Yp>>>
-    shared_ptr(shared_ptr<Yp>&& r) : SharedPtr<Tp>(std::move(r)) {}
+    shared_ptr(shared_ptr<Yp>&& r) noexcept : SharedPtr<Tp>(std::move(r)) {}
 
     template <typename Yp, typename = Constructible<const weak_ptr<Yp>&>>
     explicit shared_ptr(const weak_ptr<Yp>& r) : SharedPtr<Tp>(r) {}
@@ -79,13 +96,13 @@ public:
         return *this;
     }
 
-    shared_ptr& operator=(shared_ptr&& r) {
+    shared_ptr& operator=(shared_ptr&& r) noexcept {
         this->SharedPtr<Tp>::operator=(std::move(r));
         return *this;
     }
 
     template <class Yp>
-    Assignable<shared_ptr<Yp>> operator=(shared_ptr<Yp>&& r) {
+    Assignable<shared_ptr<Yp>> operator=(shared_ptr<Yp>&& r) noexcept {
         this->SharedPtr<Tp>::operator=(std::move(r));
         return *this;
     }
@@ -96,10 +113,29 @@ public:
         return *this;
     }
 
+    // Write n copies to out, taking the n references with one update.
+    template <typename OutputIt>
+    OutputIt share_n(std::size_t n, OutputIt out) const {
+        return this->template ShareN<shared_ptr>(n, out);
+    }
+
 private:
-    // TODO: make_shared
+    template <typename Alloc, typename... Args>
+    shared_ptr(SpAllocShared<Alloc> tag, Args&&... args) : SharedPtr<Tp>(tag, std::forward<Args>(args)...) {}
+
+    template <typename Yp, typename Alloc, typename... Args>
+    friend shared_ptr<NonArray<Yp>> allocate_shared(const Alloc&, Args&&...);
+
+    template <typename Yp, typename... Args>
+    friend shared_ptr<NonArray<Yp>> make_shared(Args&&...);
+
+    template <typename Alloc, typename Init>
+    shared_ptr(SpAllocSharedArray<Alloc> tag, Init init) : SharedPtr<Tp>(tag, init) {}
 
-    shared_ptr(const weak_ptr<Tp>& r, std::nothrow_t) : SharedPtr<Tp>(r, std::nothrow) {}
+    template <typename Yp, typename Alloc, typename Init>
+    friend shared_ptr<Yp> AllocateSharedArray(const Alloc&, std::size_t, Init);
+
+    shared_ptr(const weak_ptr<Tp>& r, std::nothrow_t) noexcept : SharedPtr<Tp>(r, std::nothrow) {}
 
 private:
     friend class weak_ptr<Tp>;
@@ -137,7 +173,7 @@ inline bool operator!=(nullptr_t, const shared_ptr<Tp>& a) {
 
 template <typename Tp>
 inline void swap(shared_ptr<Tp>& a, shared_ptr<Tp>& b) {
-    a.Swap();
+    a.swap(b);
 }
 
 template <typename Tp, typename Up>
@@ -146,12 +182,24 @@ inline shared_ptr<Tp> static_pointer_cast(const shared_ptr<Up>& r) {
     return Sp(r, static_cast<typename Sp::element_type*>(r.get()));
 }
 
+template <typename Tp, typename Up>
+inline shared_ptr<Tp> static_pointer_cast(shared_ptr<Up>&& r) {
+    using Sp = shared_ptr<Tp>;
+    return Sp(std::move(r), static_cast<typename Sp::element_type*>(r.get()));
+}
+
 template <typename Tp, typename Up>
 inline shared_ptr<Tp> const_pointer_cast(const shared_ptr<Up>& r) {
     using Sp = shared_ptr<Tp>;
     return Sp(r, const_cast<typename Sp::element_type*>(r.get()));
 }
 
+template <typename Tp, typename Up>
+inline shared_ptr<Tp> const_pointer_cast(shared_ptr<Up>&& r) {
+    using Sp = shared_ptr<Tp>;
+    return Sp(std::move(r), const_cast<typename Sp::element_type*>(r.get()));
+}
+
 template <typename Tp, typename Up>
 inline shared_ptr<Tp> dynamic_pointer_cast(const shared_ptr<Up>& r) {
     using Sp = shared_ptr<Tp>;
@@ -160,12 +208,26 @@ inline shared_ptr<Tp> dynamic_pointer_cast(const shared_ptr<Up>& r) {
     return Sp();
 }
 
+template <typename Tp, typename Up>
+inline shared_ptr<Tp> dynamic_pointer_cast(shared_ptr<Up>&& r) {
+    using Sp = shared_ptr<Tp>;
+    if (auto* p = dynamic_cast<typename Sp::element_type*>(r.get()))
+        return Sp(std::move(r), p);
+    return Sp();
+}
+
 template <typename Tp, typename Up>
 inline shared_ptr<Tp> reinterpret_pointer_cast(const shared_ptr<Up>& r) {
     using Sp = shared_ptr<Tp>;
     return Sp(r, reinterpret_cast<typename Sp::element_type*>(r.get()));
 }
 
+template <typename Tp, typename Up>
+inline shared_ptr<Tp> reinterpret_pointer_cast(shared_ptr<Up>&& r) {
+    using Sp = shared_ptr<Tp>;
+    return Sp(std::move(r), reinterpret_cast<typename Sp::element_type*>(r.get()));
+}
+
 template <typename Tp>
 class weak_ptr : public WeakPtr<Tp> {
 private:
@@ -189,7 +251,7 @@ public:
     weak_ptr(weak_ptr&&) = default;
 
     template <typename Yp, typename = Constructible<weak_ptr<Yp>>>
-    weak_ptr(weak_ptr<Yp>&& r) : WeakPtr<Tp>(std::move(r)) {}
+    weak_ptr(weak_ptr<Yp>&& r) noexcept : WeakPtr<Tp>(std::move(r)) {}
 
     weak_ptr& operator=(const weak_ptr& r) = default;
 
@@ -208,12 +270,12 @@ public:
     weak_ptr& operator=(weak_ptr&& r) = default;
 
     template <typename Yp>
-    Assignable<weak_ptr<Yp>> operator=(weak_ptr<Yp>&& r) {
+    Assignable<weak_ptr<Yp>> operator=(weak_ptr<Yp>&& r) noexcept {
         this->WeakPtr<Tp>::operator=(std::move(r));
         return *this;
     }
 
-    shared_ptr<Tp> lock() const {
+    shared_ptr<Tp> lock() const noexcept {
         return shared_ptr<Tp>(*this, std::nothrow);
     }
 };
@@ -255,21 +317,175 @@ public:
 
 private:
     template <typename Tp1>
-    void WeakAssign(Tp1* p, const SharedCount& n) const {
+    void WeakAssign(Tp1* p, const SharedCount<>& n) const {
         _weak_this_.Assign(p, n);
     }
 
-    friend const enable_shared_from_this* EnableSharedFromThisBase(const SharedCount&,
+    friend const enable_shared_from_this* EnableSharedFromThisBase(const SharedCount<>&,
                                                                    const enable_shared_from_this* p) {
         return p;
     }
 
-    template <typename>
+    template <typename, LockPolicy>
     friend class SharedPtr;
 
     mutable weak_ptr<Tp> _weak_this_;
 };
 
-// TODO: make_shared
+/**
+ *  @brief Create an object that is owned by a shared_ptr.
+ *  @param a An allocator.
+ *  @param args Arguments for the @a Tp object's constructor.
+ *  @return A shared_ptr that owns the newly created object.
+ *
+ *  The object and the reference counts are placed in a single block
+ *  obtained from a copy of @a a.
+ */
+template <typename Tp, typename Alloc, typename... Args>
+inline shared_ptr<NonArray<Tp>> allocate_shared(const Alloc& a, Args&&... args) {
+    return shared_ptr<Tp>(SpAllocShared<Alloc>{a}, std::forward<Args>(args)...);
+}
+
+/**
+ *  @brief Create an object that is owned by a shared_ptr.
+ *  @param args Arguments for the @a Tp object's constructor.
+ *  @return A shared_ptr that owns the newly created object.
+ */
+template <typename Tp, typename... Args>
+inline shared_ptr<NonArray<Tp>> make_shared(Args&&... args) {
+    using TpNoCv = typename std::remove_cv<Tp>::type;
+    return tiny_std::allocate_shared<Tp>(std::allocator<TpNoCv>(), std::forward<Args>(args)...);
+}
+
+// Common part of the array forms: n elements of remove_extent_t<Tp>.
+template <typename Tp, typename Alloc, typename Init>
+inline shared_ptr<Tp> AllocateSharedArray(const Alloc& a, std::size_t n, Init init) {
+    return shared_ptr<Tp>(SpAllocSharedArray<Alloc>{a, n}, init);
+}
+
+template <typename Tp>
+inline SpArrayFillInit<typename std::remove_cv<typename std::remove_all_extents<Tp>::type>::type> SpFillWith(
+    const typename std::remove_extent<Tp>::type& u) {
+    using Elem = typename std::remove_cv<typename std::remove_all_extents<Tp>::type>::type;
+    return {reinterpret_cast<const Elem*>(std::addressof(u)), sizeof(u) / sizeof(Elem)};
+}
+
+/**
+ *  @brief Create an array of @a n value-initialized elements owned by a
+ *  shared_ptr. The element count, the elements and the reference counts
+ *  share a single allocation obtained from a copy of @a a.
+ */
+template <typename Tp, typename Alloc>
+inline shared_ptr<UnboundedArray<Tp>> allocate_shared(const Alloc& a, std::size_t n) {
+    return AllocateSharedArray<Tp>(a, n, SpArrayValueInit{});
+}
+
+/// @brief As above, with every element a copy of @a u.
+template <typename Tp, typename Alloc>
+inline shared_ptr<UnboundedArray<Tp>> allocate_shared(const Alloc& a, std::size_t n,
+                                                       const typename std::remove_extent<Tp>::type& u) {
+    return AllocateSharedArray<Tp>(a, n, SpFillWith<Tp>(u));
+}
+
+template <typename Tp, typename Alloc>
+inline shared_ptr<BoundedArray<Tp>> allocate_shared(const Alloc& a) {
+    return AllocateSharedArray<Tp>(a, std::extent<Tp>::value, SpArrayValueInit{});
+}
+
+template <typename Tp, typename Alloc>
+inline shared_ptr<BoundedArray<Tp>> allocate_shared(const Alloc& a, const typename std::remove_extent<Tp>::type& u) {
+    return AllocateSharedArray<Tp>(a, std::extent<Tp>::value, SpFillWith<Tp>(u));
+}
+
+template <typename Tp>
+inline shared_ptr<UnboundedArray<Tp>> make_shared(std::size_t n) {
+    using Elem = typename std::remove_cv<typename std::remove_all_extents<Tp>::type>::type;
+    return tiny_std::allocate_shared<Tp>(std::allocator<Elem>(), n);
+}
+
+template <typename Tp>
+inline shared_ptr<UnboundedArray<Tp>> make_shared(std::size_t n, const typename std::remove_extent<Tp>::type& u) {
+    using Elem = typename std::remove_cv<typename std::remove_all_extents<Tp>::type>::type;
+    return tiny_std::allocate_shared<Tp>(std::allocator<Elem>(), n, u);
+}
+
+template <typename Tp>
+inline shared_ptr<BoundedArray<Tp>> make_shared() {
+    using Elem = typename std::remove_cv<typename std::remove_all_extents<Tp>::type>::type;
+    return tiny_std::allocate_shared<Tp>(std::allocator<Elem>());
+}
+
+template <typename Tp>
+inline shared_ptr<BoundedArray<Tp>> make_shared(const typename std::remove_extent<Tp>::type& u) {
+    using Elem = typename std::remove_cv<typename std::remove_all_extents<Tp>::type>::type;
+    return tiny_std::allocate_shared<Tp>(std::allocator<Elem>(), u);
+}
+
+/**
+ *  @brief Like allocate_shared / make_shared, but the object or elements are
+ *  default-initialized, so buffers of trivial types are not zeroed first.
+ */
+template <typename Tp, typename Alloc>
+inline shared_ptr<NonArray<Tp>> allocate_shared_for_overwrite(const Alloc& a) {
+    return tiny_std::allocate_shared<Tp>(a, SpForOverwrite{});
+}
+
+template <typename Tp, typename Alloc>
+inline shared_ptr<BoundedArray<Tp>> allocate_shared_for_overwrite(const Alloc& a) {
+    return AllocateSharedArray<Tp>(a, std::extent<Tp>::value, SpArrayDefaultInit{});
+}
+
+template <typename Tp, typename Alloc>
+inline shared_ptr<UnboundedArray<Tp>> allocate_shared_for_overwrite(const Alloc& a, std::size_t n) {
+    return AllocateSharedArray<Tp>(a, n, SpArrayDefaultInit{});
+}
+
+template <typename Tp>
+inline shared_ptr<NotUnboundedArray<Tp>> make_shared_for_overwrite() {
+    using Elem = typename std::remove_cv<typename std::remove_all_extents<Tp>::type>::type;
+    return tiny_std::allocate_shared_for_overwrite<Tp>(std::allocator<Elem>());
+}
+
+template <typename Tp>
+inline shared_ptr<UnboundedArray<Tp>> make_shared_for_overwrite(std::size_t n) {
+    using Elem = typename std::remove_cv<typename std::remove_all_extents<Tp>::type>::type;
+    return tiny_std::allocate_shared_for_overwrite<Tp>(std::allocator<Elem>(), n);
+}
+
+template <typename Tp>
+class atomic<shared_ptr<Tp>> : public SpAtomic<shared_ptr<Tp>> {
+public:
+    using value_type = shared_ptr<Tp>;
+
+    atomic() = default;
+
+    atomic(value_type desired) : SpAtomic<value_type>(std::move(desired)) {}
+
+    void operator=(value_type desired) {
+        this->store(std::move(desired));
+    }
+
+    operator value_type() const {
+        return this->load();
+    }
+};
+
+template <typename Tp>
+class atomic<weak_ptr<Tp>> : public SpAtomic<weak_ptr<Tp>> {
+public:
+    using value_type = weak_ptr<Tp>;
+
+    atomic() = default;
+
+    atomic(value_type desired) : SpAtomic<value_type>(std::move(desired)) {}
+
+    void operator=(value_type desired) {
+        this->store(std::move(desired));
+    }
+
+    operator value_type() const {
+        return this->load();
+    }
+};
 
 }  // namespace tiny_std
@@ -0,0 +1,285 @@
+/**
+ * @file shared_ptr_atomic.h
+ * @author whoami (13003827890@163.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-15
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <utility>
+
+#include "smart_ptr/shared_ptr_base.h"
+
+namespace tiny_std {
+
+template <typename Tp>
+class atomic;
+
+/**
+ *  Holder for the value published by an atomic smart pointer. The holder is
+ *  an ordinary control block whose strong count is bumped once, when it is
+ *  published, by a whole batch of references that readers then claim one at a
+ *  time through the packed word in SpAtomic.
+ */
+template <typename Value>
+class SpAtomicNode final : public SpCountedBase<ATOMIC> {
+public:
+    SpAtomicNode(Value&& v, int refs)
+        : SpCountedBase<ATOMIC>(&SpCountedOpsOf<SpAtomicNode, ATOMIC>::TABLE, refs), value_(std::move(v)) {}
+
+    void Dispose() {
+        value_ = Value();
+    }
+
+    void Destroy() {
+        delete this;
+    }
+
+    void* GetDeleter(SpTypeId) {
+        return nullptr;
+    }
+
+    const Value& Get() const {
+        return value_;
+    }
+
+private:
+    Value value_;
+};
+
+/**
+ *  Lock-free implementation shared by atomic<SharedPtr<Tp>> and
+ *  atomic<WeakPtr<Tp>>.
+ *
+ *  The whole state is one 64-bit word: the address of the current holder in
+ *  the low 48 bits and, in the top 16 bits, the number of references readers
+ *  have claimed from that holder since it was published. A reader claims one
+ *  with a single fetch_add and copies the value out of the holder; it never
+ *  waits for writers or for other readers.
+ *
+ *  A holder is published with REFS_RESERVED strong references. When it is
+ *  replaced, the references nobody claimed are dropped with one ReleaseN().
+ *  Readers that find the claim counter half used move it back to zero after
+ *  adding the same number of references to the holder, topping them up for
+ *  claims that race with the reset until it succeeds.
+ */
+template <typename Value>
+class SpAtomic {
+    using Node = SpAtomicNode<Value>;
+    using Word = std::uintptr_t;
+
+    static_assert(sizeof(Word) == 8, "the packed pointer needs a 64-bit address space");
+
+    static constexpr int PTR_BITS = 48;
+    static constexpr Word PTR_MASK = (Word(1) << PTR_BITS) - 1;
+    static constexpr Word ONE_CLAIM = Word(1) << PTR_BITS;
+    static constexpr int REFS_RESERVED = 1 << 15;
+    static constexpr int REFILL_AT = REFS_RESERVED / 2;
+
+public:
+    static constexpr bool is_always_lock_free = std::atomic<Word>::is_always_lock_free;
+
+    SpAtomic() : word_(0) {}
+
+    explicit SpAtomic(Value v) : word_(Publish(std::move(v))) {}
+
+    SpAtomic(const SpAtomic&) = delete;
+    SpAtomic& operator=(const SpAtomic&) = delete;
+
+    ~SpAtomic() {
+        Word w = word_.load(std::memory_order_relaxed);
+        Retire(w);
+    }
+
+    bool is_lock_free() const {
+        return word_.is_lock_free();
+    }
+
+    Value load(std::memory_order = std::memory_order_seq_cst) const {
+        if (word_.load(std::memory_order_relaxed) == 0)
+            return Value();
+        Word w = Claim();
+        Node* node = GetNode(w);
+        if (node == nullptr)
+            return Value();
+        Value result = node->Get();
+        node->Release();
+        return result;
+    }
+
+    void store(Value desired, std::memory_order order = std::memory_order_seq_cst) {
+        exchange(std::move(desired), order);
+    }
+
+    Value exchange(Value desired, std::memory_order = std::memory_order_seq_cst) {
+        Word w = word_.exchange(Publish(std::move(desired)), std::memory_order_acq_rel);
+        Node* node = GetNode(w);
+        if (node == nullptr)
+            return Value();
+        Value result = node->Get();
+        Retire(w);
+        return result;
+    }
+
+    bool compare_exchange_strong(Value& expected, Value desired, std::memory_order, std::memory_order) {
+        return compare_exchange_strong(expected, std::move(desired));
+    }
+
+    bool compare_exchange_strong(Value& expected, Value desired,
+                                 std::memory_order = std::memory_order_seq_cst) {
+        Word fresh = 0;
+        for (;;) {
+            Word w = Claim();
+            Node* node = GetNode(w);
+            if (!Equivalent(node ? node->Get() : Value(), expected)) {
+                expected = node ? node->Get() : Value();
+                if (node)
+                    node->Release();
+                if (fresh)
+                    Retire(fresh);
+                return false;
+            }
+            if (fresh == 0)
+                fresh = Publish(std::move(desired));
+            // The claim counter can still move under us, only the holder matters.
+            Word seen = w + ONE_CLAIM;
+            while (GetNode(seen) == node) {
+                if (word_.compare_exchange_weak(seen, fresh, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                    if (node) {
+                        // Our own claim plus everything nobody claimed.
+                        node->ReleaseN(REFS_RESERVED - Claims(seen) + 1);
+                    }
+                    return true;
+                }
+            }
+            // Another writer got in first; look at its value.
+            if (node)
+                node->Release();
+        }
+    }
+
+    bool compare_exchange_weak(Value& expected, Value desired, std::memory_order success, std::memory_order failure) {
+        return compare_exchange_strong(expected, std::move(desired), success, failure);
+    }
+
+    bool compare_exchange_weak(Value& expected, Value desired, std::memory_order order = std::memory_order_seq_cst) {
+        return compare_exchange_strong(expected, std::move(desired), order);
+    }
+
+private:
+    static Node* GetNode(Word w) {
+        return reinterpret_cast<Node*>(w & PTR_MASK);
+    }
+
+    static int Claims(Word w) {
+        return static_cast<int>(w >> PTR_BITS);
+    }
+
+    static Word Publish(Value v) {
+        if (IsEmpty(v))
+            return 0;
+        Node* node = new Node(std::move(v), REFS_RESERVED);
+        return reinterpret_cast<Word>(node);
+    }
+
+    // Drop the references of a holder that is no longer reachable from word_.
+    static void Retire(Word w) {
+        if (Node* node = GetNode(w))
+            node->ReleaseN(REFS_RESERVED - Claims(w));
+    }
+
+    // Claim one reference on the current holder and return the word as it was
+    // before the claim.
+    Word Claim() const {
+        Word w = word_.fetch_add(ONE_CLAIM, std::memory_order_acquire);
+        if (GetNode(w) != nullptr && Claims(w) >= REFILL_AT)
+            Refill(w + ONE_CLAIM);
+        return w;
+    }
+
+    void Refill(Word seen) const {
+        Node* node = GetNode(seen);
+        int added = Claims(seen);
+        // We hold a claimed reference, so the holder cannot go away here.
+        node->AddRefCopyN(added);
+        // Claims that land before our CAS get their references added too, so
+        // a steady stream of readers cannot keep the counter from resetting.
+        // We stop once the holder is replaced or another reader has reset it.
+        while (GetNode(seen) == node && Claims(seen) >= added) {
+            if (word_.compare_exchange_weak(seen, reinterpret_cast<Word>(node), std::memory_order_acq_rel,
+                                            std::memory_order_relaxed))
+                return;
+            if (GetNode(seen) == node && Claims(seen) > added) {
+                node->AddRefCopyN(Claims(seen) - added);
+                added = Claims(seen);
+            }
+        }
+        node->ReleaseN(added);
+    }
+
+    static bool IsEmpty(const Value& v) {
+        return v.ref_count_ == decltype(v.ref_count_)() && v.ptr_ == nullptr;
+    }
+
+    static bool Equivalent(const Value& a, const Value& b) {
+        return a.ptr_ == b.ptr_ && a.ref_count_ == b.ref_count_;
+    }
+
+    mutable std::atomic<Word> word_;
+};
+
+/**
+ *  @brief Atomic SharedPtr. Loads never block and do not serialize readers.
+ *
+ *  The memory_order arguments are accepted for interface compatibility; every
+ *  operation is at least acquire/release.
+ */
+template <typename Tp, LockPolicy Lp>
+class atomic<SharedPtr<Tp, Lp>> : public SpAtomic<SharedPtr<Tp, Lp>> {
+    static_assert(Lp != SINGLE, "atomic<SharedPtr> needs a thread-safe lock policy");
+
+public:
+    using value_type = SharedPtr<Tp, Lp>;
+
+    atomic() = default;
+
+    atomic(value_type desired) : SpAtomic<value_type>(std::move(desired)) {}
+
+    void operator=(value_type desired) {
+        this->store(std::move(desired));
+    }
+
+    operator value_type() const {
+        return this->load();
+    }
+};
+
+/// @brief Atomic WeakPtr, see atomic<SharedPtr<Tp, Lp>>.
+template <typename Tp, LockPolicy Lp>
+class atomic<WeakPtr<Tp, Lp>> : public SpAtomic<WeakPtr<Tp, Lp>> {
+    static_assert(Lp != SINGLE, "atomic<WeakPtr> needs a thread-safe lock policy");
+
+public:
+    using value_type = WeakPtr<Tp, Lp>;
+
+    atomic() = default;
+
+    atomic(value_type desired) : SpAtomic<value_type>(std::move(desired)) {}
+
+    void operator=(value_type desired) {
+        this->store(std::move(desired));
+    }
+
+    operator value_type() const {
+        return this->load();
+    }
+};
+
+}  // namespace tiny_std
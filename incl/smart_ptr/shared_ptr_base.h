@@ -11,126 +11,1190 @@
 
 #pragma once
 
+#include <algorithm>
 #include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
 #include <type_traits>
+#include <vector>
 
+#include <smart_ptr/sp_instrument.h>
 #include <smart_ptr/unique_ptr.h>
 
 namespace tiny_std {
 
-class SpCountedBase {
+/**
+ *  Policy used by the reference counting machinery.
+ *
+ *  SINGLE  plain counter updates, for object graphs confined to one thread.
+ *  MUTEX   counter updates are serialized by a mutex in the control block.
+ *  ATOMIC  counter updates are atomic read-modify-write operations.
+ *  BIASED  the thread that created the block counts with plain updates, the
+ *          others with atomic ones; see SpCountedBase<BIASED>.
+ */
+enum LockPolicy {
+    SINGLE,
+    MUTEX,
+    ATOMIC,
+    BIASED
+};
+
+static constexpr LockPolicy DEFAULT_LOCK_POLICY = ATOMIC;
+
+// Thrown when a SharedPtr is constructed from an expired WeakPtr.
+class bad_weak_ptr : public std::exception {
+public:
+    const char* what() const noexcept override {
+        return "tiny_std::bad_weak_ptr";
+    }
+};
+
+// Per-policy state of the control block: the mutex of MUTEX and, in debug
+// builds, the thread a SINGLE block is confined to. Empty otherwise.
+template <LockPolicy Lp>
+class SpPolicyBase {};
+
+template <>
+class SpPolicyBase<MUTEX> {
+protected:
+    std::mutex mutex_;
+};
+
+template <>
+class SpPolicyBase<SINGLE> {
+protected:
+#ifndef NDEBUG
+    void CheckThread() const {
+        assert(thread_ == std::this_thread::get_id() && "SINGLE control block used from another thread");
+    }
+
+private:
+    std::thread::id thread_ = std::this_thread::get_id();
+#else
+    void CheckThread() const {}
+#endif
+};
+
+// Counter update for the policies that do not need an atomic RMW: a relaxed
+// load followed by a relaxed store is a plain add without a lock prefix.
+inline int ExchangeAndAddSingle(std::atomic<int>& word, int val) {
+    int result = word.load(std::memory_order_relaxed);
+    word.store(result + val, std::memory_order_relaxed);
+    return result;
+}
+
+/**
+ *  Type identity for GetDeleter() that works without RTTI: the address of a
+ *  variable that exists once per type.
+ */
+using SpTypeId = const void*;
+
+template <typename Tp>
+struct SpTypeIdTag {
+    static constexpr char id = 0;
+};
+
+template <typename Tp>
+constexpr SpTypeId SpTypeIdOf() {
+    return &SpTypeIdTag<typename std::remove_cv<Tp>::type>::id;
+}
+
+template <LockPolicy Lp = DEFAULT_LOCK_POLICY>
+class SpCountedBase;
+
+/**
+ *  What a control block does once its counts drop, as a static table per
+ *  block type instead of virtual functions. dispose_destroy runs both in a
+ *  single call, for the common case where the last strong and the last weak
+ *  reference go away together; for the in-place blocks of make_shared the
+ *  destructor and the deallocation are inlined into it.
+ */
+template <LockPolicy Lp>
+struct SpCountedOps {
+    void (*dispose)(SpCountedBase<Lp>*);
+    void (*destroy)(SpCountedBase<Lp>*);
+    void (*dispose_destroy)(SpCountedBase<Lp>*);
+    void* (*get_deleter)(SpCountedBase<Lp>*, SpTypeId);
+};
+
+// The table of Block, a class derived from SpCountedBase<Lp> that implements
+// Dispose(), Destroy() and GetDeleter(SpTypeId) itself.
+template <typename Block, LockPolicy Lp>
+struct SpCountedOpsOf {
+    static void Dispose(SpCountedBase<Lp>* b) {
+        static_cast<Block*>(b)->Dispose();
+    }
+
+    static void Destroy(SpCountedBase<Lp>* b) {
+        static_cast<Block*>(b)->Destroy();
+    }
+
+    static void DisposeDestroy(SpCountedBase<Lp>* b) {
+        Block* block = static_cast<Block*>(b);
+        block->Dispose();
+        block->Destroy();
+    }
+
+    static void* GetDeleter(SpCountedBase<Lp>* b, SpTypeId ti) {
+        return static_cast<Block*>(b)->GetDeleter(ti);
+    }
+
+    // Without its own versions, the calls above would find the dispatching
+    // ones of SpCountedBase and recurse.
+    static_assert(std::is_same<decltype(&Block::Dispose), void (Block::*)()>::value &&
+                      std::is_same<decltype(&Block::Destroy), void (Block::*)()>::value &&
+                      std::is_same<decltype(&Block::GetDeleter), void* (Block::*)(SpTypeId)>::value,
+                  "control blocks must implement Dispose, Destroy and GetDeleter");
+
+    static constexpr SpCountedOps<Lp> TABLE = {&Dispose, &Destroy, &DisposeDestroy, &GetDeleter};
+};
+
+/**
+ *  Reference counts shared by the owners of an object. A block is 16 bytes:
+ *  the pointer to the ops table of its type and the two counts, which form
+ *  one aligned double word.
+ */
+template <LockPolicy Lp>
+class SpCountedBase : public SpPolicyBase<Lp>
+#ifdef TINY_STD_SP_INSTRUMENT
+    , public SpInstrumentState
+#endif
+{
+protected:
+    // use_cnt is for blocks that start out with more (or fewer) than one
+    // strong reference.
+    explicit SpCountedBase(const SpCountedOps<Lp>* ops, int use_cnt = 1)
+        : ops_(ops), use_cnt_(use_cnt), weak_cnt_(1) {}
+
+    // Blocks are only destroyed by their own Destroy().
+    ~SpCountedBase() = default;
+
+public:
+    void Dispose() {
+        ops_->dispose(this);
+    }
+
+    void Destroy() {
+        ops_->destroy(this);
+    }
+
+    void* GetDeleter(SpTypeId ti) {
+        return ops_->get_deleter(this, ti);
+    }
+
+    // Taking another reference never needs to synchronize with anything: the
+    // caller already holds one, so the object cannot go away concurrently.
+    void AddRefCopy() {
+        TINY_STD_SP_HOOK(InstrumentCopy(1));
+        FetchAdd(use_cnt_, 1, std::memory_order_relaxed);
+    }
+
+    // Turn a weak reference into a strong one. Once the count has dropped to
+    // zero the object is gone for good, so zero is never incremented.
+    bool AddRefLock() {
+        int count = use_cnt_.load(std::memory_order_relaxed);
+        while (count != 0) {
+            if (use_cnt_.compare_exchange_weak(count, count + 1, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                TINY_STD_SP_HOOK(InstrumentCopy(1));
+                return true;
+            }
+            TINY_STD_SP_HOOK(InstrumentContended());
+        }
+        return false;
+    }
+
+    void Release() {
+        TINY_STD_SP_HOOK(InstrumentRelease(1));
+        // Both counts are read as a single word. When they are both 1 this is
+        // the last reference of any kind, so no other thread can observe the
+        // counts any more and the block can be torn down without another RMW.
+        constexpr bool lock_free =
+            std::atomic<long long>::is_always_lock_free && std::atomic<int>::is_always_lock_free;
+        constexpr bool double_word = sizeof(long long) == 2 * sizeof(std::atomic<int>);
+        if constexpr (lock_free && double_word) {
+            constexpr long long unique_ref = 1LL + (1LL << (8 * sizeof(int)));
+            auto both_counts = reinterpret_cast<long long*>(&use_cnt_);
+            if (__atomic_load_n(both_counts, __ATOMIC_ACQUIRE) == unique_ref) {
+                use_cnt_.store(0, std::memory_order_relaxed);
+                weak_cnt_.store(0, std::memory_order_relaxed);
+                TINY_STD_SP_HOOK(InstrumentDispose());
+                ops_->dispose_destroy(this);
+                return;
+            }
+        }
+        // acq_rel: the release half publishes our writes to the object, the
+        // acquire half makes the other owners' writes visible to Dispose().
+        if (FetchAdd(use_cnt_, -1, std::memory_order_acq_rel) == 1) {
+            ReleaseLastUseCold();
+        }
+    }
+
+    // Take or drop n strong references with a single RMW. The caller of
+    // ReleaseN() must hold at least n references.
+    void AddRefCopyN(int n) {
+        TINY_STD_SP_HOOK(InstrumentCopy(n));
+        FetchAdd(use_cnt_, n, std::memory_order_relaxed);
+    }
+
+    void ReleaseN(int n) {
+        TINY_STD_SP_HOOK(InstrumentRelease(n));
+        if (FetchAdd(use_cnt_, -n, std::memory_order_acq_rel) == n) {
+            ReleaseLastUseCold();
+        }
+    }
+
+    void ReleaseLastUse() {
+        TINY_STD_SP_HOOK(InstrumentDispose());
+        Dispose();
+        WeakRelease();
+    }
+
+    // Weak references are still alive; kept out of line so that the common
+    // Release() path stays small enough to inline.
+    __attribute__((__noinline__)) void ReleaseLastUseCold() {
+        ReleaseLastUse();
+    }
+
+    void WeakAddRef() {
+        TINY_STD_SP_HOOK(InstrumentWeakCopy());
+        weak_cnt_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void WeakRelease() {
+        TINY_STD_SP_HOOK(InstrumentWeakRelease());
+        if (weak_cnt_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            Destroy();
+        }
+    }
+
+    int GetUseCnt() const {
+        return use_cnt_.load(std::memory_order_relaxed);
+    }
+
+private:
+    SpCountedBase(SpCountedBase const&) = delete;
+    SpCountedBase& operator=(SpCountedBase const&) = delete;
+
+    // fetch_add on the use count. Instrumented builds first try a CAS against
+    // the value just read and count a failed CAS as a contended update.
+    int FetchAdd(std::atomic<int>& count, int n, std::memory_order order) {
+#ifdef TINY_STD_SP_INSTRUMENT
+        int old = count.load(std::memory_order_relaxed);
+        if (count.compare_exchange_strong(old, old + n, order, std::memory_order_relaxed))
+            return old;
+        InstrumentContended();
+#endif
+        return count.fetch_add(n, order);
+    }
+
+    const SpCountedOps<Lp>* ops_;
+    // Adjacent and aligned as one double word for the Release() fast path.
+    alignas(long long) std::atomic<int> use_cnt_;
+    std::atomic<int> weak_cnt_;
+};
+
+template <>
+inline void SpCountedBase<SINGLE>::AddRefCopy() {
+    CheckThread();
+    TINY_STD_SP_HOOK(InstrumentCopy(1));
+    ExchangeAndAddSingle(use_cnt_, 1);
+}
+
+template <>
+inline bool SpCountedBase<SINGLE>::AddRefLock() {
+    CheckThread();
+    if (use_cnt_.load(std::memory_order_relaxed) == 0)
+        return false;
+    ExchangeAndAddSingle(use_cnt_, 1);
+    TINY_STD_SP_HOOK(InstrumentCopy(1));
+    return true;
+}
+
+template <>
+inline void SpCountedBase<SINGLE>::Release() {
+    CheckThread();
+    TINY_STD_SP_HOOK(InstrumentRelease(1));
+    if (ExchangeAndAddSingle(use_cnt_, -1) == 1) {
+        ReleaseLastUse();
+    }
+}
+
+template <>
+inline void SpCountedBase<SINGLE>::AddRefCopyN(int n) {
+    CheckThread();
+    TINY_STD_SP_HOOK(InstrumentCopy(n));
+    ExchangeAndAddSingle(use_cnt_, n);
+}
+
+template <>
+inline void SpCountedBase<SINGLE>::ReleaseN(int n) {
+    CheckThread();
+    TINY_STD_SP_HOOK(InstrumentRelease(n));
+    if (ExchangeAndAddSingle(use_cnt_, -n) == n) {
+        ReleaseLastUse();
+    }
+}
+
+template <>
+inline void SpCountedBase<SINGLE>::WeakAddRef() {
+    CheckThread();
+    TINY_STD_SP_HOOK(InstrumentWeakCopy());
+    ExchangeAndAddSingle(weak_cnt_, 1);
+}
+
+template <>
+inline void SpCountedBase<SINGLE>::WeakRelease() {
+    CheckThread();
+    TINY_STD_SP_HOOK(InstrumentWeakRelease());
+    if (ExchangeAndAddSingle(weak_cnt_, -1) == 1) {
+        Destroy();
+    }
+}
+
+template <>
+inline int SpCountedBase<SINGLE>::GetUseCnt() const {
+    return use_cnt_.load(std::memory_order_relaxed);
+}
+
+template <>
+inline void SpCountedBase<MUTEX>::AddRefCopy() {
+    TINY_STD_SP_HOOK(InstrumentCopy(1));
+    std::lock_guard<std::mutex> lock(mutex_);
+    ExchangeAndAddSingle(use_cnt_, 1);
+}
+
+template <>
+inline bool SpCountedBase<MUTEX>::AddRefLock() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (use_cnt_.load(std::memory_order_relaxed) == 0)
+        return false;
+    ExchangeAndAddSingle(use_cnt_, 1);
+    TINY_STD_SP_HOOK(InstrumentCopy(1));
+    return true;
+}
+
+template <>
+inline void SpCountedBase<MUTEX>::Release() {
+    TINY_STD_SP_HOOK(InstrumentRelease(1));
+    bool last_use;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        last_use = ExchangeAndAddSingle(use_cnt_, -1) == 1;
+    }
+    if (last_use) {
+        ReleaseLastUse();
+    }
+}
+
+template <>
+inline void SpCountedBase<MUTEX>::AddRefCopyN(int n) {
+    TINY_STD_SP_HOOK(InstrumentCopy(n));
+    std::lock_guard<std::mutex> lock(mutex_);
+    ExchangeAndAddSingle(use_cnt_, n);
+}
+
+template <>
+inline void SpCountedBase<MUTEX>::ReleaseN(int n) {
+    TINY_STD_SP_HOOK(InstrumentRelease(n));
+    bool last_use;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        last_use = ExchangeAndAddSingle(use_cnt_, -n) == n;
+    }
+    if (last_use) {
+        ReleaseLastUse();
+    }
+}
+
+template <>
+inline void SpCountedBase<MUTEX>::WeakAddRef() {
+    TINY_STD_SP_HOOK(InstrumentWeakCopy());
+    std::lock_guard<std::mutex> lock(mutex_);
+    ExchangeAndAddSingle(weak_cnt_, 1);
+}
+
+template <>
+inline void SpCountedBase<MUTEX>::WeakRelease() {
+    TINY_STD_SP_HOOK(InstrumentWeakRelease());
+    bool last_weak;
+    {
+        // Destroy() frees the mutex, so it must be unlocked first.
+        std::lock_guard<std::mutex> lock(mutex_);
+        last_weak = ExchangeAndAddSingle(weak_cnt_, -1) == 1;
+    }
+    if (last_weak) {
+        Destroy();
+    }
+}
+
+template <>
+inline int SpCountedBase<MUTEX>::GetUseCnt() const {
+    return use_cnt_.load(std::memory_order_relaxed);
+}
+
+template <>
+class SpCountedBase<BIASED>;
+
+/**
+ *  Per-thread record of the BIASED policy: the blocks the thread owns and the
+ *  blocks other threads have asked it to merge. Only the owning thread touches
+ *  the record, except for the merge queue, which is guarded by QueueMutex().
+ */
+class SpBiasedOwner {
+public:
+    using Block = SpCountedBase<BIASED>;
+
+    // Null until the calling thread creates its first BIASED block.
+    static SpBiasedOwner* Current() {
+        return current_;
+    }
+
+    static SpBiasedOwner* Attach() {
+        thread_local SpBiasedOwner record;
+        current_ = &record;
+        return &record;
+    }
+
+    // Merge the blocks other threads have queued with us.
+    void Collect();
+
+    bool Pending() const {
+        return pending_.load(std::memory_order_relaxed);
+    }
+
+private:
+    friend class SpCountedBase<BIASED>;
+
+    SpBiasedOwner() = default;
+
+    // Merges every block the thread still owns.
+    ~SpBiasedOwner();
+
+    static std::mutex& QueueMutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    static inline thread_local SpBiasedOwner* current_ = nullptr;
+
+    Block* owned_ = nullptr;
+    std::vector<Block*> queue_;
+    std::atomic<bool> pending_{false};
+};
+
+/**
+ *  Biased reference counting. The thread that creates the block owns it and
+ *  counts its references in biased_ with plain loads and stores; all other
+ *  threads update the atomic shared_ word. Once the owner's count drops to
+ *  zero the two are merged, and from then on the block counts like ATOMIC.
+ *
+ *  A reference the owner handed to another thread is released into shared_,
+ *  which can go negative while the owner still holds the matching biased
+ *  count. The thread that first takes shared_ below zero queues the block with
+ *  its owner, which merges it on its next biased_collect() or make_shared of a
+ *  BIASED block, and at the latest when it exits.
+ */
+template <>
+class SpCountedBase<BIASED>
+#ifdef TINY_STD_SP_INSTRUMENT
+    : public SpInstrumentState
+#endif
+{
+protected:
+    // A block that starts without references has no owner reference whose
+    // release would trigger the merge, so it starts out merged.
+    explicit SpCountedBase(const SpCountedOps<BIASED>* ops, int use_cnt = 1)
+        : ops_(ops),
+          owner_(nullptr),
+          biased_(use_cnt > 0 ? use_cnt : 0),
+          shared_(use_cnt > 0 ? 0 : MERGED),
+          weak_cnt_(1) {
+        if (use_cnt > 0)
+            Adopt();
+    }
+
+    // Still owned only when a derived constructor threw, on the owner thread.
+    ~SpCountedBase() {
+        if (SpBiasedOwner* owner = owner_.load(std::memory_order_relaxed))
+            Unlink(owner);
+    }
+
+public:
+    void Dispose() {
+        ops_->dispose(this);
+    }
+
+    void Destroy() {
+        ops_->destroy(this);
+    }
+
+    void* GetDeleter(SpTypeId ti) {
+        return ops_->get_deleter(this, ti);
+    }
+
+    void AddRefCopy() {
+        AddRefCopyN(1);
+    }
+
+    void AddRefCopyN(int n) {
+        TINY_STD_SP_HOOK(InstrumentCopy(n));
+        if (IsOwner())
+            ExchangeAndAddSingle(biased_, n);
+        else
+            shared_.fetch_add(n * ONE, std::memory_order_relaxed);
+    }
+
+    bool AddRefLock() {
+        if (IsOwner()) {
+            // Unmerged, so the owner still holds a count.
+            ExchangeAndAddSingle(biased_, 1);
+            TINY_STD_SP_HOOK(InstrumentCopy(1));
+            return true;
+        }
+        long old = shared_.load(std::memory_order_relaxed);
+        do {
+            if ((old & MERGED) && old < ONE)
+                return false;
+        } while (!shared_.compare_exchange_weak(old, old + ONE, std::memory_order_relaxed, std::memory_order_relaxed));
+        TINY_STD_SP_HOOK(InstrumentCopy(1));
+        return true;
+    }
+
+    void Release() {
+        ReleaseN(1);
+    }
+
+    void ReleaseN(int n) {
+        TINY_STD_SP_HOOK(InstrumentRelease(n));
+        if (IsOwner()) {
+            if (ExchangeAndAddSingle(biased_, -n) == n)
+                Merge(owner_.load(std::memory_order_relaxed));
+            return;
+        }
+        ReleaseShared(n);
+    }
+
+    void ReleaseLastUse() {
+        TINY_STD_SP_HOOK(InstrumentDispose());
+        Dispose();
+        WeakRelease();
+    }
+
+    __attribute__((__noinline__)) void ReleaseLastUseCold() {
+        ReleaseLastUse();
+    }
+
+    void WeakAddRef() {
+        TINY_STD_SP_HOOK(InstrumentWeakCopy());
+        weak_cnt_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void WeakRelease() {
+        TINY_STD_SP_HOOK(InstrumentWeakRelease());
+        if (weak_cnt_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            Destroy();
+        }
+    }
+
+    int GetUseCnt() const {
+        return biased_.load(std::memory_order_relaxed) + static_cast<int>(shared_.load(std::memory_order_relaxed) >> 2);
+    }
+
+private:
+    friend class SpBiasedOwner;
+
+    SpCountedBase(SpCountedBase const&) = delete;
+    SpCountedBase& operator=(SpCountedBase const&) = delete;
+
+    // shared_ holds the count above two flag bits.
+    static constexpr long MERGED = 1;
+    static constexpr long QUEUED = 2;
+    static constexpr long ONE = 4;
+
+    bool IsOwner() const {
+        SpBiasedOwner* self = SpBiasedOwner::Current();
+        return self != nullptr && owner_.load(std::memory_order_relaxed) == self;
+    }
+
+    void Adopt() {
+        SpBiasedOwner* owner = SpBiasedOwner::Current();
+        if (owner == nullptr)
+            owner = SpBiasedOwner::Attach();
+        else if (owner->Pending())
+            owner->Collect();
+        owner_.store(owner, std::memory_order_relaxed);
+        owned_next_ = owner->owned_;
+        if (owned_next_ != nullptr)
+            owned_next_->owned_prev_ = this;
+        owner->owned_ = this;
+    }
+
+    void Unlink(SpBiasedOwner* owner) {
+        if (owned_prev_ != nullptr)
+            owned_prev_->owned_next_ = owned_next_;
+        else
+            owner->owned_ = owned_next_;
+        if (owned_next_ != nullptr)
+            owned_next_->owned_prev_ = owned_prev_;
+        owner_.store(nullptr, std::memory_order_relaxed);
+    }
+
+    // Runs on the owner thread: fold biased_ into shared_ and stop being owned.
+    void Merge(SpBiasedOwner* owner) {
+        Unlink(owner);
+
+        int biased = biased_.load(std::memory_order_relaxed);
+        biased_.store(0, std::memory_order_relaxed);
+        long old = shared_.fetch_add(biased * ONE + MERGED, std::memory_order_acq_rel);
+        if ((old >> 2) + biased == 0)
+            ReleaseLastUse();
+    }
+
+    void ReleaseShared(int n) {
+        long old = shared_.load(std::memory_order_relaxed);
+        if (old & MERGED) {
+            // MERGED never goes away again.
+            if ((shared_.fetch_sub(n * ONE, std::memory_order_acq_rel) >> 2) == n)
+                ReleaseLastUseCold();
+            return;
+        }
+        bool queue = false;
+        bool weak = false;
+        long desired;
+        do {
+            desired = old - n * ONE;
+            queue = !(old & (MERGED | QUEUED)) && desired < 0;
+            if (queue) {
+                desired |= QUEUED;
+                // Keeps the block's memory alive until its owner has seen it.
+                if (!weak) {
+                    weak_cnt_.fetch_add(1, std::memory_order_relaxed);
+                    weak = true;
+                }
+            }
+        } while (!TryUpdateShared(old, desired));
+
+        if ((desired & MERGED) && (desired >> 2) == 0)
+            ReleaseLastUseCold();
+        if (queue)
+            QueueWithOwner();
+        else if (weak)
+            WeakRelease();
+    }
+
+    bool TryUpdateShared(long& old, long desired) {
+        if (shared_.compare_exchange_weak(old, desired, std::memory_order_acq_rel, std::memory_order_relaxed))
+            return true;
+        TINY_STD_SP_HOOK(InstrumentContended());
+        return false;
+    }
+
+    __attribute__((__noinline__)) void QueueWithOwner() {
+        {
+            std::lock_guard<std::mutex> lock(SpBiasedOwner::QueueMutex());
+            if (SpBiasedOwner* owner = owner_.load(std::memory_order_relaxed)) {
+                owner->queue_.push_back(this);
+                owner->pending_.store(true, std::memory_order_relaxed);
+                return;
+            }
+        }
+        // Already merged; the merge has accounted for our release.
+        WeakRelease();
+    }
+
+    const SpCountedOps<BIASED>* ops_;
+    std::atomic<SpBiasedOwner*> owner_;
+    std::atomic<int> biased_;
+    std::atomic<long> shared_;
+    std::atomic<int> weak_cnt_;
+
+    // Intrusive list of the blocks an SpBiasedOwner owns.
+    SpCountedBase* owned_prev_ = nullptr;
+    SpCountedBase* owned_next_ = nullptr;
+};
+
+inline void SpBiasedOwner::Collect() {
+    std::vector<Block*> queue;
+    {
+        std::lock_guard<std::mutex> lock(QueueMutex());
+        queue.swap(queue_);
+        pending_.store(false, std::memory_order_relaxed);
+    }
+    for (Block* block : queue) {
+        if (block->owner_.load(std::memory_order_relaxed) == this)
+            block->Merge(this);
+        block->WeakRelease();
+    }
+}
+
+inline SpBiasedOwner::~SpBiasedOwner() {
+    current_ = nullptr;
+    {
+        // Once no block names us as owner, nothing can be queued with us.
+        std::lock_guard<std::mutex> lock(QueueMutex());
+        for (Block* block = owned_; block != nullptr; block = block->owned_next_)
+            block->owner_.store(nullptr, std::memory_order_relaxed);
+    }
+    while (owned_ != nullptr)
+        owned_->Merge(this);
+    Collect();
+}
+
+template <typename Tp, LockPolicy Lp = DEFAULT_LOCK_POLICY>
+class SharedPtr;
+
+template <typename Tp, LockPolicy Lp = DEFAULT_LOCK_POLICY>
+class WeakPtr;
+
+template <typename Tp>
+class weak_ptr;
+
+template <typename Tp, LockPolicy Lp = DEFAULT_LOCK_POLICY>
+class EnableSharedFromThis;
+
+template <typename Value>
+class SpAtomic;
+
+struct SpAccess;
+
+template <typename Tp, LockPolicy Lp = DEFAULT_LOCK_POLICY, typename Alloc, typename... Args>
+SharedPtr<Tp, Lp> AllocateShared(const Alloc& a, Args&&... args);
+
+template <typename Tp>
+class enable_shared_from_this;
+
+template <typename Tp>
+class enable_local_shared_from_this;
+
+template <LockPolicy Lp = DEFAULT_LOCK_POLICY>
+class WeakCount;
+
+template <LockPolicy Lp = DEFAULT_LOCK_POLICY>
+class SharedCount;
+
+template <typename Ptr, LockPolicy Lp>
+class SpCountedPtr final : public SpCountedBase<Lp> {
+public:
+    explicit SpCountedPtr(Ptr p) : SpCountedBase<Lp>(&SpCountedOpsOf<SpCountedPtr, Lp>::TABLE), ptr_(p) {}
+
+    void Dispose() {
+        if constexpr (!std::is_same<Ptr, nullptr_t>::value)
+            delete ptr_;
+    }
+
+    void Destroy() {
+        delete this;
+    }
+
+    void* GetDeleter(SpTypeId) {
+        return nullptr;
+    }
+
+    SpCountedPtr(const SpCountedPtr&) = delete;
+    SpCountedPtr& operator=(const SpCountedPtr&) = delete;
+
+private:
+    Ptr ptr_;
+};
+
+// Tag type used to select the make_shared / allocate_shared constructors.
+template <typename Alloc>
+struct SpAllocShared {
+    const Alloc& alloc_;
+};
+
+// Tag for the make_shared forms that default-initialize (for_overwrite).
+struct SpForOverwrite {};
+
+// Tag for the array forms of make_shared: n_ elements of the array's element type.
+template <typename Alloc>
+struct SpAllocSharedArray {
+    const Alloc& alloc_;
+    std::size_t n_;
+};
+
+template <typename Tp>
+struct SpIsAllocShared : std::false_type {};
+
+template <typename Alloc>
+struct SpIsAllocShared<SpAllocShared<Alloc>> : std::true_type {};
+
+template <typename Alloc>
+struct SpIsAllocShared<SpAllocSharedArray<Alloc>> : std::true_type {};
+
+/**
+ *  Control block used by make_shared / allocate_shared. The managed object
+ *  lives in the same allocation as the reference counts, so creating it
+ *  costs a single call to the allocator.
+ */
+template <typename Tp, typename Alloc, LockPolicy Lp>
+class SpCountedPtrInplace final : public SpCountedBase<Lp> {
+    using TpAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Tp>;
+    using TpAllocTraits = std::allocator_traits<TpAlloc>;
+
+    // Inherit from the allocator so that an empty one takes no space.
+    class Impl : private TpAlloc {
+    public:
+        explicit Impl(const TpAlloc& a) : TpAlloc(a) {}
+
+        TpAlloc& GetAlloc() {
+            return *this;
+        }
+
+        alignas(Tp) unsigned char storage_[sizeof(Tp)];
+    };
+
+public:
+    using BlockAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<SpCountedPtrInplace>;
+    using BlockAllocTraits = std::allocator_traits<BlockAlloc>;
+
+    template <typename... Args>
+    SpCountedPtrInplace(const Alloc& a, Args&&... args)
+        : SpCountedBase<Lp>(&SpCountedOpsOf<SpCountedPtrInplace, Lp>::TABLE), impl_(TpAlloc(a)) {
+        TpAllocTraits::construct(impl_.GetAlloc(), GetPtr(), std::forward<Args>(args)...);
+    }
+
+    SpCountedPtrInplace(const Alloc& a, SpForOverwrite)
+        : SpCountedBase<Lp>(&SpCountedOpsOf<SpCountedPtrInplace, Lp>::TABLE), impl_(TpAlloc(a)) {
+        ::new (static_cast<void*>(GetPtr())) Tp;
+    }
+
+    void Dispose() {
+        TpAllocTraits::destroy(impl_.GetAlloc(), GetPtr());
+    }
+
+    void Destroy() {
+        BlockAlloc a(impl_.GetAlloc());
+        this->~SpCountedPtrInplace();
+        BlockAllocTraits::deallocate(a, this, 1);
+    }
+
+    void* GetDeleter(SpTypeId) {
+        return nullptr;
+    }
+
+    Tp* GetPtr() {
+        return reinterpret_cast<Tp*>(impl_.storage_);
+    }
+
+    SpCountedPtrInplace(const SpCountedPtrInplace&) = delete;
+    SpCountedPtrInplace& operator=(const SpCountedPtrInplace&) = delete;
+
+private:
+    Impl impl_;
+};
+
+// Holds a Tp, as a private base when that lets an empty Tp take no space. N
+// tells apart two helpers for the same type in one class.
+template <int N, typename Tp, bool UseEbo = std::is_empty<Tp>::value && !std::is_final<Tp>::value>
+class SpEboHelper;
+
+template <int N, typename Tp>
+class SpEboHelper<N, Tp, true> : private Tp {
+public:
+    explicit SpEboHelper(const Tp& tp) : Tp(tp) {}
+
+    explicit SpEboHelper(Tp&& tp) : Tp(std::move(tp)) {}
+
+    static Tp& Get(SpEboHelper& eboh) {
+        return static_cast<Tp&>(eboh);
+    }
+};
+
+template <int N, typename Tp>
+class SpEboHelper<N, Tp, false> {
+public:
+    explicit SpEboHelper(const Tp& tp) : tp_(tp) {}
+
+    explicit SpEboHelper(Tp&& tp) : tp_(std::move(tp)) {}
+
+    static Tp& Get(SpEboHelper& eboh) {
+        return eboh.tp_;
+    }
+
+private:
+    Tp tp_;
+};
+
+/**
+ *  Control block for a pointer with a custom deleter (and allocator). Empty
+ *  deleters and allocators are stored as bases and take no space.
+ */
+template <typename Ptr, typename Deleter, typename Alloc, LockPolicy Lp>
+class SpCountedDeleter final : public SpCountedBase<Lp> {
+    class Impl : SpEboHelper<0, Deleter>, SpEboHelper<1, Alloc> {
+        using DelBase = SpEboHelper<0, Deleter>;
+        using AllocBase = SpEboHelper<1, Alloc>;
+
+    public:
+        Impl(Ptr p, Deleter d, const Alloc& a) : DelBase(std::move(d)), AllocBase(a), ptr_(p) {}
+
+        Deleter& GetDeleter() {
+            return DelBase::Get(*this);
+        }
+
+        Alloc& GetAlloc() {
+            return AllocBase::Get(*this);
+        }
+
+        Ptr ptr_;
+    };
+
 public:
-    SpCountedBase() : use_cnt_(1), weak_cnt_(1) {}
+    using BlockAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<SpCountedDeleter>;
+    using BlockAllocTraits = std::allocator_traits<BlockAlloc>;
 
-    virtual ~SpCountedBase() {}
+    SpCountedDeleter(Ptr p, Deleter d, const Alloc& a)
+        : SpCountedBase<Lp>(&SpCountedOpsOf<SpCountedDeleter, Lp>::TABLE), impl_(p, std::move(d), a) {}
+
+    void Dispose() {
+        impl_.GetDeleter()(impl_.ptr_);
+    }
 
-    virtual void Dispose() = 0;
+    void Destroy() {
+        BlockAlloc a(impl_.GetAlloc());
+        this->~SpCountedDeleter();
+        BlockAllocTraits::deallocate(a, this, 1);
+    }
 
-    virtual void Destroy() {
-        delete this;
+    void* GetDeleter(SpTypeId ti) {
+        return ti == SpTypeIdOf<Deleter>() ? std::addressof(impl_.GetDeleter()) : nullptr;
     }
 
-    virtual void* GetDeleter(const std::type_info&) = 0;
+    SpCountedDeleter(const SpCountedDeleter&) = delete;
+    SpCountedDeleter& operator=(const SpCountedDeleter&) = delete;
 
-    void AddRefCopy() {
-        use_cnt_++;
+private:
+    Impl impl_;
+};
+
+// Allocation unit of SpCountedArrayInplace, aligned for the block and the elements.
+template <std::size_t Align>
+struct alignas(Align) SpArrayUnit {
+    unsigned char bytes_[Align];
+};
+
+// How SpCountedArrayInplace initializes element i.
+struct SpArrayValueInit {
+    template <typename ElemAlloc, typename Elem>
+    void operator()(ElemAlloc& a, Elem* p, std::size_t) const {
+        std::allocator_traits<ElemAlloc>::construct(a, p);
     }
+};
 
-    bool AddRefLock() {
-        // if (use_cnt_.fetch_add(1) == 0)
-        if (use_cnt_++ == 0)
-            return false;
-        return true;
+struct SpArrayDefaultInit {
+    template <typename ElemAlloc, typename Elem>
+    void operator()(ElemAlloc&, Elem* p, std::size_t) const {
+        ::new (static_cast<void*>(p)) Elem;
     }
+};
 
-    void Release() {
-        // if (use_cnt_.fetch_sub(1) == 1) {
-        if (--use_cnt_ == 0) {
-            ReleaseLastUse();
-        }
+// Copies a pattern of n_ elements over and over, for make_shared<T[][N]>(n, u).
+template <typename Elem>
+struct SpArrayFillInit {
+    template <typename ElemAlloc>
+    void operator()(ElemAlloc& a, Elem* p, std::size_t i) const {
+        std::allocator_traits<ElemAlloc>::construct(a, p, pattern_[i % n_]);
     }
 
-    void ReleaseLastUse() {
-        Dispose();
-        // if (weak_cnt_.fetch_sub(1) == 1) {
-        if (--weak_cnt_ == 0) {
-            Destroy();
+    const Elem* pattern_;
+    std::size_t n_;
+};
+
+/**
+ *  Control block of the array forms of make_shared. The element count is
+ *  kept in the block and the elements follow it in the same allocation.
+ *  Multidimensional arrays are handled as a flat array of their innermost
+ *  element type.
+ */
+template <typename Elem, typename Alloc, LockPolicy Lp>
+class SpCountedArrayInplace final : public SpCountedBase<Lp> {
+    using ElemAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Elem>;
+    using ElemAllocTraits = std::allocator_traits<ElemAlloc>;
+
+    class Impl : private ElemAlloc {
+    public:
+        Impl(const ElemAlloc& a, std::size_t n) : ElemAlloc(a), n_(n) {}
+
+        ElemAlloc& GetAlloc() {
+            return *this;
         }
+
+        std::size_t n_;
+    };
+
+    SpCountedArrayInplace(const ElemAlloc& a, std::size_t n)
+        : SpCountedBase<Lp>(&SpCountedOpsOf<SpCountedArrayInplace, Lp>::TABLE), impl_(a, n) {}
+
+public:
+    // The elements are built before the block, which therefore never has to
+    // be torn down half constructed.
+    template <typename Init>
+    static SpCountedArrayInplace* Create(const Alloc& a, std::size_t n, Init init) {
+        using UnitAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<SpArrayUnit<Align()>>;
+        using UnitAllocTraits = std::allocator_traits<UnitAlloc>;
+        UnitAlloc unit_alloc(a);
+        ElemAlloc elem_alloc(a);
+        std::size_t units = Units(n);
+        auto mem = UnitAllocTraits::allocate(unit_alloc, units);
+        Elem* p = ElementsOf(mem);
+        std::size_t i = 0;
+        try {
+            for (; i < n; ++i) init(elem_alloc, p + i, i);
+        } catch (...) {
+            while (i != 0) ElemAllocTraits::destroy(elem_alloc, p + --i);
+            UnitAllocTraits::deallocate(unit_alloc, mem, units);
+            throw;
+        }
+        return ::new (static_cast<void*>(mem)) SpCountedArrayInplace(elem_alloc, n);
     }
 
-    void ReleaseLastUseCold() {
-        ReleaseLastUse();
+    void Dispose() {
+        Elem* p = GetPtr();
+        for (std::size_t i = impl_.n_; i != 0;) ElemAllocTraits::destroy(impl_.GetAlloc(), p + --i);
     }
 
-    void WeakAddRef() {
-        weak_cnt_++;
+    void Destroy() {
+        using UnitAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<SpArrayUnit<Align()>>;
+        using UnitAllocTraits = std::allocator_traits<UnitAlloc>;
+        UnitAlloc unit_alloc(impl_.GetAlloc());
+        std::size_t units = Units(impl_.n_);
+        auto mem = reinterpret_cast<typename UnitAllocTraits::pointer>(this);
+        this->~SpCountedArrayInplace();
+        UnitAllocTraits::deallocate(unit_alloc, mem, units);
     }
 
-    void WeakRelease() {
-        // if (weak_cnt_.fetch_sub(1) == 1) {
-        if (--weak_cnt_ == 0) {
-            Destroy();
-        }
+    void* GetDeleter(SpTypeId) {
+        return nullptr;
     }
 
-    int GetUseCnt() const {
-        return use_cnt_;
+    Elem* GetPtr() {
+        return ElementsOf(this);
     }
 
+    SpCountedArrayInplace(const SpCountedArrayInplace&) = delete;
+    SpCountedArrayInplace& operator=(const SpCountedArrayInplace&) = delete;
+
 private:
-    SpCountedBase(SpCountedBase const&) = delete;
-    SpCountedBase& operator=(SpCountedBase const&) = delete;
+    static constexpr std::size_t Align() {
+        return alignof(Elem) > alignof(SpCountedArrayInplace) ? alignof(Elem) : alignof(SpCountedArrayInplace);
+    }
 
-    std::atomic<int> use_cnt_;
-    std::atomic<int> weak_cnt_;
-};
+    static constexpr std::size_t Offset() {
+        return (sizeof(SpCountedArrayInplace) + alignof(Elem) - 1) / alignof(Elem) * alignof(Elem);
+    }
 
-template <typename Tp>
-class SharedPtr;
+    static std::size_t Units(std::size_t n) {
+        return (Offset() + n * sizeof(Elem) + Align() - 1) / Align();
+    }
 
-template <typename Tp>
-class WeakPtr;
+    template <typename Mem>
+    static Elem* ElementsOf(Mem* mem) {
+        return reinterpret_cast<Elem*>(reinterpret_cast<char*>(mem) + Offset());
+    }
 
-template <typename Tp>
-class weak_ptr;
+    Impl impl_;
+};
 
-template <typename Tp>
-class EnableSharedFromThis;
+/**
+ *  Control block for objects created by make_unique_shareable. That function
+ *  allocates room for this block in front of the object but leaves it
+ *  unconstructed; it is only built, in place, when the unique_ptr is handed
+ *  to a SharedPtr.
+ */
+template <typename Tp, LockPolicy Lp>
+class SpCountedShareable final : public SpCountedBase<Lp> {
+public:
+    SpCountedShareable() : SpCountedBase<Lp>(&SpCountedOpsOf<SpCountedShareable, Lp>::TABLE) {}
 
-template <typename Tp>
-class enable_shared_from_this;
+    void Dispose() {
+        GetPtr()->~Tp();
+    }
 
-class WeakCount;
+    void Destroy() {
+        this->~SpCountedShareable();
+        Deallocate(this);
+    }
+
+    void* GetDeleter(SpTypeId) {
+        return nullptr;
+    }
 
-// TODO:
-// class SpCountedDeleter {};
+    Tp* GetPtr() {
+        return reinterpret_cast<Tp*>(reinterpret_cast<char*>(this) + Offset());
+    }
 
-template <typename Ptr>
-class SpCountedPtr final : public SpCountedBase {
-public:
-    explicit SpCountedPtr(Ptr p) : ptr_(p) {}
+    // Where the object starts, relative to the block.
+    static constexpr std::size_t Offset() {
+        return (sizeof(SpCountedShareable) + alignof(Tp) - 1) / alignof(Tp) * alignof(Tp);
+    }
 
-    void Dispose() override {
-        delete ptr_;
+    static constexpr std::size_t Align() {
+        return alignof(Tp) > alignof(SpCountedShareable) ? alignof(Tp) : alignof(SpCountedShareable);
     }
 
-    void Destroy() override {
-        delete this;
+    static void* Allocate() {
+        return ::operator new(Offset() + sizeof(Tp), std::align_val_t(Align()));
     }
 
-    void* GetDeleter(const std::type_info&) override {
-        return nullptr;
+    static void Deallocate(void* mem) {
+        ::operator delete(mem, std::align_val_t(Align()));
     }
 
-    SpCountedPtr(const SpCountedPtr&) = delete;
-    SpCountedPtr& operator=(const SpCountedPtr&) = delete;
+    static void* FromObject(Tp* p) {
+        return reinterpret_cast<char*>(p) - Offset();
+    }
 
-private:
-    Ptr ptr_;
+    SpCountedShareable(const SpCountedShareable&) = delete;
+    SpCountedShareable& operator=(const SpCountedShareable&) = delete;
 };
 
-template <>
-inline void SpCountedPtr<nullptr_t>::Dispose() {}
+/**
+ *  @brief Deleter of the unique_ptrs returned by make_unique_shareable.
+ *
+ *  Only valid for pointers obtained from make_unique_shareable<Tp, Lp>.
+ */
+template <typename Tp, LockPolicy Lp = DEFAULT_LOCK_POLICY>
+struct shareable_delete {
+    void operator()(Tp* p) const {
+        using Block = SpCountedShareable<Tp, Lp>;
+        p->~Tp();
+        Block::Deallocate(Block::FromObject(p));
+    }
+};
+
+template <typename Tp, LockPolicy Lp = DEFAULT_LOCK_POLICY>
+using shareable_unique_ptr = unique_ptr<Tp, shareable_delete<Tp, Lp>>;
+
+/**
+ *  @brief Create a uniquely owned object with room reserved for a control
+ *  block, so that moving it into a SharedPtr<Tp, Lp> does not allocate.
+ */
+template <typename Tp, LockPolicy Lp = DEFAULT_LOCK_POLICY, typename... Args>
+inline shareable_unique_ptr<Tp, Lp> make_unique_shareable(Args&&... args) {
+    static_assert(!std::is_array<Tp>::value, "make_unique_shareable<T[]> not supported");
+    using Block = SpCountedShareable<Tp, Lp>;
+    void* mem = Block::Allocate();
+    Tp* p;
+    try {
+        p = ::new (static_cast<void*>(static_cast<char*>(mem) + Block::Offset())) Tp(std::forward<Args>(args)...);
+    } catch (...) {
+        Block::Deallocate(mem);
+        throw;
+    }
+    return shareable_unique_ptr<Tp, Lp>(p);
+}
+
+// Tag for adopting a control block that already holds one strong reference.
+struct SpAdoptCount {};
 
 struct SpArrayDelete {
     template <typename Yp>
@@ -139,13 +1203,18 @@ struct SpArrayDelete {
     }
 };
 
+template <LockPolicy Lp>
 class SharedCount {
 public:
     SharedCount() : pi_(0) {}
 
+    template <typename Block>
+    SharedCount(Block* pi, SpAdoptCount) : pi_(pi) {}
+
     template <typename Ptr>
     explicit SharedCount(Ptr p) : pi_(0) {
-        pi_ = new SpCountedPtr<Ptr>(p);
+        pi_ = new SpCountedPtr<Ptr, Lp>(p);
+        TINY_STD_SP_HOOK(InstrumentAttach<typename std::remove_pointer<Ptr>::type>(1));
     }
 
     template <typename Ptr>
@@ -154,20 +1223,92 @@ public:
     template <typename Ptr>
     SharedCount(Ptr p, std::true_type) : SharedCount(p, SpArrayDelete{}) {}
 
-    template <typename Ptr, typename Deleter>
-    SharedCount(Ptr p, Deleter d) : SharedCount(p, std::move(d)) {}
-
-    // TODO: constructor for unique_ptr
-    // template <typename Tp, typename Del>
-    // explicit SharedCount(tiny_std::unique_ptr<Tp, Del>&& r) : pi_(0) {
-    //     if (r.get() == nullptr)
-    //         return;
-    // }
-
-    // template <typename Tp, typename Del>
-    // explicit SharedCount(tiny_std::unique_ptr<Tp, Del>&& r)
-
-    explicit SharedCount(const WeakCount& r);
+    template <typename Deleter>
+    using NotAllocShared = typename std::enable_if<!SpIsAllocShared<Deleter>::value>::type;
+
+    template <typename Ptr, typename Deleter, typename = NotAllocShared<Deleter>>
+    SharedCount(Ptr p, Deleter d) : SharedCount(p, std::move(d), std::allocator<void>()) {}
+
+    // If the control block cannot be allocated, p is deleted before rethrowing.
+    template <typename Ptr, typename Deleter, typename Alloc, typename = NotAllocShared<Deleter>>
+    SharedCount(Ptr p, Deleter d, Alloc a) : pi_(nullptr) {
+        using Block = SpCountedDeleter<Ptr, Deleter, Alloc, Lp>;
+        typename Block::BlockAlloc block_alloc(a);
+        Block* mem;
+        try {
+            mem = Block::BlockAllocTraits::allocate(block_alloc, 1);
+        } catch (...) {
+            d(p);
+            throw;
+        }
+        ::new (static_cast<void*>(mem)) Block(p, std::move(d), a);
+        pi_ = mem;
+        TINY_STD_SP_HOOK(InstrumentAttach<typename std::remove_pointer<Ptr>::type>(1));
+    }
+
+    // make_shared / allocate_shared: one allocation for the object and the counts.
+    template <typename Tp, typename Alloc, typename... Args>
+    SharedCount(Tp*& p, SpAllocShared<Alloc> a, Args&&... args) : pi_(nullptr) {
+        using Block = SpCountedPtrInplace<typename std::remove_cv<Tp>::type, Alloc, Lp>;
+        typename Block::BlockAlloc block_alloc(a.alloc_);
+        Block* mem = Block::BlockAllocTraits::allocate(block_alloc, 1);
+        try {
+            ::new (static_cast<void*>(mem)) Block(a.alloc_, std::forward<Args>(args)...);
+        } catch (...) {
+            Block::BlockAllocTraits::deallocate(block_alloc, mem, 1);
+            throw;
+        }
+        pi_ = mem;
+        p = mem->GetPtr();
+        TINY_STD_SP_HOOK(InstrumentAttach<Tp>(1));
+    }
+
+    // Array forms of make_shared: p is set to the first of n elements of Ep.
+    template <typename Ep, typename Alloc, typename Init>
+    SharedCount(Ep*& p, SpAllocSharedArray<Alloc> a, Init init) : pi_(nullptr) {
+        using Elem = typename std::remove_cv<typename std::remove_all_extents<Ep>::type>::type;
+        using Block = SpCountedArrayInplace<Elem, Alloc, Lp>;
+        constexpr std::size_t inner = sizeof(Ep) / sizeof(Elem);
+        Block* block = Block::Create(a.alloc_, a.n_ * inner, init);
+        pi_ = block;
+        p = reinterpret_cast<Ep*>(block->GetPtr());
+        TINY_STD_SP_HOOK(InstrumentAttach<Ep>(a.n_));
+    }
+
+    // The deleter moves into the control block. If allocating the block
+    // throws, r still owns the pointer.
+    template <typename Tp, typename Del>
+    explicit SharedCount(unique_ptr<Tp, Del>&& r) : pi_(nullptr) {
+        if (r.get() == nullptr)
+            return;
+        using Ptr = typename unique_ptr<Tp, Del>::pointer;
+        using Del2 = typename std::conditional<std::is_reference<Del>::value,
+                                               std::reference_wrapper<typename std::remove_reference<Del>::type>,
+                                               Del>::type;
+        using Block = SpCountedDeleter<Ptr, Del2, std::allocator<void>, Lp>;
+        typename Block::BlockAlloc block_alloc;
+        Block* mem = Block::BlockAllocTraits::allocate(block_alloc, 1);
+        ::new (static_cast<void*>(mem)) Block(r.get(), std::forward<Del>(r.get_deleter()), std::allocator<void>());
+        r.release();
+        pi_ = mem;
+        TINY_STD_SP_HOOK(InstrumentAttach<Tp>(1));
+    }
+
+    // Objects from make_unique_shareable: build the block in the reserved room.
+    template <typename Tp>
+    explicit SharedCount(unique_ptr<Tp, shareable_delete<Tp, Lp>>&& r) : pi_(nullptr) {
+        if (r.get() == nullptr)
+            return;
+        using Block = SpCountedShareable<Tp, Lp>;
+        pi_ = ::new (Block::FromObject(r.release())) Block();
+        TINY_STD_SP_HOOK(InstrumentAttach<Tp>(1));
+    }
+
+    // Throws bad_weak_ptr if r has expired.
+    explicit SharedCount(const WeakCount<Lp>& r);
+
+    // Empty instead of a count of an expired object.
+    SharedCount(const WeakCount<Lp>& r, std::nothrow_t) noexcept;
 
     ~SharedCount() {
         if (pi_ != nullptr)
@@ -181,7 +1322,7 @@ public:
     }
 
     SharedCount& operator=(const SharedCount& r) {
-        SpCountedBase* tmp = r.pi_;
+        SpCountedBase<Lp>* tmp = r.pi_;
         if (tmp != pi_) {
             if (tmp != nullptr)
                 tmp->AddRefCopy();
@@ -193,7 +1334,7 @@ public:
     }
 
     void Swap(SharedCount& r) {
-        SpCountedBase* tmp = r.pi_;
+        SpCountedBase<Lp>* tmp = r.pi_;
         r.pi_ = pi_;
         pi_ = tmp;
     }
@@ -206,24 +1347,70 @@ public:
         return GetUseCount() == 1;
     }
 
-    void* GetDeleter(const std::type_info& ti) const {
+    // Take or drop n references with one update of the use count. Each
+    // reference taken by AddRefCopyN() goes to a count made by Adopt().
+    void AddRefCopyN(int n) const {
+        if (pi_ != nullptr)
+            pi_->AddRefCopyN(n);
+    }
+
+    void ReleaseN(int n) const {
+        if (pi_ != nullptr)
+            pi_->ReleaseN(n);
+    }
+
+    SharedCount Adopt() const {
+        return SharedCount(pi_, SpAdoptCount());
+    }
+
+    // Leave the count empty without dropping its reference.
+    SpCountedBase<Lp>* Detach() {
+        SpCountedBase<Lp>* pi = pi_;
+        pi_ = nullptr;
+        return pi;
+    }
+
+    void* GetDeleter(SpTypeId ti) const {
         return pi_ ? pi_->GetDeleter(ti) : nullptr;
     }
 
+    // Ownership order and hash: by control block, not by stored pointer.
+    bool Less(const SharedCount& r) const {
+        return std::less<SpCountedBase<Lp>*>()(pi_, r.pi_);
+    }
+
+    bool Less(const WeakCount<Lp>& r) const {
+        return std::less<SpCountedBase<Lp>*>()(pi_, r.pi_);
+    }
+
+    std::size_t Hash() const {
+        return std::hash<SpCountedBase<Lp>*>()(pi_);
+    }
+
     friend inline bool operator==(const SharedCount& a, const SharedCount& b) {
         return a.pi_ == b.pi_;
     }
 
 private:
-    friend class WeakCount;
-    SpCountedBase* pi_;
+    friend class WeakCount<Lp>;
+
+#ifdef TINY_STD_SP_INSTRUMENT
+    // Report the new block as n objects of Tp.
+    template <typename Tp>
+    void InstrumentAttach(std::size_t n) {
+        pi_->InstrumentAttach(SpInstrument::StatsOf<Tp>(), n * SpInstrument::SizeOf<Tp>());
+    }
+#endif
+
+    SpCountedBase<Lp>* pi_;
 };
 
+template <LockPolicy Lp>
 class WeakCount {
 public:
     WeakCount() : pi_(nullptr) {}
 
-    WeakCount(const SharedCount& r) : pi_(r.pi_) {
+    WeakCount(const SharedCount<Lp>& r) : pi_(r.pi_) {
         if (pi_ != nullptr)
             pi_->WeakAddRef();
     }
@@ -233,7 +1420,7 @@ public:
             pi_->WeakAddRef();
     }
 
-    WeakCount(WeakCount&& r) : pi_(r.pi_) {
+    WeakCount(WeakCount&& r) noexcept : pi_(r.pi_) {
         r.pi_ = nullptr;
     }
 
@@ -242,27 +1429,27 @@ public:
             pi_->WeakRelease();
     }
 
-    WeakCount& operator=(const SharedCount& r) {
-        SpCountedBase* tmp = r.pi_;
+    WeakCount& operator=(const SharedCount<Lp>& r) {
+        SpCountedBase<Lp>* tmp = r.pi_;
         if (tmp != nullptr)
             tmp->WeakAddRef();
-        if (r.pi_ != nullptr)
-            r.pi_->WeakRelease();
+        if (pi_ != nullptr)
+            pi_->WeakRelease();
         pi_ = tmp;
         return *this;
     }
 
     WeakCount& operator=(const WeakCount& r) {
-        SpCountedBase* tmp = r.pi_;
+        SpCountedBase<Lp>* tmp = r.pi_;
         if (tmp != nullptr)
             tmp->WeakAddRef();
-        if (r.pi_ != nullptr)
-            r.pi_->WeakRelease();
+        if (pi_ != nullptr)
+            pi_->WeakRelease();
         pi_ = tmp;
         return *this;
     }
 
-    WeakCount& operator=(WeakCount&& r) {
+    WeakCount& operator=(WeakCount&& r) noexcept {
         if (pi_ != nullptr)
             pi_->WeakRelease();
         pi_ = r.pi_;
@@ -271,7 +1458,7 @@ public:
     }
 
     void Swap(WeakCount& r) {
-        SpCountedBase* tmp = r.pi_;
+        SpCountedBase<Lp>* tmp = r.pi_;
         r.pi_ = pi_;
         pi_ = tmp;
     }
@@ -280,16 +1467,35 @@ public:
         return pi_ != nullptr ? pi_->GetUseCnt() : 0;
     }
 
+    bool Less(const WeakCount& r) const {
+        return std::less<SpCountedBase<Lp>*>()(pi_, r.pi_);
+    }
+
+    bool Less(const SharedCount<Lp>& r) const {
+        return std::less<SpCountedBase<Lp>*>()(pi_, r.pi_);
+    }
+
+    std::size_t Hash() const {
+        return std::hash<SpCountedBase<Lp>*>()(pi_);
+    }
+
     friend inline bool operator==(const WeakCount& a, const WeakCount& b) {
         return a.pi_ == b.pi_;
     }
 
 private:
-    friend class SharedCount;
-    SpCountedBase* pi_;
+    friend class SharedCount<Lp>;
+    SpCountedBase<Lp>* pi_;
 };
 
-inline SharedCount::SharedCount(const WeakCount& r) : pi_(r.pi_) {
+template <LockPolicy Lp>
+inline SharedCount<Lp>::SharedCount(const WeakCount<Lp>& r) : pi_(r.pi_) {
+    if (pi_ == nullptr || !pi_->AddRefLock())
+        throw bad_weak_ptr();
+}
+
+template <LockPolicy Lp>
+inline SharedCount<Lp>::SharedCount(const WeakCount<Lp>& r, std::nothrow_t) noexcept : pi_(r.pi_) {
     if (pi_ && !pi_->AddRefLock())
         pi_ = nullptr;
 }
@@ -312,6 +1518,18 @@ struct SpCompatibleWith<Up (*)[Nm], volatile Up (*)[]> : std::true_type {};
 template <typename Up, size_t Nm>
 struct SpCompatibleWith<Up (*)[Nm], const volatile Up (*)[]> : std::true_type {};
 
+// Whether Base is a virtual (or otherwise inaccessible for a downcast) base
+// of Derived, where converting a Derived* to a Base* reads the object.
+// static_cast from such a base back down is ill-formed.
+template <typename Base, typename Derived, typename = void>
+struct SpIsVirtualBaseOf
+    : std::is_base_of<typename std::remove_cv<Base>::type, typename std::remove_cv<Derived>::type>::type {};
+
+template <typename Base, typename Derived>
+struct SpIsVirtualBaseOf<Base, Derived,
+                         std::__void_t<decltype(static_cast<typename std::remove_cv<Derived>::type*>(
+                             std::declval<typename std::remove_cv<Base>::type*>()))>> : std::false_type {};
+
 template <typename Up, size_t Nm, typename Yp, typename = void>
 struct SpIsConstructibleArrN : std::false_type {};
 
@@ -336,7 +1554,7 @@ struct SpIsConstructible<Up[], Yp> : SpIsConstructibleArr<Up, Yp>::type {};
 template <typename Tp, typename Yp>
 struct SpIsConstructible : std::is_convertible<Yp*, Tp*>::type {};
 
-template <typename Tp, bool = std::is_array<Tp>::value, bool = std::is_void<Tp>::value>
+template <typename Tp, LockPolicy Lp, bool = std::is_array<Tp>::value, bool = std::is_void<Tp>::value>
 class SharedPtrAccess {
 public:
     using element_type = Tp;
@@ -351,23 +1569,23 @@ public:
 
 private:
     element_type* Get() const {
-        return static_cast<const SharedPtr<Tp>*>(this)->Get();
+        return static_cast<const SharedPtr<Tp, Lp>*>(this)->get();
     }
 };
 
-template <typename Tp>
-class SharedPtrAccess<Tp, false, true> {
+template <typename Tp, LockPolicy Lp>
+class SharedPtrAccess<Tp, Lp, false, true> {
 public:
     using element_type = Tp;
 
     element_type* operator->() const {
-        auto ptr = static_cast<const SharedPtr<Tp>*>(this)->Get();
+        auto ptr = static_cast<const SharedPtr<Tp, Lp>*>(this)->get();
         return ptr;
     }
 };
 
-template <typename Tp>
-class SharedPtrAccess<Tp, true, false> {
+template <typename Tp, LockPolicy Lp>
+class SharedPtrAccess<Tp, Lp, true, false> {
 public:
     using element_type = typename std::remove_extent<Tp>::type;
 
@@ -377,12 +1595,12 @@ public:
 
 private:
     element_type* Get() const {
-        return static_cast<const SharedPtr<Tp>*>(this)->Get();
+        return static_cast<const SharedPtr<Tp, Lp>*>(this)->get();
     }
 };
 
-template <typename Tp>
-class SharedPtr : public SharedPtrAccess<Tp> {
+template <typename Tp, LockPolicy Lp>
+class SharedPtr : public SharedPtrAccess<Tp, Lp> {
 public:
     using element_type = typename std::remove_extent<Tp>::type;
 
@@ -406,7 +1624,7 @@ private:
     using UniqAssignable = UniqCompatible<Yp, Del, SharedPtr&>;
 
 public:
-    using weak_type = WeakPtr<Tp>;
+    using weak_type = WeakPtr<Tp, Lp>;
 
     SharedPtr() : ptr_(0), ref_count_() {}
 
@@ -420,14 +1638,22 @@ public:
         EnableSharedFromThisWith(p);
     }
 
+    template <typename Yp, typename Deleter, typename Alloc, typename = SafeConv<Yp>>
+    SharedPtr(Yp* p, Deleter d, Alloc a) : ptr_(p), ref_count_(p, std::move(d), std::move(a)) {
+        EnableSharedFromThisWith(p);
+    }
+
     template <typename Deleter>
     SharedPtr(std::nullptr_t p, Deleter d) : ptr_(0), ref_count_(p, std::move(d)) {}
 
+    template <typename Deleter, typename Alloc>
+    SharedPtr(std::nullptr_t p, Deleter d, Alloc a) : ptr_(0), ref_count_(p, std::move(d), std::move(a)) {}
+
     template <typename Yp>
-    SharedPtr(const SharedPtr<Yp>& r, element_type* p) : ptr_(p), ref_count_(r.ref_count_) {}
+    SharedPtr(const SharedPtr<Yp, Lp>& r, element_type* p) : ptr_(p), ref_count_(r.ref_count_) {}
 
     template <typename Yp>
-    SharedPtr(SharedPtr<Yp>&& r, element_type* p) : ptr_(p), ref_count_() {
+    SharedPtr(SharedPtr<Yp, Lp>&& r, element_type* p) noexcept : ptr_(p), ref_count_() {
         ref_count_.Swap(r.ref_count_);
         r.ptr_ = nullptr;
     }
@@ -437,42 +1663,49 @@ public:
     ~SharedPtr() = default;
 
     template <typename Yp, typename = Compatible<Yp>>
-    SharedPtr(const SharedPtr<Yp>& r) : ptr_(r.ptr_), ref_count_(r.ref_count_) {}
+    SharedPtr(const SharedPtr<Yp, Lp>& r) : ptr_(r.ptr_), ref_count_(r.ref_count_) {}
 
-    SharedPtr(SharedPtr&& r) : ptr_(r.ptr_), ref_count_() {
+    SharedPtr(SharedPtr&& r) noexcept : ptr_(r.ptr_), ref_count_() {
         ref_count_.Swap(r.ref_count_);
         r.ptr_ = nullptr;
     }
 
     template <typename Yp, typename = Compatible<Yp>>
-    SharedPtr(SharedPtr<Yp>&& r) : ptr_(r.ptr_), ref_count_() {
+    SharedPtr(SharedPtr<Yp, Lp>&& r) noexcept : ptr_(r.ptr_), ref_count_() {
         ref_count_.Swap(r.ref_count_);
         r.ptr_ = nullptr;
     }
 
+    // Throws bad_weak_ptr if r has expired.
     template <typename Yp, typename = Compatible<Yp>>
-    explicit SharedPtr(const WeakPtr<Yp>& r) : ref_count_(r.ref_count) {
+    explicit SharedPtr(const WeakPtr<Yp, Lp>& r) : ref_count_(r.ref_count_) {
         ptr_ = r.ptr_;
     }
 
-    // TODO: why ref_count_ in initialization list
     template <typename Yp, typename Del, typename = UniqCompatible<Yp, Del>>
     SharedPtr(unique_ptr<Yp, Del>&& r) : ptr_(r.get()), ref_count_() {
         auto raw = std::__to_address(r.get());
-        ref_count_ = SharedCount(std::move(r));
+        SharedCount<Lp> count(std::move(r));
+        ref_count_.Swap(count);
         EnableSharedFromThisWith(raw);
     }
 
     SharedPtr(nullptr_t) : SharedPtr() {}
 
     template <typename Yp>
-    Assignable<Yp> operator=(const SharedPtr<Yp>& r) {
+    Assignable<Yp> operator=(const SharedPtr<Yp, Lp>& r) {
         ptr_ = r.ptr_;
         ref_count_ = r.ref_count_;
         return *this;
     }
 
-    SharedPtr& operator=(SharedPtr&& r) {
+    SharedPtr& operator=(SharedPtr&& r) noexcept {
+        SharedPtr(std::move(r)).swap(*this);
+        return *this;
+    }
+
+    template <typename Yp>
+    Assignable<Yp> operator=(SharedPtr<Yp, Lp>&& r) noexcept {
         SharedPtr(std::move(r)).swap(*this);
         return *this;
     }
@@ -497,6 +1730,11 @@ public:
         SharedPtr(p, std::move(d)).swap(*this);
     }
 
+    template <typename Yp, typename Deleter, typename Alloc>
+    SafeConv<Yp> reset(Yp* p, Deleter d, Alloc a) {
+        SharedPtr(p, std::move(d), std::move(a)).swap(*this);
+    }
+
     element_type* get() const {
         return ptr_;
     }
@@ -513,23 +1751,112 @@ public:
         return ref_count_.GetUseCount();
     }
 
-    void swap(SharedPtr<Tp>& other) {
+    // Ownership-based order, hash and equality: two pointers compare equal
+    // when they share a control block, whatever they point to.
+    template <typename Yp>
+    bool owner_before(const SharedPtr<Yp, Lp>& r) const {
+        return ref_count_.Less(r.ref_count_);
+    }
+
+    template <typename Yp>
+    bool owner_before(const WeakPtr<Yp, Lp>& r) const {
+        return ref_count_.Less(r.ref_count_);
+    }
+
+    std::size_t owner_hash() const {
+        return ref_count_.Hash();
+    }
+
+    template <typename Yp>
+    bool owner_equal(const SharedPtr<Yp, Lp>& r) const {
+        return !ref_count_.Less(r.ref_count_) && !r.ref_count_.Less(ref_count_);
+    }
+
+    template <typename Yp>
+    bool owner_equal(const WeakPtr<Yp, Lp>& r) const {
+        return !ref_count_.Less(r.ref_count_) && !r.ref_count_.Less(ref_count_);
+    }
+
+    void swap(SharedPtr<Tp, Lp>& other) {
         std::swap(ptr_, other.ptr_);
         ref_count_.Swap(other.ref_count_);
     }
 
+    /**
+     *  @brief Write @a n copies of *this to @a out.
+     *
+     *  The n references are taken with a single update of the use count,
+     *  instead of one per copy. Release them together with release_batch().
+     */
+    template <typename OutputIt>
+    OutputIt share_n(std::size_t n, OutputIt out) const {
+        return ShareN<SharedPtr>(n, out);
+    }
+
 protected:
-    // TODO: allocate_shared
+    // share_n() for Sp, a class derived from SharedPtr that adds no state.
+    template <typename Sp, typename OutputIt>
+    OutputIt ShareN(std::size_t n, OutputIt out) const {
+        if (n == 0)
+            return out;
+        assert(n <= static_cast<std::size_t>(std::numeric_limits<int>::max()));
+        ref_count_.AddRefCopyN(static_cast<int>(n));
+        // References taken but not yet handed to a copy.
+        int pending = static_cast<int>(n);
+        try {
+            while (pending != 0) {
+                Sp copy;
+                SharedPtr& base = copy;
+                SharedCount<Lp> count = ref_count_.Adopt();
+                base.ref_count_.Swap(count);
+                base.ptr_ = ptr_;
+                --pending;
+                *out = std::move(copy);
+                ++out;
+            }
+        } catch (...) {
+            ref_count_.ReleaseN(pending);
+            throw;
+        }
+        return out;
+    }
 
-    SharedPtr(const WeakPtr<Tp>& r, std::nothrow_t) : ref_count_(r.ref_count_, std::nothrow) {
+    template <typename Alloc, typename... Args>
+    SharedPtr(SpAllocShared<Alloc> tag, Args&&... args) : ptr_(nullptr), ref_count_(ptr_, tag, std::forward<Args>(args)...) {
+        EnableSharedFromThisWith(ptr_);
+    }
+
+    template <typename Alloc, typename Init>
+    SharedPtr(SpAllocSharedArray<Alloc> tag, Init init) : ptr_(nullptr), ref_count_(ptr_, tag, init) {}
+
+    template <typename Tp1, LockPolicy Lp1, typename Alloc, typename... Args>
+    friend SharedPtr<Tp1, Lp1> AllocateShared(const Alloc& a, Args&&... args);
+
+    SharedPtr(const WeakPtr<Tp, Lp>& r, std::nothrow_t) noexcept : ref_count_(r.ref_count_, std::nothrow) {
         ptr_ = ref_count_.GetUseCount() ? r.ptr_ : nullptr;
     }
 
-    friend class WeakPtr<Tp>;
+    template <typename Tp1, LockPolicy Lp1>
+    friend class SharedPtr;
+
+    template <typename Tp1, LockPolicy Lp1>
+    friend class WeakPtr;
+
+    template <typename Value>
+    friend class SpAtomic;
+
+    friend struct SpAccess;
+
+    template <typename Del, typename Tp1, LockPolicy Lp1>
+    friend Del* get_deleter(const SharedPtr<Tp1, Lp1>& p);
+
+    void* GetDeleter(SpTypeId ti) const {
+        return ref_count_.GetDeleter(ti);
+    }
 
 private:
     template <typename Yp>
-    using esft_base_t = decltype(EnableSharedFromThisBase(std::declval<const SharedCount&>(), std::declval<Yp*>()));
+    using esft_base_t = decltype(EnableSharedFromThisBase(std::declval<const SharedCount<Lp>&>(), std::declval<Yp*>()));
 
     template <typename Yp, typename = void>
     struct HasEsftBase : std::false_type {};
@@ -548,71 +1875,104 @@ private:
 
 private:
     element_type* ptr_;
-    SharedCount ref_count_;
+    SharedCount<Lp> ref_count_;
 };
 
-template <typename Tp1, typename Tp2>
-inline bool operator==(const SharedPtr<Tp1>& a, const SharedPtr<Tp2>& b) {
-    return a.get() == a.get();
+template <typename Tp1, typename Tp2, LockPolicy Lp>
+inline bool operator==(const SharedPtr<Tp1, Lp>& a, const SharedPtr<Tp2, Lp>& b) {
+    return a.get() == b.get();
 }
 
-template <typename Tp>
-inline bool operator==(const SharedPtr<Tp>& a, nullptr_t) {
+template <typename Tp, LockPolicy Lp>
+inline bool operator==(const SharedPtr<Tp, Lp>& a, nullptr_t) {
     return !a;
 }
 
-template <typename Tp>
-inline bool operator==(nullptr_t, const SharedPtr<Tp>& a) {
+template <typename Tp, LockPolicy Lp>
+inline bool operator==(nullptr_t, const SharedPtr<Tp, Lp>& a) {
     return !a;
 }
 
-template <typename Tp1, typename Tp2>
-inline bool operator!=(const SharedPtr<Tp1>& a, const SharedPtr<Tp2>& b) {
+template <typename Tp1, typename Tp2, LockPolicy Lp>
+inline bool operator!=(const SharedPtr<Tp1, Lp>& a, const SharedPtr<Tp2, Lp>& b) {
     return a.get() != b.get();
 }
 
-template <typename Tp>
-inline bool operator!=(const SharedPtr<Tp>& a, nullptr_t) {
+template <typename Tp, LockPolicy Lp>
+inline bool operator!=(const SharedPtr<Tp, Lp>& a, nullptr_t) {
     return static_cast<bool>(a);
 }
 
-template <typename Tp>
-inline bool operator!=(nullptr_t, const SharedPtr<Tp>& a) {
+template <typename Tp, LockPolicy Lp>
+inline bool operator!=(nullptr_t, const SharedPtr<Tp, Lp>& a) {
     return static_cast<bool>(a);
 }
 
-template <typename Tp>
-inline void swap(SharedPtr<Tp>& a, SharedPtr<Tp>& b) {
+template <typename Tp, LockPolicy Lp>
+inline void swap(SharedPtr<Tp, Lp>& a, SharedPtr<Tp, Lp>& b) {
     a.swap(b);
 }
 
-template <typename Tp, typename Tp1>
-inline SharedPtr<Tp> static_pointer_cast(const SharedPtr<Tp1>& r) {
-    using Sp = SharedPtr<Tp>;
+// Works without RTTI: deleters are matched by SpTypeIdOf<Del>().
+template <typename Del, typename Tp, LockPolicy Lp>
+inline Del* get_deleter(const SharedPtr<Tp, Lp>& p) {
+    return static_cast<Del*>(p.GetDeleter(SpTypeIdOf<Del>()));
+}
+
+template <typename Tp, typename Tp1, LockPolicy Lp>
+inline SharedPtr<Tp, Lp> static_pointer_cast(const SharedPtr<Tp1, Lp>& r) {
+    using Sp = SharedPtr<Tp, Lp>;
     return Sp(r, static_cast<typename Sp::element_type*>(r.get()));
 }
 
-template <typename Tp, typename Tp1>
-inline SharedPtr<Tp> const_pointer_cast(const SharedPtr<Tp1>& r) {
-    using Sp = SharedPtr<Tp>;
+template <typename Tp, typename Tp1, LockPolicy Lp>
+inline SharedPtr<Tp, Lp> static_pointer_cast(SharedPtr<Tp1, Lp>&& r) {
+    using Sp = SharedPtr<Tp, Lp>;
+    return Sp(std::move(r), static_cast<typename Sp::element_type*>(r.get()));
+}
+
+template <typename Tp, typename Tp1, LockPolicy Lp>
+inline SharedPtr<Tp, Lp> const_pointer_cast(const SharedPtr<Tp1, Lp>& r) {
+    using Sp = SharedPtr<Tp, Lp>;
     return Sp(r, const_cast<typename Sp::element_type*>(r.get()));
 }
 
-template <typename Tp, typename Tp1>
-inline SharedPtr<Tp> dynamic_pointer_cast(const SharedPtr<Tp1>& r) {
-    using Sp = SharedPtr<Tp>;
+template <typename Tp, typename Tp1, LockPolicy Lp>
+inline SharedPtr<Tp, Lp> const_pointer_cast(SharedPtr<Tp1, Lp>&& r) {
+    using Sp = SharedPtr<Tp, Lp>;
+    return Sp(std::move(r), const_cast<typename Sp::element_type*>(r.get()));
+}
+
+template <typename Tp, typename Tp1, LockPolicy Lp>
+inline SharedPtr<Tp, Lp> dynamic_pointer_cast(const SharedPtr<Tp1, Lp>& r) {
+    using Sp = SharedPtr<Tp, Lp>;
     if (auto* p = dynamic_cast<typename Sp::element_type*>(r.get()))
         return Sp(r, p);
     return Sp();
 }
 
-template <typename Tp, typename Tp1>
-inline SharedPtr<Tp> reinterpret_pointer_cast(const SharedPtr<Tp1>& r) {
-    using Sp = SharedPtr<Tp>;
+// r keeps its reference if the cast fails.
+template <typename Tp, typename Tp1, LockPolicy Lp>
+inline SharedPtr<Tp, Lp> dynamic_pointer_cast(SharedPtr<Tp1, Lp>&& r) {
+    using Sp = SharedPtr<Tp, Lp>;
+    if (auto* p = dynamic_cast<typename Sp::element_type*>(r.get()))
+        return Sp(std::move(r), p);
+    return Sp();
+}
+
+template <typename Tp, typename Tp1, LockPolicy Lp>
+inline SharedPtr<Tp, Lp> reinterpret_pointer_cast(const SharedPtr<Tp1, Lp>& r) {
+    using Sp = SharedPtr<Tp, Lp>;
     return Sp(r, reinterpret_cast<typename Sp::element_type*>(r.get()));
 }
 
-template <typename Tp>
+template <typename Tp, typename Tp1, LockPolicy Lp>
+inline SharedPtr<Tp, Lp> reinterpret_pointer_cast(SharedPtr<Tp1, Lp>&& r) {
+    using Sp = SharedPtr<Tp, Lp>;
+    return Sp(std::move(r), reinterpret_cast<typename Sp::element_type*>(r.get()));
+}
+
+template <typename Tp, LockPolicy Lp>
 class WeakPtr {
     template <typename Yp, typename Res = void>
     using Compatible = typename std::enable_if<SpCompatibleWith<Yp*, Tp*>::value, Res>::type;
@@ -630,52 +1990,50 @@ public:
     ~WeakPtr() = default;
 
     template <typename Yp, typename = Compatible<Yp>>
-    WeakPtr(const WeakPtr<Yp>& r) : ref_count_(r.ref_count_) {
-        ptr_ = r.Lock().get();
-    }
+    WeakPtr(const WeakPtr<Yp, Lp>& r) : ptr_(SafeUpcast(r)), ref_count_(r.ref_count_) {}
 
     template <typename Yp, typename = Compatible<Yp>>
-    WeakPtr(const SharedPtr<Yp>& r) : ptr_(r.ptr_), ref_count_(r.ref_count_) {}
+    WeakPtr(const SharedPtr<Yp, Lp>& r) : ptr_(r.ptr_), ref_count_(r.ref_count_) {}
 
-    WeakPtr(WeakPtr&& r) : ptr_(r.ptr_), ref_count_(std::move(r.ref_count_)) {
+    WeakPtr(WeakPtr&& r) noexcept : ptr_(r.ptr_), ref_count_(std::move(r.ref_count_)) {
         r.ptr_ = nullptr;
     }
 
     template <typename Yp, typename = Compatible<Yp>>
-    WeakPtr(WeakPtr<Yp>&& r) : ptr_(r.Lock().get()), ref_count_(std::move(r.ref_count_)) {
+    WeakPtr(WeakPtr<Yp, Lp>&& r) noexcept : ptr_(SafeUpcast(r)), ref_count_(std::move(r.ref_count_)) {
         r.ptr_ = nullptr;
     }
 
     WeakPtr& operator=(const WeakPtr& r) = default;
 
     template <typename Yp>
-    Assignable<Yp> operator=(const WeakPtr<Yp>& r) {
-        ptr_ = r.Lock().get();
+    Assignable<Yp> operator=(const WeakPtr<Yp, Lp>& r) {
+        ptr_ = SafeUpcast(r);
         ref_count_ = r.ref_count_;
         return *this;
     }
 
     template <typename Yp>
-    Assignable<Yp> operator=(const SharedPtr<Yp>& r) {
+    Assignable<Yp> operator=(const SharedPtr<Yp, Lp>& r) {
         ptr_ = r.ptr_;
         ref_count_ = r.ref_count_;
         return *this;
     }
 
-    WeakPtr& operator=(WeakPtr&& r) {
+    WeakPtr& operator=(WeakPtr&& r) noexcept {
         WeakPtr(std::move(r)).swap(*this);
         return *this;
     }
 
     template <typename Yp>
-    Assignable<Yp> operator=(WeakPtr<Yp>&& r) {
-        ptr_ = r.Lock().get();
-        ref_count_ = std::move(r.ref_count_);
+    Assignable<Yp> operator=(WeakPtr<Yp, Lp>&& r) noexcept {
+        WeakPtr(std::move(r)).swap(*this);
         return *this;
     }
 
-    SharedPtr<Tp> Lock() const {
-        return SharedPtr<element_type>(*this, std::nothrow);
+    // Empty if the object has expired; never throws.
+    SharedPtr<Tp, Lp> Lock() const noexcept {
+        return SharedPtr<Tp, Lp>(*this, std::nothrow);
     }
 
     int use_count() const {
@@ -686,10 +2044,29 @@ public:
         return ref_count_.GetUseCount() == 0;
     }
 
-    // template <typename Yp1>
-    // bool owner_before(const SharedPtr<Yp1>& rhs) const {
-    //     return ref_count_.Less(rhs.ref_count_);
-    // }
+    template <typename Yp>
+    bool owner_before(const SharedPtr<Yp, Lp>& r) const {
+        return ref_count_.Less(r.ref_count_);
+    }
+
+    template <typename Yp>
+    bool owner_before(const WeakPtr<Yp, Lp>& r) const {
+        return ref_count_.Less(r.ref_count_);
+    }
+
+    std::size_t owner_hash() const {
+        return ref_count_.Hash();
+    }
+
+    template <typename Yp>
+    bool owner_equal(const SharedPtr<Yp, Lp>& r) const {
+        return !ref_count_.Less(r.ref_count_) && !r.ref_count_.Less(ref_count_);
+    }
+
+    template <typename Yp>
+    bool owner_equal(const WeakPtr<Yp, Lp>& r) const {
+        return !ref_count_.Less(r.ref_count_) && !r.ref_count_.Less(ref_count_);
+    }
 
     void reset() {
         WeakPtr().swap(*this);
@@ -701,34 +2078,84 @@ public:
     }
 
 private:
-    void Assign(Tp* ptr, const SharedCount& ref_count) {
+    // Converting the pointer of an expired object is only safe when it does
+    // not read the object, i.e. unless Tp is a virtual base of Yp; only then
+    // does the conversion go through Lock().
+    template <typename Yp>
+    static element_type* SafeUpcast(const WeakPtr<Yp, Lp>& r) {
+        if constexpr (SpIsVirtualBaseOf<element_type, typename WeakPtr<Yp, Lp>::element_type>::value)
+            return r.Lock().get();
+        else
+            return r.ptr_;
+    }
+
+    void Assign(Tp* ptr, const SharedCount<Lp>& ref_count) {
         if (use_count() == 0) {
             ptr_ = ptr;
             ref_count_ = ref_count;
         }
     }
 
-    template <typename Tp1>
+    template <typename Tp1, LockPolicy Lp1>
     friend class SharedPtr;
 
     // friend self ?
-    template <typename Tp1>
+    template <typename Tp1, LockPolicy Lp1>
     friend class WeakPtr;
 
-    friend class EnableSharedFromThis<Tp>;
+    friend class EnableSharedFromThis<Tp, Lp>;
     friend class enable_shared_from_this<Tp>;
+    friend class enable_local_shared_from_this<Tp>;
+
+    template <typename Value>
+    friend class SpAtomic;
 
     element_type* ptr_;
-    WeakCount ref_count_;
+    WeakCount<Lp> ref_count_;
 };
 
-template <typename Tp>
-inline void swap(WeakPtr<Tp>& a, WeakPtr<Tp>& b) {
+template <typename Tp, LockPolicy Lp>
+inline void swap(WeakPtr<Tp, Lp>& a, WeakPtr<Tp, Lp>& b) {
     a.swap(b);
 }
 
-template <typename Tp>
+/**
+ *  Function objects for containers keyed by ownership, e.g.
+ *  std::set<WeakPtr<T>, owner_less<>> or
+ *  std::unordered_map<WeakPtr<T>, V, owner_hash, owner_equal>.
+ *  They accept any mix of SharedPtr and WeakPtr.
+ */
+template <typename Tp = void>
+struct owner_less {
+    template <typename Up, typename Vp>
+    bool operator()(const Up& a, const Vp& b) const {
+        return a.owner_before(b);
+    }
+
+    using is_transparent = void;
+};
+
+struct owner_hash {
+    template <typename Tp>
+    std::size_t operator()(const Tp& p) const {
+        return p.owner_hash();
+    }
+
+    using is_transparent = void;
+};
+
+struct owner_equal {
+    template <typename Up, typename Vp>
+    bool operator()(const Up& a, const Vp& b) const {
+        return a.owner_equal(b);
+    }
+
+    using is_transparent = void;
+};
+
+template <typename Tp, LockPolicy Lp>
 class EnableSharedFromThis {
+protected:
     EnableSharedFromThis() {}
 
     EnableSharedFromThis(const EnableSharedFromThis&) {}
@@ -740,41 +2167,136 @@ class EnableSharedFromThis {
     ~EnableSharedFromThis() {}
 
 public:
-    SharedPtr<Tp> SharedFromThis() {
-        return SharedPtr<Tp>(this->_weak_this_);
+    SharedPtr<Tp, Lp> SharedFromThis() {
+        return SharedPtr<Tp, Lp>(this->_weak_this_);
     }
 
-    SharedPtr<const Tp>
+    SharedPtr<const Tp, Lp>
     SharedFromThis() const {
-        return SharedPtr<const Tp>(this->_weak_this_);
+        return SharedPtr<const Tp, Lp>(this->_weak_this_);
     }
 
-    WeakPtr<Tp> WeakFromThis() {
+    WeakPtr<Tp, Lp> WeakFromThis() {
         return this->_weak_this_;
     }
 
-    WeakPtr<const Tp> WeakFromThis() const {
+    WeakPtr<const Tp, Lp> WeakFromThis() const {
         return this->_weak_this_;
     }
 
 private:
     template <typename Tp1>
-    void WeakAssign(Tp* p, const SharedCount& n) const {
+    void WeakAssign(Tp1* p, const SharedCount<Lp>& n) const {
         _weak_this_.Assign(p, n);
     }
 
 private:
-    friend const EnableSharedFromThis* EnableSharedFromThisBase(const SharedCount&, const EnableSharedFromThis* p) {
+    friend const EnableSharedFromThis* EnableSharedFromThisBase(const SharedCount<Lp>&, const EnableSharedFromThis* p) {
         return p;
     }
 
-    template<typename>
+    template <typename, LockPolicy>
     friend class SharedPtr;
 
     // named to avoid repeating names
-    mutable WeakPtr<Tp> _weak_this_;
+    mutable WeakPtr<Tp, Lp> _weak_this_;
+};
+
+/**
+ *  Back door for the factories in this library that build their own control
+ *  block (deferred reclamation, intrusive counts, ...) and need to wrap it in
+ *  a SharedPtr or look at the count of an existing one.
+ */
+struct SpAccess {
+    template <typename Tp, LockPolicy Lp>
+    static SharedPtr<Tp, Lp> MakeShared(SharedCount<Lp>&& count, typename SharedPtr<Tp, Lp>::element_type* p) {
+        SharedPtr<Tp, Lp> result;
+        result.ref_count_.Swap(count);
+        result.ptr_ = p;
+        result.EnableSharedFromThisWith(p);
+        return result;
+    }
+
+    template <typename Tp, LockPolicy Lp>
+    static const SharedCount<Lp>& GetCount(const SharedPtr<Tp, Lp>& p) {
+        return p.ref_count_;
+    }
+
+    // Empty p without dropping its reference and return its control block.
+    template <typename Tp, LockPolicy Lp>
+    static SpCountedBase<Lp>* Detach(SharedPtr<Tp, Lp>& p) {
+        p.ptr_ = nullptr;
+        return p.ref_count_.Detach();
+    }
 };
 
-// TODO: MakeShared
+/**
+ *  @brief Reset every pointer in [first, last), with one update of the use
+ *  count per distinct control block.
+ *
+ *  The elements can be SharedPtr or shared_ptr and may share blocks in any
+ *  order; the blocks are sorted to group them. Batches of up to
+ *  RELEASE_BATCH_STACK pointers are grouped without allocating.
+ */
+static constexpr std::size_t RELEASE_BATCH_STACK = 64;
+
+template <typename ForwardIt>
+void release_batch(ForwardIt first, ForwardIt last) {
+    using Block = decltype(SpAccess::Detach(*first));
+    Block stack[RELEASE_BATCH_STACK];
+    std::vector<Block> heap;
+    Block* blocks = stack;
+    const std::size_t n = static_cast<std::size_t>(std::distance(first, last));
+    if (n > RELEASE_BATCH_STACK) {
+        heap.resize(n);
+        blocks = heap.data();
+    }
+
+    std::size_t count = 0;
+    for (; first != last; ++first) {
+        if (Block block = SpAccess::Detach(*first))
+            blocks[count++] = block;
+    }
+    std::sort(blocks, blocks + count, std::less<Block>());
+    for (std::size_t i = 0; i != count;) {
+        std::size_t j = i + 1;
+        while (j != count && blocks[j] == blocks[i]) ++j;
+        blocks[i]->ReleaseN(static_cast<int>(j - i));
+        i = j;
+    }
+}
+
+template <typename Tp, LockPolicy Lp, typename Alloc, typename... Args>
+inline SharedPtr<Tp, Lp> AllocateShared(const Alloc& a, Args&&... args) {
+    static_assert(!std::is_array<Tp>::value, "make_shared<T[]> not supported");
+    return SharedPtr<Tp, Lp>(SpAllocShared<Alloc>{a}, std::forward<Args>(args)...);
+}
+
+template <typename Tp, LockPolicy Lp = DEFAULT_LOCK_POLICY, typename... Args>
+inline SharedPtr<Tp, Lp> MakeShared(Args&&... args) {
+    using TpNoCv = typename std::remove_cv<Tp>::type;
+    return AllocateShared<Tp, Lp>(std::allocator<TpNoCv>(), std::forward<Args>(args)...);
+}
+
+/**
+ *  @brief make_shared with a BIASED control block owned by the calling thread.
+ *
+ *  Copies and releases made on this thread do not need atomic operations.
+ */
+template <typename Tp, typename... Args>
+inline SharedPtr<Tp, BIASED> make_biased_shared(Args&&... args) {
+    return MakeShared<Tp, BIASED>(std::forward<Args>(args)...);
+}
+
+/**
+ *  @brief Merge the BIASED blocks owned by the calling thread whose last
+ *  references were dropped on other threads, so that they can be freed.
+ *
+ *  Also happens on every make_biased_shared and when the thread exits.
+ */
+inline void biased_collect() {
+    if (SpBiasedOwner* owner = SpBiasedOwner::Current())
+        owner->Collect();
+}
 
 }  // namespace tiny_std
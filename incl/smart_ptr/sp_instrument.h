@@ -0,0 +1,212 @@
+/**
+ * @file sp_instrument.h
+ * @author whoami (13003827890@163.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-15
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#ifdef TINY_STD_SP_INSTRUMENT
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#endif
+
+/**
+ *  Opt-in instrumentation of the smart pointers.
+ *
+ *  Define TINY_STD_SP_INSTRUMENT (in every translation unit) to make the
+ *  control blocks and unique_ptr report to per-type counters, which
+ *  sp_instrument_snapshot() and sp_instrument_export() from
+ *  sp_instrument_report.h read. Without it TINY_STD_SP_HOOK() drops its
+ *  argument, the control blocks carry no extra state (SpInstrumentState is
+ *  empty), the counters are not even declared and the snapshot is always
+ *  empty.
+ */
+#ifdef TINY_STD_SP_INSTRUMENT
+#define TINY_STD_SP_HOOK(...) __VA_ARGS__
+#else
+#define TINY_STD_SP_HOOK(...)
+#endif
+
+namespace tiny_std {
+
+#ifdef TINY_STD_SP_INSTRUMENT
+static constexpr bool sp_instrument_enabled = true;
+#else
+static constexpr bool sp_instrument_enabled = false;
+#endif
+
+// Bucket i counts lifetimes in [2^i, 2^(i+1)) ns; the last one is open ended.
+static constexpr std::size_t SP_LIFETIME_BUCKETS = 40;
+
+#ifdef TINY_STD_SP_INSTRUMENT
+
+/**
+ *  Counters of one type, registered on first use. Never freed, so blocks
+ *  released during static destruction can still report to them.
+ */
+struct sp_type_stats {
+    char type_name[128];
+
+    std::atomic<std::uint64_t> allocations;     // control blocks created
+    std::atomic<std::int64_t> live_objects;     // created and not yet disposed
+    std::atomic<std::int64_t> live_bytes;       // object bytes of live_objects
+    std::atomic<std::uint64_t> copies;          // strong references taken
+    std::atomic<std::uint64_t> releases;        // strong references dropped
+    std::atomic<std::uint64_t> weak_copies;     // weak references taken
+    std::atomic<std::uint64_t> weak_releases;   // weak count decrements, incl. the owners' one
+    std::atomic<std::uint64_t> contended_rmws;  // count updates that raced another thread
+    std::atomic<std::uint64_t> unique_deletes;  // objects deleted by unique_ptr
+    std::atomic<std::uint64_t> lifetime_ns[SP_LIFETIME_BUCKETS];
+
+    sp_type_stats* next;
+};
+
+class SpInstrument {
+public:
+    template <typename Tp>
+    static sp_type_stats* StatsOf() {
+        static sp_type_stats* const stats = Register(TypeName<Tp>());
+        return stats;
+    }
+
+    // sizeof(Tp), or 0 where it is unknown (void, incomplete types).
+    template <typename Tp>
+    static constexpr std::size_t SizeOf() {
+        return SizeOfImpl<Tp>(0);
+    }
+
+    static sp_type_stats* Head() {
+        return head_.load(std::memory_order_acquire);
+    }
+
+    static std::uint64_t Now() {
+        auto now = std::chrono::steady_clock::now().time_since_epoch();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+    }
+
+    static void Add(std::atomic<std::uint64_t>& counter, std::uint64_t n = 1) {
+        counter.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    static void Add(std::atomic<std::int64_t>& counter, std::int64_t n) {
+        counter.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    static void RecordLifetime(sp_type_stats* stats, std::uint64_t born) {
+        std::uint64_t ns = Now() - born;
+        std::size_t bucket = 0;
+        while (ns > 1 && bucket + 1 < SP_LIFETIME_BUCKETS) {
+            ns >>= 1;
+            ++bucket;
+        }
+        Add(stats->lifetime_ns[bucket]);
+    }
+
+private:
+    template <typename Tp>
+    static constexpr std::size_t SizeOfImpl(decltype(sizeof(Tp))) {
+        return sizeof(Tp);
+    }
+
+    template <typename Tp>
+    static constexpr std::size_t SizeOfImpl(...) {
+        return 0;
+    }
+
+    // Name of Tp without RTTI, cut out of the function signature.
+    template <typename Tp>
+    static const char* TypeName() {
+        return __PRETTY_FUNCTION__;
+    }
+
+    static sp_type_stats* Register(const char* signature) {
+        sp_type_stats* stats = new sp_type_stats();
+        const char* begin = std::strstr(signature, "Tp = ");
+        begin = begin ? begin + 5 : signature;
+        std::size_t len = std::strcspn(begin, ";]");
+        if (len >= sizeof(stats->type_name))
+            len = sizeof(stats->type_name) - 1;
+        std::memcpy(stats->type_name, begin, len);
+        stats->type_name[len] = '\0';
+
+        sp_type_stats* head = head_.load(std::memory_order_relaxed);
+        do {
+            stats->next = head;
+        } while (!head_.compare_exchange_weak(head, stats, std::memory_order_release, std::memory_order_relaxed));
+        return stats;
+    }
+
+    static inline std::atomic<sp_type_stats*> head_{nullptr};
+};
+
+#endif  // TINY_STD_SP_INSTRUMENT
+
+/**
+ *  Per-block state of the instrumentation: which type the block counts for,
+ *  its object size and when it was created. The control blocks only derive
+ *  from it when TINY_STD_SP_INSTRUMENT is defined.
+ */
+class SpInstrumentState {
+#ifdef TINY_STD_SP_INSTRUMENT
+public:
+    void InstrumentAttach(sp_type_stats* stats, std::size_t bytes) {
+        stats_ = stats;
+        bytes_ = bytes;
+        born_ = SpInstrument::Now();
+        SpInstrument::Add(stats->allocations);
+        SpInstrument::Add(stats->live_objects, 1);
+        SpInstrument::Add(stats->live_bytes, static_cast<std::int64_t>(bytes));
+    }
+
+protected:
+    void InstrumentCopy(int n) {
+        if (stats_ != nullptr)
+            SpInstrument::Add(stats_->copies, n);
+    }
+
+    void InstrumentRelease(int n) {
+        if (stats_ != nullptr)
+            SpInstrument::Add(stats_->releases, n);
+    }
+
+    void InstrumentWeakCopy() {
+        if (stats_ != nullptr)
+            SpInstrument::Add(stats_->weak_copies);
+    }
+
+    void InstrumentWeakRelease() {
+        if (stats_ != nullptr)
+            SpInstrument::Add(stats_->weak_releases);
+    }
+
+    void InstrumentContended() {
+        if (stats_ != nullptr)
+            SpInstrument::Add(stats_->contended_rmws);
+    }
+
+    void InstrumentDispose() {
+        if (stats_ == nullptr)
+            return;
+        SpInstrument::Add(stats_->live_objects, -1);
+        SpInstrument::Add(stats_->live_bytes, -static_cast<std::int64_t>(bytes_));
+        SpInstrument::RecordLifetime(stats_, born_);
+    }
+
+private:
+    sp_type_stats* stats_ = nullptr;
+    std::size_t bytes_ = 0;
+    std::uint64_t born_ = 0;
+#endif
+};
+
+}  // namespace tiny_std
@@ -0,0 +1,76 @@
+/**
+ * @file sp_instrument_report.h
+ * @author whoami (13003827890@163.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "smart_ptr/sp_instrument.h"
+
+// Reading the instrumentation counters, kept out of sp_instrument.h so the
+// smart pointer headers do not pull in <ostream> and <vector>.
+
+namespace tiny_std {
+
+// Plain copy of an sp_type_stats.
+struct sp_stats_snapshot {
+    const char* type_name;
+    std::uint64_t allocations;
+    std::int64_t live_objects;
+    std::int64_t live_bytes;
+    std::uint64_t copies;
+    std::uint64_t releases;
+    std::uint64_t weak_copies;
+    std::uint64_t weak_releases;
+    std::uint64_t contended_rmws;
+    std::uint64_t unique_deletes;
+    std::uint64_t lifetime_ns[SP_LIFETIME_BUCKETS];
+};
+
+/// @brief Copy the counters of every type seen so far.
+inline std::vector<sp_stats_snapshot> sp_instrument_snapshot() {
+    std::vector<sp_stats_snapshot> result;
+#ifdef TINY_STD_SP_INSTRUMENT
+    for (sp_type_stats* s = SpInstrument::Head(); s != nullptr; s = s->next) {
+        sp_stats_snapshot snap;
+        snap.type_name = s->type_name;
+        snap.allocations = s->allocations.load(std::memory_order_relaxed);
+        snap.live_objects = s->live_objects.load(std::memory_order_relaxed);
+        snap.live_bytes = s->live_bytes.load(std::memory_order_relaxed);
+        snap.copies = s->copies.load(std::memory_order_relaxed);
+        snap.releases = s->releases.load(std::memory_order_relaxed);
+        snap.weak_copies = s->weak_copies.load(std::memory_order_relaxed);
+        snap.weak_releases = s->weak_releases.load(std::memory_order_relaxed);
+        snap.contended_rmws = s->contended_rmws.load(std::memory_order_relaxed);
+        snap.unique_deletes = s->unique_deletes.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < SP_LIFETIME_BUCKETS; ++i)
+            snap.lifetime_ns[i] = s->lifetime_ns[i].load(std::memory_order_relaxed);
+        result.push_back(snap);
+    }
+#endif
+    return result;
+}
+
+/// @brief Write one `key=value` line per type, for scraping.
+inline void sp_instrument_export(std::ostream& os) {
+    for (const sp_stats_snapshot& s : sp_instrument_snapshot()) {
+        os << "type=\"" << s.type_name << "\" allocations=" << s.allocations << " live_objects=" << s.live_objects
+           << " live_bytes=" << s.live_bytes << " copies=" << s.copies << " releases=" << s.releases
+           << " weak_copies=" << s.weak_copies << " weak_releases=" << s.weak_releases
+           << " contended_rmws=" << s.contended_rmws << " unique_deletes=" << s.unique_deletes << " lifetime_log2_ns=";
+        for (std::size_t i = 0; i < SP_LIFETIME_BUCKETS; ++i) os << (i == 0 ? "" : ",") << s.lifetime_ns[i];
+        os << '\n';
+    }
+}
+
+}  // namespace tiny_std
@@ -11,7 +11,13 @@
 
 #pragma once
 
+#include <memory>
+#include <new>
+#include <tuple>
 #include <type_traits>
+#include <utility>
+
+#include "smart_ptr/sp_instrument.h"
 
 namespace tiny_std {
 
@@ -33,6 +39,7 @@ public:
 
 template <typename Tp>
 class def_delete<Tp[]> {
+public:
     def_delete() = default;
 
     template <typename Up, typename = std::_Require<std::is_convertible<Up (*)[], Tp (*)[]>>>
@@ -47,67 +54,85 @@ class def_delete<Tp[]> {
     }
 };
 
+/**
+ *  Pointer and deleter of a unique_ptr. The pointer type is D::pointer when
+ *  the deleter declares one (a fancy pointer), T* otherwise. Both live in a
+ *  std::tuple so that an empty deleter takes no space.
+ */
 template <typename T, typename D>
 class uniq_ptr_impl {
+    template <typename Up, typename Ep, typename = void>
+    struct Ptr {
+        using type = Up*;
+    };
+
+    template <typename Up, typename Ep>
+    struct Ptr<Up, Ep, std::__void_t<typename std::remove_reference<Ep>::type::pointer>> {
+        using type = typename std::remove_reference<Ep>::type::pointer;
+    };
+
 public:
-    using pointer = T*;
+    using pointer = typename Ptr<T, D>::type;
 
 public:
     uniq_ptr_impl() = default;
-    uniq_ptr_impl(pointer ptr) : ptr_(ptr) {}
+    uniq_ptr_impl(pointer ptr) : t_() {
+        GetPtr() = ptr;
+    }
 
     template <typename Del>
-    uniq_ptr_impl(pointer ptr, Del&& deleter) : ptr_(ptr), deleter_(std::forward<Del>(deleter)) {}
+    uniq_ptr_impl(pointer ptr, Del&& deleter) : t_(ptr, std::forward<Del>(deleter)) {}
 
-    uniq_ptr_impl(uniq_ptr_impl&& u) noexcept : ptr_(u.ptr_), deleter_(u.deleter_) {
-        u.ptr_ = nullptr;
+    uniq_ptr_impl(uniq_ptr_impl&& u) noexcept : t_(std::move(u.t_)) {
+        u.GetPtr() = nullptr;
     }
 
     uniq_ptr_impl& operator=(uniq_ptr_impl&& u) noexcept {
         Reset(u.Release());
-        deleter_ = std::forward<D>(u.deleter_());
-        return this;
+        GetDeleter() = std::forward<D>(u.GetDeleter());
+        return *this;
     }
 
 public:
     pointer& GetPtr() {
-        return ptr_;
+        return std::get<0>(t_);
     }
 
     pointer GetPtr() const {
-        return ptr_;
+        return std::get<0>(t_);
     }
 
     D& GetDeleter() {
-        return deleter_;
+        return std::get<1>(t_);
     }
 
-    D GetDeleter() const {
-        return deleter_;
+    const D& GetDeleter() const {
+        return std::get<1>(t_);
     }
 
     void Reset(pointer ptr) {
-        const pointer old_ptr = ptr_;
-        ptr_ = ptr;
+        const pointer old_ptr = GetPtr();
+        GetPtr() = ptr;
         if (old_ptr) {
-            deleter_(old_ptr);
+            TINY_STD_SP_HOOK(SpInstrument::Add(SpInstrument::StatsOf<T>()->unique_deletes));
+            GetDeleter()(old_ptr);
         }
     }
 
     pointer Release() {
-        pointer t = ptr_;
-        ptr_ = nullptr;
+        pointer t = GetPtr();
+        GetPtr() = nullptr;
         return t;
     }
 
     void swap(uniq_ptr_impl& rhs) {
-        std::swap(ptr_, rhs.ptr_);
-        std::swap(deleter_, rhs.deleter_);
+        using std::swap;
+        swap(GetPtr(), rhs.GetPtr());
+        swap(GetDeleter(), rhs.GetDeleter());
     }
 
 private:
-    pointer ptr_;
-    D deleter_;
+    std::tuple<pointer, D> t_;
 };
 
 template <typename T, typename D = def_delete<T>>
@@ -143,9 +168,11 @@ public:
 
     ~unique_ptr() {
         auto& ptr = impl_.GetPtr();
-        if (ptr != nullptr)
+        if (ptr != nullptr) {
+            TINY_STD_SP_HOOK(SpInstrument::Add(SpInstrument::StatsOf<T>()->unique_deletes));
             // impl_.GetDeleter()(std::move(ptr));
             impl_.GetDeleter()(ptr);
+        }
         ptr = nullptr;
     }
 
@@ -167,7 +194,7 @@ public:
         return *this;
     }
 
-    element_type operator*() const {
+    typename std::add_lvalue_reference<element_type>::type operator*() const {
         return *get();
     }
 
@@ -262,8 +289,10 @@ public:
 
     ~unique_ptr() {
         auto& ptr = impl_.GetPtr();
-        if (ptr != nullptr)
+        if (ptr != nullptr) {
+            TINY_STD_SP_HOOK(SpInstrument::Add(SpInstrument::StatsOf<T>()->unique_deletes));
             get_deleter()(ptr);
+        }
         ptr = nullptr;
     }
 
@@ -302,7 +331,7 @@ public:
     }
 
     explicit operator bool() const {
-        return !get() == pointer();
+        return !(get() == pointer());
     }
 
     pointer release() {
@@ -390,7 +419,82 @@ inline typename MakeUniq<T>::array make_unique(size_t num) {
     return unique_ptr<T>(new std::remove_extent_t<T>[num]());
 }
 
-template <typename T, typename Args>
+template <typename T, typename... Args>
 typename MakeUniq<T>::invalid_type make_unique(Args&&...) = delete;
 
+// Like make_unique, but default-initializes: no zeroing of trivial types.
+template <typename T>
+inline typename MakeUniq<T>::single_object make_unique_for_overwrite() {
+    return unique_ptr<T>(new T);
+}
+
+template <typename T>
+inline typename MakeUniq<T>::array make_unique_for_overwrite(size_t num) {
+    return unique_ptr<T>(new std::remove_extent_t<T>[num]);
+}
+
+template <typename T, typename... Args>
+typename MakeUniq<T>::invalid_type make_unique_for_overwrite(Args&&...) = delete;
+
+/**
+ *  Deleter of the objects made by allocate_unique: destroys the object and
+ *  gives its storage back to the allocator it came from.
+ */
+template <typename Alloc>
+class allocator_delete {
+    using Traits = std::allocator_traits<Alloc>;
+
+public:
+    using allocator_type = Alloc;
+    using pointer = typename Traits::pointer;
+
+    explicit allocator_delete(const Alloc& a) : alloc_(a) {}
+
+    allocator_delete(const allocator_delete&) = default;
+
+    // An allocator need not be assignable (pmr::polymorphic_allocator is
+    // not), but unique_ptr assigns and swaps its deleter: rebind to the
+    // other allocator instead. Allocator copies do not throw.
+    allocator_delete& operator=(const allocator_delete& d) noexcept {
+        if (this != &d) {
+            alloc_.~Alloc();
+            ::new (static_cast<void*>(std::addressof(alloc_))) Alloc(d.alloc_);
+        }
+        return *this;
+    }
+
+    void operator()(pointer p) {
+        Traits::destroy(alloc_, std::addressof(*p));
+        Traits::deallocate(alloc_, p, 1);
+    }
+
+    const Alloc& get_allocator() const {
+        return alloc_;
+    }
+
+private:
+    Alloc alloc_;
+};
+
+template <typename T, typename Alloc>
+using AllocUniq = typename std::enable_if<
+    !std::is_array<T>::value,
+    unique_ptr<T, allocator_delete<typename std::allocator_traits<Alloc>::template rebind_alloc<T>>>>::type;
+
+// Like make_unique, but the object lives in memory from @a a (rebound to T).
+template <typename T, typename Alloc, typename... Args>
+inline AllocUniq<T, Alloc> allocate_unique(const Alloc& a, Args&&... args) {
+    using TpAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<T>;
+    using TpAllocTraits = std::allocator_traits<TpAlloc>;
+    TpAlloc alloc(a);
+    auto p = TpAllocTraits::allocate(alloc, 1);
+    try {
+        TpAllocTraits::construct(alloc, std::addressof(*p), std::forward<Args>(args)...);
+    } catch (...) {
+        TpAllocTraits::deallocate(alloc, p, 1);
+        throw;
+    }
+    return AllocUniq<T, Alloc>(p, allocator_delete<TpAlloc>(alloc));
+}
+
 }  // namespace tiny_std
@@ -0,0 +1,199 @@
+/**
+ * @file weak_cache.h
+ * @author whoami (13003827890@163.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-15
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "smart_ptr/shared_ptr_base.h"
+
+namespace tiny_std {
+
+/**
+ *  @brief A dedup cache that holds its values through WeakPtr.
+ *
+ *  A value stays cached exactly as long as somebody outside the cache owns
+ *  it. get_or_create() hands out the live value for a key, or builds a new
+ *  one; concurrent callers for the same key wait for a single construction
+ *  instead of building their own.
+ *
+ *  Entries of expired values are swept a few buckets at a time: every
+ *  insertion sweeps SWEEP_BUCKETS buckets of its stripe, and sweep() can be
+ *  called to do more. No call ever walks the whole cache under a lock.
+ *
+ *  Keys are spread over STRIPES independently locked maps. Keys can be
+ *  SharedPtr or WeakPtr themselves, with owner_hash and owner_equal.
+ */
+template <typename Key, typename Tp, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>,
+          LockPolicy Lp = DEFAULT_LOCK_POLICY>
+class weak_cache {
+public:
+    using key_type = Key;
+    using value_type = SharedPtr<Tp, Lp>;
+
+    static constexpr std::size_t STRIPE_BITS = 4;
+    static constexpr std::size_t STRIPES = std::size_t(1) << STRIPE_BITS;
+    static constexpr std::size_t SWEEP_BUCKETS = 2;
+
+    explicit weak_cache(const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual()) : hash_(hash) {
+        for (Stripe& stripe : stripes_) stripe.map_ = Map(0, hash, equal);
+    }
+
+    weak_cache(const weak_cache&) = delete;
+    weak_cache& operator=(const weak_cache&) = delete;
+
+    /**
+     *  @brief Return the live value for @a key, or store and return create().
+     *
+     *  create() runs without any lock held and at most once at a time per key.
+     *  If it throws, the exception propagates and a waiting caller retries.
+     */
+    template <typename Create>
+    value_type get_or_create(const Key& key, Create&& create) {
+        Stripe& stripe = StripeOf(key);
+        std::unique_lock<std::mutex> lock(stripe.mutex_);
+        Entry* entry;
+        for (;;) {
+            auto it = stripe.map_.find(key);
+            if (it == stripe.map_.end()) {
+                entry = &stripe.map_.emplace(key, Entry()).first->second;
+                entry->creating_ = true;
+                SweepLocked(stripe, SWEEP_BUCKETS);
+                break;
+            }
+            entry = &it->second;
+            if (!entry->creating_) {
+                if (value_type value = entry->value_.Lock())
+                    return value;
+                entry->creating_ = true;
+                break;
+            }
+            stripe.created_.wait(lock);
+        }
+        // Sweeping and erase() skip entries that are being created, and
+        // rehashing does not move elements, so `entry` stays valid while the
+        // lock is released.
+        lock.unlock();
+
+        value_type value;
+        try {
+            value = std::forward<Create>(create)();
+        } catch (...) {
+            lock.lock();
+            entry->creating_ = false;
+            lock.unlock();
+            stripe.created_.notify_all();
+            throw;
+        }
+
+        lock.lock();
+        entry->value_ = value;
+        entry->creating_ = false;
+        lock.unlock();
+        stripe.created_.notify_all();
+        return value;
+    }
+
+    // The live value for @a key, or an empty pointer.
+    value_type find(const Key& key) {
+        Stripe& stripe = StripeOf(key);
+        std::lock_guard<std::mutex> lock(stripe.mutex_);
+        auto it = stripe.map_.find(key);
+        if (it == stripe.map_.end())
+            return value_type();
+        return it->second.value_.Lock();
+    }
+
+    // Forget @a key; owners of its value are not affected.
+    bool erase(const Key& key) {
+        Stripe& stripe = StripeOf(key);
+        std::lock_guard<std::mutex> lock(stripe.mutex_);
+        auto it = stripe.map_.find(key);
+        if (it == stripe.map_.end() || it->second.creating_)
+            return false;
+        stripe.map_.erase(it);
+        return true;
+    }
+
+    /**
+     *  @brief Drop expired entries from the next @a buckets buckets of every
+     *  stripe and return how many were dropped.
+     */
+    std::size_t sweep(std::size_t buckets = SWEEP_BUCKETS) {
+        std::size_t dropped = 0;
+        for (Stripe& stripe : stripes_) {
+            std::lock_guard<std::mutex> lock(stripe.mutex_);
+            dropped += SweepLocked(stripe, buckets);
+        }
+        return dropped;
+    }
+
+    // Number of entries, expired or not.
+    std::size_t size() const {
+        std::size_t result = 0;
+        for (const Stripe& stripe : stripes_) {
+            std::lock_guard<std::mutex> lock(stripe.mutex_);
+            result += stripe.map_.size();
+        }
+        return result;
+    }
+
+private:
+    struct Entry {
+        WeakPtr<Tp, Lp> value_;
+        bool creating_ = false;
+    };
+
+    using Map = std::unordered_map<Key, Entry, Hash, KeyEqual>;
+
+    struct alignas(64) Stripe {
+        mutable std::mutex mutex_;
+        std::condition_variable created_;
+        Map map_;
+        std::size_t sweep_bucket_ = 0;
+    };
+
+    Stripe& StripeOf(const Key& key) {
+        // Fibonacci hashing: owner_hash() values are aligned addresses whose
+        // low bits are all zero, so take the top bits of a multiplied hash.
+        std::uint64_t h = hash_(key);
+        return stripes_[(h * 0x9E3779B97F4A7C15ull) >> (64 - STRIPE_BITS)];
+    }
+
+    static std::size_t SweepLocked(Stripe& stripe, std::size_t buckets) {
+        std::size_t dropped = 0;
+        std::vector<typename Map::const_iterator> expired;
+        for (std::size_t i = 0; i < buckets; ++i) {
+            std::size_t count = stripe.map_.bucket_count();
+            std::size_t bucket = stripe.sweep_bucket_++ % count;
+            for (auto local = stripe.map_.begin(bucket); local != stripe.map_.end(bucket); ++local) {
+                if (!local->second.creating_ && local->second.value_.Expired())
+                    expired.push_back(stripe.map_.find(local->first));
+            }
+            for (auto it : expired) stripe.map_.erase(it);
+            dropped += expired.size();
+            expired.clear();
+        }
+        return dropped;
+    }
+
+    Hash hash_;
+    Stripe stripes_[STRIPES];
+};
+
+}  // namespace tiny_std
@@ -0,0 +1,138 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <stdexcept>
+
+#include "smart_ptr/compressed_ptr.h"
+
+namespace {
+
+struct TestArenaTag {};
+using TestArena = tiny_std::arena<TestArenaTag>;
+
+int g_live = 0;
+
+struct Node {
+    explicit Node(int v) : value(v) {
+        ++g_live;
+    }
+
+    ~Node() {
+        --g_live;
+    }
+
+    int value;
+    tiny_std::arena_unique_ptr<Node, TestArena> left;
+    tiny_std::arena_unique_ptr<Node, TestArena> right;
+};
+
+struct Base {
+    virtual ~Base() = default;
+    std::uint64_t tag = 1;
+};
+
+struct Derived : Base {
+    std::uint64_t extra = 2;
+};
+
+tiny_std::arena_unique_ptr<Node, TestArena> Build(int depth, int& next) {
+    auto node = tiny_std::make_arena_unique<Node, TestArena>(next++);
+    if (depth > 0) {
+        node->left = Build(depth - 1, next);
+        node->right = Build(depth - 1, next);
+    }
+    return node;
+}
+
+long Sum(const Node* node) {
+    return node == nullptr ? 0 : node->value + Sum(node->left.get().get()) + Sum(node->right.get().get());
+}
+
+}  // namespace
+
+TEST_CASE("compressed_ptr halves the pointer", "[compressed_ptr]") {
+    STATIC_REQUIRE(sizeof(tiny_std::compressed_ptr<Node, TestArena>) == 4);
+    STATIC_REQUIRE(sizeof(tiny_std::arena_unique_ptr<Node, TestArena>) == 4);
+    STATIC_REQUIRE(std::is_same<tiny_std::arena_unique_ptr<Node, TestArena>::pointer,
+                                tiny_std::compressed_ptr<Node, TestArena>>::value);
+}
+
+TEST_CASE("compressed_ptr round trips arena addresses", "[compressed_ptr]") {
+    TestArena arena(1 << 16);
+    tiny_std::compressed_ptr<Node, TestArena> null;
+    REQUIRE(!null);
+    REQUIRE(null == nullptr);
+    REQUIRE(null.get() == nullptr);
+
+    g_live = 0;
+    {
+        auto a = tiny_std::make_arena_unique<Node, TestArena>(1);
+        auto b = tiny_std::make_arena_unique<Node, TestArena>(2);
+        REQUIRE(g_live == 2);
+        REQUIRE(a);
+        REQUIRE(a->value == 1);
+        REQUIRE((*b).value == 2);
+        REQUIRE(a.get() != b.get());
+        REQUIRE(a.get().offset() != 0);
+
+        tiny_std::compressed_ptr<Node, TestArena> c(b.get().get());
+        REQUIRE(c == b.get());
+
+        a = std::move(b);
+        REQUIRE(g_live == 1);
+        REQUIRE(!b);
+        REQUIRE(a->value == 2);
+
+        a.reset();
+        REQUIRE(g_live == 0);
+        REQUIRE(a.get() == nullptr);
+    }
+    REQUIRE(TestArena::live() == 0);
+}
+
+TEST_CASE("compressed_ptr converts to base", "[compressed_ptr]") {
+    TestArena arena(1 << 16);
+    auto d = tiny_std::make_arena_unique<Derived, TestArena>();
+    Derived* raw = d.get().get();
+    tiny_std::arena_unique_ptr<Base, TestArena> b(std::move(d));
+    REQUIRE(b.get().get() == static_cast<Base*>(raw));
+    REQUIRE(b->tag == 1);
+    REQUIRE(TestArena::live() == 1);
+    b.reset();
+    REQUIRE(TestArena::live() == 0);
+}
+
+TEST_CASE("arena_unique_ptr owns a tree", "[compressed_ptr]") {
+    TestArena arena(1 << 20);
+    g_live = 0;
+    {
+        int next = 0;
+        auto root = Build(10, next);
+        REQUIRE(g_live == (1 << 11) - 1);
+        REQUIRE(Sum(root.get().get()) == long(next) * (next - 1) / 2);
+    }
+    REQUIRE(g_live == 0);
+    TestArena::reset();
+    REQUIRE(TestArena::used() == TestArena::GRANULE);
+}
+
+TEST_CASE("arena throws when full", "[compressed_ptr]") {
+    g_live = 0;
+    TestArena arena(TestArena::GRANULE + sizeof(Node));
+    auto a = tiny_std::make_arena_unique<Node, TestArena>(1);
+    REQUIRE_THROWS_AS((tiny_std::make_arena_unique<Node, TestArena>(2)), std::bad_alloc);
+    REQUIRE(g_live == 1);
+}
+
+TEST_CASE("arena refuses a second arena and oversized regions", "[compressed_ptr]") {
+    {
+        TestArena arena(1 << 10);
+        REQUIRE_THROWS_AS(TestArena(1 << 10), std::logic_error);
+        // The live arena keeps its region.
+        auto a = tiny_std::make_arena_unique<Node, TestArena>(1);
+        REQUIRE(a->value == 1);
+    }
+    REQUIRE_THROWS_AS(TestArena(TestArena::MAX_CAPACITY + 1), std::length_error);
+    TestArena again(1 << 10);
+    REQUIRE(TestArena::base() != nullptr);
+}
@@ -0,0 +1,97 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+
+#include "functional/function.h"
+#include "smart_ptr/shared_ptr.h"
+
+namespace {
+
+struct Big {
+    long values[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+
+    long operator()() const {
+        return values[7];
+    }
+};
+
+template <typename Fn, typename Target>
+bool StoredInside(const Fn& f, const Target* target) {
+    auto begin = reinterpret_cast<const char*>(&f);
+    auto p = reinterpret_cast<const char*>(target);
+    return p >= begin && p < begin + sizeof(f);
+}
+
+}  // namespace
+
+TEST_CASE("function stores small nothrow-movable targets inline", "[function]") {
+    auto owner = tiny_std::make_shared<std::string>("owned");
+    auto lambda = [owner] { return owner->size(); };
+    STATIC_REQUIRE(!std::is_trivially_copyable<decltype(lambda)>::value);
+
+    tiny_std::function<std::size_t()> f = lambda;
+    REQUIRE(StoredInside(f, f.target<decltype(lambda)>()));
+    REQUIRE(owner.use_count() == 3);
+
+    // Moves relocate the target: no new reference is taken.
+    tiny_std::function<std::size_t()> g = std::move(f);
+    REQUIRE(!f);
+    REQUIRE(StoredInside(g, g.target<decltype(lambda)>()));
+    REQUIRE(owner.use_count() == 3);
+    REQUIRE(g() == 5);
+
+    tiny_std::function<std::size_t()> h = g;
+    REQUIRE(owner.use_count() == 4);
+    h = nullptr;
+    g = nullptr;
+    REQUIRE(owner.use_count() == 2);
+}
+
+TEST_CASE("function swaps inline and heap targets", "[function]") {
+    auto owner = tiny_std::make_shared<int>(3);
+    auto lambda = [owner] { return long(*owner); };
+    tiny_std::function<long()> small = lambda;
+    tiny_std::function<long()> big = Big();
+    REQUIRE(!StoredInside(big, big.target<Big>()));
+    swap(small, big);
+    REQUIRE(small() == 8);
+    REQUIRE(big() == 3);
+    REQUIRE(StoredInside(big, big.target<decltype(lambda)>()));
+    REQUIRE(owner.use_count() == 3);
+
+    tiny_std::function<long()> empty;
+    empty.swap(big);
+    REQUIRE(!big);
+    REQUIRE(empty() == 3);
+    big = std::move(empty);
+    REQUIRE(big() == 3);
+    REQUIRE(owner.use_count() == 3);
+}
+
+TEST_CASE("function copies and compares like std::function", "[function]") {
+    tiny_std::function<int(int)> f;
+    REQUIRE(f == nullptr);
+    REQUIRE(f.target_type() == typeid(void));
+
+    f = [](int x) { return x * 3; };
+    tiny_std::function<int(int)> g = f;
+    REQUIRE(g != nullptr);
+    REQUIRE(g(2) == 6);
+    REQUIRE(f.target_type() == g.target_type());
+
+    int (*null_fn)(int) = nullptr;
+    g = null_fn;
+    REQUIRE(!g);
+}
+
+TEST_CASE("function is its small buffer and one pointer", "[function]") {
+    STATIC_REQUIRE(sizeof(tiny_std::function<void()>) == sizeof(tiny_std::AnyData) + sizeof(void*));
+    STATIC_REQUIRE(sizeof(tiny_std::function<std::string(const std::string&, int)>) ==
+                   sizeof(tiny_std::AnyData) + sizeof(void*));
+
+    // Asking for a target the signature could not call is fine.
+    tiny_std::function<long()> f = Big();
+    REQUIRE(f.target<int>() == nullptr);
+    REQUIRE(f.target<Big>() != nullptr);
+    REQUIRE(f.target_type() == typeid(Big));
+}
@@ -0,0 +1,101 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "functional/function.h"
+#include "functional/function_ref.h"
+
+namespace {
+
+int Twice(int x) {
+    return 2 * x;
+}
+
+int Negate(int x) noexcept {
+    return -x;
+}
+
+// A visitor-style API: the callback is only used during the call.
+int SumOf(const std::vector<int>& values, tiny_std::function_ref<int(int)> f) {
+    int sum = 0;
+    for (int v : values) sum += f(v);
+    return sum;
+}
+
+struct Counter {
+    int calls = 0;
+
+    int operator()(int x) {
+        ++calls;
+        return x;
+    }
+
+    int operator()(int x) const {
+        return x + 100;
+    }
+};
+
+}  // namespace
+
+TEST_CASE("function_ref is two trivially copyable words", "[function_ref]") {
+    using Ref = tiny_std::function_ref<int(int)>;
+    STATIC_REQUIRE(sizeof(Ref) == 2 * sizeof(void*));
+    STATIC_REQUIRE(std::is_trivially_copyable<Ref>::value);
+    STATIC_REQUIRE(!std::is_default_constructible<Ref>::value);
+}
+
+TEST_CASE("function_ref binds callables by reference", "[function_ref]") {
+    std::vector<int> values{1, 2, 3};
+    int scale = 10;
+    REQUIRE(SumOf(values, [scale](int x) { return scale * x; }) == 60);
+    REQUIRE(SumOf(values, Twice) == 12);
+    REQUIRE(SumOf(values, &Twice) == 12);
+
+    // The object is referenced, not copied, and is invoked with its own
+    // constness.
+    Counter counter;
+    REQUIRE(SumOf(values, counter) == 6);
+    REQUIRE(counter.calls == 3);
+    const Counter& const_counter = counter;
+    REQUIRE(SumOf(values, const_counter) == 306);
+
+    tiny_std::function_ref<int(int)> ref = counter;
+    auto copy = ref;
+    copy(1);
+    REQUIRE(counter.calls == 4);
+    ref = Twice;
+    REQUIRE(ref(4) == 8);
+}
+
+TEST_CASE("function_ref can refer to a function", "[function_ref]") {
+    tiny_std::function<int(int)> f = [](int x) { return x + 1; };
+    REQUIRE(SumOf({1, 2}, f) == 5);
+    tiny_std::function_ref<int(int)> ref = f;
+    f = Twice;
+    REQUIRE(ref(3) == 6);
+}
+
+TEST_CASE("function_ref supports noexcept signatures", "[function_ref]") {
+    using Nothrow = tiny_std::function_ref<int(int) noexcept>;
+    auto safe = [](int x) noexcept { return x; };
+    auto unsafe = [](int x) { return x; };
+    STATIC_REQUIRE(std::is_constructible<Nothrow, decltype(safe)&>::value);
+    STATIC_REQUIRE(!std::is_constructible<Nothrow, decltype(unsafe)&>::value);
+    STATIC_REQUIRE(!std::is_constructible<Nothrow, int (*)(int)>::value);
+    STATIC_REQUIRE(std::is_nothrow_invocable<Nothrow, int>::value);
+
+    Nothrow ref = Negate;
+    REQUIRE(ref(2) == -2);
+    tiny_std::function_ref deduced = &Negate;
+    STATIC_REQUIRE(std::is_same<decltype(deduced), Nothrow>::value);
+}
+
+TEST_CASE("function_ref converts results like function", "[function_ref]") {
+    auto make = [] { return "text"; };
+    tiny_std::function_ref<std::string()> ref = make;
+    REQUIRE(ref() == "text");
+    tiny_std::function_ref<void()> discard = make;
+    discard();
+}
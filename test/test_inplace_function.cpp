@@ -0,0 +1,120 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <array>
+#include <string>
+
+#include "functional/function.h"
+#include "functional/inplace_function.h"
+
+namespace {
+
+template <typename Fn, typename Target>
+bool StoredInside(const Fn& f, const Target* target) {
+    auto begin = reinterpret_cast<const char*>(&f);
+    auto p = reinterpret_cast<const char*>(target);
+    return p >= begin && p < begin + sizeof(f);
+}
+
+struct Counter {
+    explicit Counter(int& live) : live_(&live) {
+        ++*live_;
+    }
+
+    Counter(const Counter& other) : live_(other.live_) {
+        ++*live_;
+    }
+
+    ~Counter() {
+        --*live_;
+    }
+
+    int operator()(int x) const {
+        return x + *live_;
+    }
+
+    int* live_;
+};
+
+struct ThrowingMove {
+    ThrowingMove() = default;
+
+    ThrowingMove(const ThrowingMove&) {}
+
+    int operator()() const {
+        return 1;
+    }
+};
+
+int Twice(int x) {
+    return 2 * x;
+}
+
+}  // namespace
+
+TEST_CASE("inplace_function stores any target that fits", "[inplace_function]") {
+    std::string text = "a string long enough to live on the heap";
+    auto lambda = [text](int i) { return static_cast<int>(text.size()) + i; };
+    tiny_std::inplace_function<int(int), 48> f = lambda;
+    REQUIRE(f(1) == static_cast<int>(text.size()) + 1);
+    REQUIRE(f.target_type() == typeid(lambda));
+    REQUIRE(StoredInside(f, f.target<decltype(lambda)>()));
+
+    tiny_std::inplace_function<int(int), 16, 8> small = &Twice;
+    REQUIRE(small(4) == 8);
+    STATIC_REQUIRE(sizeof(small) == 16 + sizeof(void*));
+    REQUIRE(*small.target<int (*)(int)>() == &Twice);
+    REQUIRE(small.target<decltype(lambda)>() == nullptr);
+}
+
+TEST_CASE("inplace_function copies, moves and swaps its target", "[inplace_function]") {
+    int live = 0;
+    {
+        tiny_std::inplace_function<int(int)> a = Counter(live);
+        REQUIRE(live == 1);
+        tiny_std::inplace_function<int(int)> b = a;
+        REQUIRE(live == 2);
+        tiny_std::inplace_function<int(int)> c = std::move(a);
+        REQUIRE(live == 2);
+        REQUIRE(!a);
+        REQUIRE(a == nullptr);
+
+        a = [](int x) { return -x; };
+        swap(a, c);
+        REQUIRE(a(0) == 2);
+        REQUIRE(c(3) == -3);
+        REQUIRE(live == 2);
+
+        c = b;
+        REQUIRE(live == 3);
+        b = nullptr;
+        REQUIRE(live == 2);
+    }
+    REQUIRE(live == 0);
+}
+
+TEST_CASE("inplace_function is empty for null targets", "[inplace_function]") {
+    int (*null_fn)(int) = nullptr;
+    tiny_std::inplace_function<int(int)> f = null_fn;
+    REQUIRE(!f);
+    REQUIRE(f.target_type() == typeid(void));
+
+    tiny_std::function<int(int)> empty;
+    tiny_std::inplace_function<int(int), sizeof(empty)> g = empty;
+    REQUIRE(!g);
+    g = tiny_std::function<int(int)>(&Twice);
+    REQUIRE(g(5) == 10);
+}
+
+TEST_CASE("function's small buffer size is configurable", "[inplace_function]") {
+    // This test is built with TINY_STD_FUNCTION_SBO_SIZE=32.
+    STATIC_REQUIRE(tiny_std::FunctionBase::max_size_ == 32);
+    std::array<int, 8> values{1, 2, 3, 4, 5, 6, 7, 8};
+    auto sum = [values] { return values[0] + values[7]; };
+    tiny_std::function<int()> f = sum;
+    REQUIRE(f() == 9);
+    REQUIRE(StoredInside(f, f.target<decltype(sum)>()));
+
+    // Targets whose move may throw still go to the heap.
+    tiny_std::function<int()> g = ThrowingMove();
+    REQUIRE(!StoredInside(g, g.target<ThrowingMove>()));
+}
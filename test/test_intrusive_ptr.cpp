@@ -0,0 +1,182 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <string>
+
+#include "smart_ptr/intrusive_ptr.h"
+
+namespace {
+
+int g_live = 0;
+
+struct Node : tiny_std::intrusive_ref_counter<Node> {
+    explicit Node(int v) : value(v) {
+        ++g_live;
+    }
+
+    virtual ~Node() {
+        --g_live;
+    }
+
+    int value;
+};
+
+struct Leaf : Node {
+    Leaf() : Node(7) {}
+};
+
+struct Local : tiny_std::intrusive_ref_counter<Local, tiny_std::SINGLE> {
+    int value = 3;
+};
+
+struct Extra {
+    virtual ~Extra() = default;
+
+    long tag = 1;
+};
+
+// Node, and with it the counter, is not at the start of the object.
+struct Mixed : Extra, Node {
+    Mixed() : Node(4) {}
+};
+
+// A counter base without a virtual destructor.
+struct Plain : tiny_std::intrusive_ref_counter<Plain> {
+    int value = 5;
+};
+
+struct Pad {
+    long pad[3] = {};
+};
+
+// Plain is at a nonzero offset, and only ~PlainLeaf frees the string.
+struct PlainLeaf : Pad, Plain {
+    PlainLeaf() : text("a string too long for the small string buffer") {
+        ++g_live;
+    }
+
+    ~PlainLeaf() {
+        --g_live;
+    }
+
+    std::string text;
+};
+
+struct alignas(64) Wide : tiny_std::intrusive_ref_counter<Wide> {
+    Wide() {
+        ++g_live;
+    }
+
+    ~Wide() {
+        --g_live;
+    }
+
+    char data[64] = {};
+};
+
+}  // namespace
+
+TEST_CASE("intrusive_ptr is a single pointer", "[intrusive_ptr]") {
+    STATIC_REQUIRE(sizeof(tiny_std::intrusive_ptr<Node>) == sizeof(void*));
+}
+
+TEST_CASE("intrusive_ptr counts inside the object", "[intrusive_ptr]") {
+    g_live = 0;
+    {
+        auto p = tiny_std::make_intrusive<Node>(1);
+        REQUIRE(p->use_count() == 1);
+        tiny_std::intrusive_ptr<Node> q = p;
+        REQUIRE(p->use_count() == 2);
+        // A raw pointer can be turned back into an owner.
+        tiny_std::intrusive_ptr<Node> r(q.get());
+        REQUIRE(p->use_count() == 3);
+        q.reset();
+        r = nullptr;
+        REQUIRE(p->use_count() == 1);
+        REQUIRE(g_live == 1);
+    }
+    REQUIRE(g_live == 0);
+}
+
+TEST_CASE("intrusive_ptr converts from derived", "[intrusive_ptr]") {
+    g_live = 0;
+    {
+        tiny_std::intrusive_ptr<Node> p = tiny_std::make_intrusive<Leaf>();
+        REQUIRE(p->value == 7);
+        tiny_std::intrusive_ptr<Leaf> leaf = tiny_std::static_pointer_cast<Leaf>(p);
+        REQUIRE(leaf == p);
+        REQUIRE(p->use_count() == 2);
+    }
+    REQUIRE(g_live == 0);
+}
+
+TEST_CASE("intrusive_ptr shares its count with SharedPtr", "[intrusive_ptr]") {
+    g_live = 0;
+    tiny_std::WeakPtr<Node> w;
+    {
+        auto p = tiny_std::make_intrusive<Node>(5);
+        tiny_std::SharedPtr<Node> s = p.to_shared();
+        REQUIRE(s.get() == p.get());
+        REQUIRE(s.use_count() == 2);
+
+        p.reset();
+        REQUIRE(g_live == 1);
+        REQUIRE(s->value == 5);
+
+        w = s;
+        REQUIRE(w.use_count() == 1);
+    }
+    // The object is gone but the weak count keeps the memory for the counts.
+    REQUIRE(g_live == 0);
+    REQUIRE(w.Expired());
+    w.reset();
+}
+
+TEST_CASE("intrusive_ptr follows the lock policy", "[intrusive_ptr]") {
+    auto p = tiny_std::make_intrusive<Local>();
+    tiny_std::SharedPtr<Local, tiny_std::SINGLE> s = p.to_shared();
+    tiny_std::WeakPtr<Local, tiny_std::SINGLE> w = p.to_weak();
+    REQUIRE(s.use_count() == 2);
+    REQUIRE(!w.Expired());
+    REQUIRE(s->value == 3);
+}
+
+TEST_CASE("intrusive_ptr frees the complete object", "[intrusive_ptr]") {
+    g_live = 0;
+    tiny_std::WeakPtr<Node> w;
+    {
+        tiny_std::intrusive_ptr<Node> p = tiny_std::make_intrusive<Mixed>();
+        REQUIRE(static_cast<void*>(p.get()) != dynamic_cast<void*>(p.get()));
+        REQUIRE(p->value == 4);
+        w = p.to_weak();
+    }
+    // Destroyed now, freed from the start of the Mixed on the last weak
+    // reference.
+    REQUIRE(g_live == 0);
+    REQUIRE(w.Expired());
+    w.reset();
+
+    {
+        auto p = tiny_std::make_intrusive<Wide>();
+        REQUIRE(reinterpret_cast<std::uintptr_t>(p.get()) % 64 == 0);
+        tiny_std::intrusive_ptr<Wide> q(new Wide);
+        REQUIRE(reinterpret_cast<std::uintptr_t>(q.get()) % 64 == 0);
+        REQUIRE(g_live == 2);
+    }
+    REQUIRE(g_live == 0);
+}
+
+TEST_CASE("make_intrusive destroys the type it created", "[intrusive_ptr]") {
+    g_live = 0;
+    tiny_std::WeakPtr<Plain> w;
+    {
+        tiny_std::intrusive_ptr<Plain> p = tiny_std::make_intrusive<PlainLeaf>();
+        REQUIRE(static_cast<void*>(p.get()) != static_cast<void*>(static_cast<PlainLeaf*>(p.get())));
+        REQUIRE(p->value == 5);
+        REQUIRE(g_live == 1);
+        w = p.to_weak();
+    }
+    REQUIRE(g_live == 0);
+    REQUIRE(w.Expired());
+    w.reset();
+}
@@ -0,0 +1,112 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <iterator>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "smart_ptr/local_shared_ptr.h"
+
+namespace {
+
+struct Session : tiny_std::enable_local_shared_from_this<Session> {
+    explicit Session(int id) : id(id) {
+        ++alive;
+    }
+
+    ~Session() {
+        --alive;
+    }
+
+    static int alive;
+
+    int id;
+};
+
+int Session::alive = 0;
+
+struct Base {
+    virtual ~Base() = default;
+};
+
+struct Derived : Base {
+    int value = 4;
+};
+
+}  // namespace
+
+TEST_CASE("local_shared_ptr is a SharedPtr on a SINGLE block", "[local_shared_ptr]") {
+    STATIC_REQUIRE(std::is_base_of<tiny_std::SharedPtr<int, tiny_std::SINGLE>, tiny_std::local_shared_ptr<int>>::value);
+    STATIC_REQUIRE(std::is_base_of<tiny_std::WeakPtr<int, tiny_std::SINGLE>, tiny_std::local_weak_ptr<int>>::value);
+    STATIC_REQUIRE(sizeof(tiny_std::local_shared_ptr<int>) == sizeof(tiny_std::SharedPtr<int>));
+}
+
+TEST_CASE("make_local_shared counts owners and weak references", "[local_shared_ptr]") {
+    Session::alive = 0;
+    tiny_std::local_weak_ptr<Session> w;
+    {
+        auto p = tiny_std::make_local_shared<Session>(7);
+        REQUIRE(p->id == 7);
+        REQUIRE(p.use_count() == 1);
+
+        tiny_std::local_shared_ptr<Session> q = p;
+        REQUIRE(p.use_count() == 2);
+        w = q;
+        REQUIRE(w.lock().get() == p.get());
+        REQUIRE(!w.Expired());
+    }
+    REQUIRE(Session::alive == 0);
+    REQUIRE(w.Expired());
+    REQUIRE(!w.lock());
+    REQUIRE_THROWS_AS(tiny_std::local_shared_ptr<Session>(w), tiny_std::bad_weak_ptr);
+}
+
+TEST_CASE("enable_local_shared_from_this hands out local owners", "[local_shared_ptr]") {
+    Session::alive = 0;
+    {
+        auto p = tiny_std::make_local_shared<Session>(1);
+        tiny_std::local_shared_ptr<Session> q = p->shared_from_this();
+        REQUIRE(q.get() == p.get());
+        REQUIRE(p.use_count() == 2);
+        REQUIRE(p->weak_from_this().lock().get() == p.get());
+
+        tiny_std::local_shared_ptr<Session> r(new Session(2));
+        REQUIRE(r->shared_from_this().use_count() == 2);
+    }
+    REQUIRE(Session::alive == 0);
+
+    Session unowned(3);
+    REQUIRE_THROWS_AS(unowned.shared_from_this(), tiny_std::bad_weak_ptr);
+}
+
+TEST_CASE("local_shared_ptr converts, casts and adopts", "[local_shared_ptr]") {
+    tiny_std::local_shared_ptr<Base> base = tiny_std::make_local_shared<Derived>();
+    auto derived = tiny_std::dynamic_pointer_cast<Derived>(base);
+    REQUIRE(derived);
+    REQUIRE(derived->value == 4);
+    REQUIRE(base.use_count() == 2);
+    STATIC_REQUIRE(std::is_same<decltype(derived), tiny_std::local_shared_ptr<Derived>>::value);
+
+    tiny_std::local_shared_ptr<const Derived> cderived = tiny_std::static_pointer_cast<const Derived>(base);
+    REQUIRE(tiny_std::const_pointer_cast<Derived>(cderived) == derived);
+
+    int deleted = 0;
+    {
+        tiny_std::local_shared_ptr<int> p(new int(1), [&deleted](int* q) {
+            ++deleted;
+            delete q;
+        });
+        tiny_std::local_shared_ptr<std::string> s(tiny_std::make_unique<std::string>("adopted"));
+        REQUIRE(*s == "adopted");
+    }
+    REQUIRE(deleted == 1);
+}
+
+TEST_CASE("local_shared_ptr share_n produces local owners", "[local_shared_ptr]") {
+    auto p = tiny_std::make_local_shared<int>(5);
+    std::vector<tiny_std::local_shared_ptr<int>> fan;
+    p.share_n(3, std::back_inserter(fan));
+    REQUIRE(p.use_count() == 4);
+    tiny_std::release_batch(fan.begin(), fan.end());
+    REQUIRE(p.use_count() == 1);
+}
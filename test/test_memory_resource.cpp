@@ -0,0 +1,229 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "functional/function.h"
+#include "memory/memory_resource.h"
+#include "smart_ptr/shared_ptr.h"
+#include "smart_ptr/unique_ptr.h"
+
+namespace {
+
+namespace pmr = tiny_std::pmr;
+
+// Forwards to new_delete_resource() and counts what is outstanding.
+class CountingResource : public pmr::memory_resource {
+public:
+    int allocations = 0;
+    int outstanding = 0;
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        ++allocations;
+        ++outstanding;
+        return pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+        --outstanding;
+        pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+bool AlignedTo(const void* p, std::size_t alignment) {
+    return reinterpret_cast<std::uintptr_t>(p) % alignment == 0;
+}
+
+struct Tracked {
+    explicit Tracked(int& live) : live_(live) {
+        ++live_;
+    }
+
+    ~Tracked() {
+        --live_;
+    }
+
+    int& live_;
+};
+
+}  // namespace
+
+TEST_CASE("default resource can be replaced", "[memory_resource]") {
+    REQUIRE(pmr::get_default_resource() == pmr::new_delete_resource());
+    CountingResource counting;
+    REQUIRE(pmr::set_default_resource(&counting) == pmr::new_delete_resource());
+    pmr::polymorphic_allocator<int> alloc;
+    REQUIRE(alloc.resource() == &counting);
+    REQUIRE(pmr::set_default_resource(nullptr) == &counting);
+    REQUIRE(pmr::get_default_resource() == pmr::new_delete_resource());
+    REQUIRE_THROWS_AS(pmr::null_memory_resource()->allocate(1), std::bad_alloc);
+}
+
+TEST_CASE("monotonic_buffer_resource uses the buffer, then grows upstream", "[memory_resource]") {
+    CountingResource upstream;
+    alignas(64) std::array<char, 256> buffer;
+    {
+        pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size(), &upstream);
+        void* a = arena.allocate(100, 8);
+        void* b = arena.allocate(1, 64);
+        REQUIRE(a == buffer.data());
+        REQUIRE(AlignedTo(b, 64));
+        REQUIRE(upstream.allocations == 0);
+
+        for (int i = 0; i < 100; ++i) REQUIRE(AlignedTo(arena.allocate(24, 16), 16));
+        REQUIRE(upstream.allocations > 0);
+        int chunks = upstream.allocations;
+        // Chunks grow geometrically.
+        REQUIRE(chunks < 6);
+
+        void* big = arena.allocate(100000, 256);
+        REQUIRE(AlignedTo(big, 256));
+        arena.release();
+        REQUIRE(upstream.outstanding == 0);
+        REQUIRE(arena.allocate(8) == buffer.data());
+        arena.allocate(1000);
+    }
+    REQUIRE(upstream.outstanding == 0);
+}
+
+TEST_CASE("unsynchronized_pool_resource reuses freed blocks", "[memory_resource]") {
+    CountingResource upstream;
+    {
+        pmr::unsynchronized_pool_resource pool(pmr::pool_options{4, 256}, &upstream);
+        REQUIRE(pool.options().largest_required_pool_block == 256);
+
+        void* a = pool.allocate(24);
+        pool.deallocate(a, 24);
+        REQUIRE(pool.allocate(32) == a);
+
+        std::vector<void*> blocks;
+        for (int i = 0; i < 20; ++i) blocks.push_back(pool.allocate(48, 16));
+        for (void* p : blocks) REQUIRE(AlignedTo(p, 16));
+        int chunks = upstream.allocations;
+        for (void* p : blocks) pool.deallocate(p, 48, 16);
+        for (int i = 0; i < 20; ++i) pool.allocate(48, 16);
+        REQUIRE(upstream.allocations == chunks);
+
+        // Too large or too aligned for the pools: straight upstream.
+        void* large = pool.allocate(1000);
+        void* aligned = pool.allocate(64, 128);
+        REQUIRE(AlignedTo(aligned, 128));
+        REQUIRE(upstream.allocations == chunks + 2);
+        pool.deallocate(large, 1000);
+        REQUIRE(upstream.outstanding == chunks + 1);
+        pool.allocate(5000);
+    }
+    REQUIRE(upstream.outstanding == 0);
+}
+
+TEST_CASE("synchronized_pool_resource serves several threads", "[memory_resource]") {
+    CountingResource upstream;
+    {
+        pmr::synchronized_pool_resource pool(&upstream);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&pool] {
+                std::vector<void*> mine;
+                for (int i = 0; i < 1000; ++i) mine.push_back(pool.allocate(8 << (i % 6)));
+                for (int i = 0; i < 1000; ++i) pool.deallocate(mine[i], 8 << (i % 6));
+            });
+        }
+        for (auto& t : threads) t.join();
+    }
+    REQUIRE(upstream.outstanding == 0);
+}
+
+TEST_CASE("allocate_shared takes a polymorphic_allocator", "[memory_resource]") {
+    CountingResource counting;
+    pmr::unsynchronized_pool_resource pool(&counting);
+    int live = 0;
+    {
+        auto p = tiny_std::allocate_shared<Tracked>(pmr::polymorphic_allocator<Tracked>(&pool), live);
+        auto a = tiny_std::allocate_shared<int[]>(pmr::polymorphic_allocator<int>(&pool), 10, 7);
+        tiny_std::shared_ptr<Tracked> q(new Tracked(live), [](Tracked* t) { delete t; },
+                                         pmr::polymorphic_allocator<Tracked>(&pool));
+        REQUIRE(live == 2);
+        REQUIRE(a[9] == 7);
+        REQUIRE(counting.allocations > 0);
+    }
+    REQUIRE(live == 0);
+}
+
+TEST_CASE("allocate_unique frees through its allocator", "[memory_resource]") {
+    CountingResource counting;
+    int live = 0;
+    {
+        pmr::polymorphic_allocator<Tracked> alloc(&counting);
+        auto p = tiny_std::allocate_unique<Tracked>(alloc, live);
+        REQUIRE(live == 1);
+        REQUIRE(counting.outstanding == 1);
+        REQUIRE(p.get_deleter().get_allocator().resource() == &counting);
+
+        // The deleter follows the pointer on move assignment and swap.
+        pmr::monotonic_buffer_resource arena;
+        auto q = tiny_std::allocate_unique<Tracked>(pmr::polymorphic_allocator<Tracked>(&arena), live);
+        swap(p, q);
+        REQUIRE(p.get_deleter().get_allocator().resource() == &arena);
+        q = std::move(p);
+        REQUIRE(live == 1);
+        REQUIRE(counting.outstanding == 0);
+        q.reset();
+        REQUIRE(live == 0);
+
+        auto s = tiny_std::allocate_unique<std::string>(std::allocator<int>(), "text");
+        REQUIRE(*s == "text");
+    }
+    REQUIRE(counting.outstanding == 0);
+}
+
+TEST_CASE("function allocates large targets from its allocator", "[memory_resource]") {
+    CountingResource counting;
+    std::array<long, 8> big{1, 2, 3, 4, 5, 6, 7, 8};
+    {
+        pmr::polymorphic_allocator<char> alloc(&counting);
+        tiny_std::function<long(int)> f(std::allocator_arg, alloc, [big](int i) { return big[i]; });
+        REQUIRE(f(7) == 8);
+        REQUIRE(counting.outstanding == 1);
+
+        tiny_std::function<long(int)> g = f;
+        REQUIRE(g(3) == 4);
+        REQUIRE(counting.outstanding == 2);
+        REQUIRE(g.target_type() == f.target_type());
+
+        tiny_std::function<long(int)> h = std::move(f);
+        REQUIRE(counting.outstanding == 2);
+        h = nullptr;
+        REQUIRE(counting.outstanding == 1);
+
+        // Targets that fit the small buffer do not allocate.
+        tiny_std::function<int(int)> small(std::allocator_arg, alloc, [](int i) { return i + 1; });
+        REQUIRE(small(1) == 2);
+        REQUIRE(counting.outstanding == 1);
+    }
+    REQUIRE(counting.outstanding == 0);
+}
+
+TEST_CASE("a whole request can live in one arena", "[memory_resource]") {
+    CountingResource upstream;
+    pmr::monotonic_buffer_resource arena(&upstream);
+    {
+        pmr::polymorphic_allocator<std::byte> alloc(&arena);
+        auto session = tiny_std::allocate_shared<std::string>(alloc, "session");
+        auto owned = tiny_std::allocate_unique<std::vector<int>>(alloc, 100, 1);
+        tiny_std::function<std::size_t()> task(std::allocator_arg, alloc,
+                                               [session, n = owned->size()] { return session->size() + n; });
+        REQUIRE(task() == 107);
+        REQUIRE(upstream.allocations == 1);
+    }
+    arena.release();
+    REQUIRE(upstream.outstanding == 0);
+}
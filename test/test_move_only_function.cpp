@@ -0,0 +1,181 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "functional/move_only_function.h"
+#include "smart_ptr/unique_ptr.h"
+
+namespace {
+
+// Records which overload of operator() was picked.
+struct Qualified {
+    std::string operator()() & {
+        return "&";
+    }
+
+    std::string operator()() const& {
+        return "const&";
+    }
+
+    std::string operator()() && {
+        return "&&";
+    }
+
+    std::string operator()() const&& {
+        return "const&&";
+    }
+};
+
+struct Tracked {
+    explicit Tracked(int& live) : live_(&live) {
+        ++*live_;
+    }
+
+    Tracked(Tracked&& other) noexcept : live_(other.live_) {
+        ++*live_;
+    }
+
+    ~Tracked() {
+        --*live_;
+    }
+
+    int operator()() const {
+        return *live_;
+    }
+
+    int* live_;
+};
+
+// Too big for the small buffer.
+struct Big {
+    long values[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+
+    long operator()(int i) const {
+        return values[i];
+    }
+};
+
+int Twice(int x) {
+    return 2 * x;
+}
+
+}  // namespace
+
+TEST_CASE("move_only_function holds move-only targets", "[move_only_function]") {
+    auto owned = tiny_std::make_unique<int>(41);
+    tiny_std::move_only_function<int()> f = [p = std::move(owned)] { return *p.get() + 1; };
+    REQUIRE(f);
+    REQUIRE(f() == 42);
+
+    tiny_std::move_only_function<int()> g = std::move(f);
+    REQUIRE(!f);
+    REQUIRE(f == nullptr);
+    REQUIRE(g() == 42);
+
+    STATIC_REQUIRE(!std::is_copy_constructible<tiny_std::move_only_function<int()>>::value);
+    STATIC_REQUIRE(std::is_nothrow_move_constructible<tiny_std::move_only_function<int()>>::value);
+}
+
+TEST_CASE("move_only_function invokes with the signature's qualifiers", "[move_only_function]") {
+    tiny_std::move_only_function<std::string()> plain = Qualified();
+    tiny_std::move_only_function<std::string() const> c = Qualified();
+    tiny_std::move_only_function<std::string() &> l = Qualified();
+    tiny_std::move_only_function<std::string() const&> cl = Qualified();
+    tiny_std::move_only_function<std::string() &&> r = Qualified();
+    tiny_std::move_only_function<std::string() const&&> cr = Qualified();
+    REQUIRE(plain() == "&");
+    REQUIRE(c() == "const&");
+    REQUIRE(l() == "&");
+    REQUIRE(cl() == "const&");
+    REQUIRE(std::move(r)() == "&&");
+    REQUIRE(std::move(cr)() == "const&&");
+
+    const auto& const_c = c;
+    REQUIRE(const_c() == "const&");
+    STATIC_REQUIRE(!std::is_invocable<const tiny_std::move_only_function<std::string()>&>::value);
+    STATIC_REQUIRE(!std::is_invocable<tiny_std::move_only_function<std::string() &&>&>::value);
+}
+
+TEST_CASE("noexcept signatures only take nothrow targets", "[move_only_function]") {
+    using Nothrow = tiny_std::move_only_function<int(int) noexcept>;
+    auto safe = [](int x) noexcept { return x; };
+    auto unsafe = [](int x) { return x; };
+    STATIC_REQUIRE(std::is_constructible<Nothrow, decltype(safe)>::value);
+    STATIC_REQUIRE(!std::is_constructible<Nothrow, decltype(unsafe)>::value);
+    STATIC_REQUIRE(std::is_nothrow_invocable<Nothrow&, int>::value);
+    Nothrow f = safe;
+    REQUIRE(f(3) == 3);
+
+    // A const signature needs a target that can be called as const.
+    struct MutableOnly {
+        int operator()() {
+            return 1;
+        }
+    };
+    STATIC_REQUIRE(std::is_constructible<tiny_std::move_only_function<int()>, MutableOnly>::value);
+    STATIC_REQUIRE(!std::is_constructible<tiny_std::move_only_function<int() const>, MutableOnly>::value);
+}
+
+TEST_CASE("small nothrow-movable targets are stored inline", "[move_only_function]") {
+    int live = 0;
+    {
+        tiny_std::move_only_function<int()> f = Tracked(live);
+        REQUIRE(live == 1);
+        tiny_std::move_only_function<int()> g(std::in_place_type<Tracked>, live);
+        REQUIRE(live == 2);
+
+        tiny_std::move_only_function<int()> h = std::move(f);
+        REQUIRE(live == 2);
+        swap(g, h);
+        REQUIRE(live == 2);
+        REQUIRE(g() == 2);
+        h = nullptr;
+        REQUIRE(live == 1);
+        h = std::move(g);
+        REQUIRE(live == 1);
+        REQUIRE(h() == 1);
+    }
+    REQUIRE(live == 0);
+
+    tiny_std::move_only_function<long(int)> big = Big();
+    REQUIRE(big(7) == 8);
+    tiny_std::move_only_function<long(int)> moved = std::move(big);
+    REQUIRE(moved(0) == 1);
+    STATIC_REQUIRE(tiny_std::MoveOnlyManager<Tracked>::stored_locally_);
+    STATIC_REQUIRE(!tiny_std::MoveOnlyManager<Big>::stored_locally_);
+}
+
+TEST_CASE("move_only_function is empty for null targets", "[move_only_function]") {
+    int (*null_fn)(int) = nullptr;
+    tiny_std::move_only_function<int(int)> f = null_fn;
+    REQUIRE(!f);
+    f = &Twice;
+    REQUIRE(f(2) == 4);
+    f = Twice;
+    REQUIRE(f(3) == 6);
+
+    tiny_std::function<int(int)> empty;
+    tiny_std::move_only_function<int(int)> g = empty;
+    REQUIRE(!g);
+    tiny_std::move_only_function<int(int) const> empty_mo;
+    tiny_std::move_only_function<int(int)> h = std::move(empty_mo);
+    REQUIRE(!h);
+}
+
+TEST_CASE("a task queue moves each task once", "[move_only_function]") {
+    std::deque<tiny_std::move_only_function<void() &&>> queue;
+    std::string log;
+    for (int i = 0; i < 3; ++i) {
+        auto buffer = std::make_unique<std::string>(std::to_string(i));
+        queue.emplace_back([&log, buffer = std::move(buffer)]() mutable { log += *buffer; });
+    }
+    while (!queue.empty()) {
+        auto task = std::move(queue.front());
+        queue.pop_front();
+        std::move(task)();
+    }
+    REQUIRE(log == "012");
+}
@@ -0,0 +1,70 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <thread>
+
+#include "smart_ptr/reclaim_domain.h"
+
+namespace {
+
+struct Heavy {
+    explicit Heavy(int* destroyed) : destroyed_(destroyed) {}
+
+    ~Heavy() {
+        ++*destroyed_;
+    }
+
+    int* destroyed_;
+};
+
+}  // namespace
+
+TEST_CASE("last release only retires the block", "[reclaim_domain]") {
+    tiny_std::reclaim_domain domain;
+    int destroyed = 0;
+    {
+        auto p = tiny_std::make_deferred_shared<Heavy>(domain, &destroyed);
+        auto q = p;
+    }
+    REQUIRE(destroyed == 0);
+    REQUIRE(domain.stats().backlog == 1);
+
+    REQUIRE(domain.drain() == 1);
+    REQUIRE(destroyed == 1);
+
+    auto stats = domain.stats();
+    REQUIRE(stats.backlog == 0);
+    REQUIRE(stats.retired == 1);
+    REQUIRE(stats.reclaimed == 1);
+    REQUIRE(stats.last_batch == 1);
+}
+
+TEST_CASE("weak references outlive the deferred dispose", "[reclaim_domain]") {
+    tiny_std::reclaim_domain domain;
+    int destroyed = 0;
+    tiny_std::WeakPtr<Heavy> w;
+    {
+        auto p = tiny_std::make_deferred_shared<Heavy>(domain, &destroyed);
+        w = p;
+    }
+    REQUIRE(w.Expired());
+    REQUIRE(destroyed == 0);
+    domain.drain();
+    REQUIRE(destroyed == 1);
+    w.reset();
+}
+
+TEST_CASE("background reclaimer drains in batches", "[reclaim_domain]") {
+    tiny_std::reclaim_domain domain;
+    int destroyed = 0;
+    for (int i = 0; i < 10; ++i) tiny_std::make_deferred_shared<Heavy>(domain, &destroyed);
+    REQUIRE(domain.stats().backlog == 10);
+
+    domain.start(std::chrono::microseconds(100));
+    for (int i = 0; i < 1000 && domain.stats().backlog != 0; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    domain.stop();
+
+    REQUIRE(destroyed == 10);
+    REQUIRE(domain.stats().max_batch == 10);
+}
@@ -0,0 +1,91 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "smart_ptr/sharded_shared_ptr.h"
+
+namespace {
+
+std::atomic<int> g_alive{0};
+
+struct Config {
+    explicit Config(int v) : value(v) {
+        ++g_alive;
+    }
+
+    ~Config() {
+        --g_alive;
+    }
+
+    int value;
+};
+
+}  // namespace
+
+TEST_CASE("only the anchor reconciles the shards", "[sharded_shared_ptr]") {
+    auto anchor = tiny_std::make_sharded_shared<Config>(4);
+    REQUIRE(anchor.is_anchor());
+    REQUIRE(anchor->value == 4);
+    REQUIRE(anchor.use_count() == 1);
+
+    auto copy = anchor;
+    REQUIRE(!copy.is_anchor());
+    REQUIRE(anchor.use_count() == 2);
+
+    auto moved = std::move(anchor);
+    REQUIRE(moved.is_anchor());
+    REQUIRE(!anchor);
+
+    moved.reset();
+    REQUIRE(g_alive == 1);
+    REQUIRE(copy.use_count() == 1);
+    copy.reset();
+    REQUIRE(g_alive == 0);
+}
+
+TEST_CASE("copies released on other threads balance out", "[sharded_shared_ptr]") {
+    auto anchor = tiny_std::make_sharded_shared<Config>(1);
+    std::vector<tiny_std::sharded_shared_ptr<Config>> copies(8, anchor);
+    // Released on threads whose shards never saw the matching copies.
+    std::vector<std::thread> threads;
+    for (auto& c : copies)
+        threads.emplace_back([p = std::move(c)]() mutable { p.reset(); });
+    for (auto& t : threads) t.join();
+    REQUIRE(anchor.use_count() == 1);
+    anchor.reset();
+    REQUIRE(g_alive == 0);
+}
+
+TEST_CASE("anchor release races with copies", "[sharded_shared_ptr]") {
+    constexpr int kThreads = 4;
+    constexpr int kIters = 20000;
+    auto anchor = tiny_std::make_sharded_shared<Config>(2);
+    std::vector<std::thread> threads;
+    std::atomic<long> sum{0};
+    for (int i = 0; i < kThreads; ++i) {
+        threads.emplace_back([p = anchor, &sum]() mutable {
+            long local = 0;
+            for (int j = 0; j < kIters; ++j) {
+                auto copy = p;
+                local += copy->value;
+            }
+            sum += local;
+        });
+    }
+    anchor.reset();
+    for (auto& t : threads) t.join();
+    REQUIRE(sum == 2L * kThreads * kIters);
+    REQUIRE(g_alive == 0);
+}
+
+TEST_CASE("each block pays one cache line per shard", "[sharded_shared_ptr]") {
+    using Block = tiny_std::SpCountedSharded<int>;
+    unsigned count = Block::ShardCount();
+    REQUIRE((count & (count - 1)) == 0);
+    REQUIRE(count <= Block::MAX_SHARDS);
+    REQUIRE((count >= std::thread::hardware_concurrency() || count == Block::MAX_SHARDS));
+    REQUIRE(Block::ShardBytes() == count * 64);
+    REQUIRE(Block::ShardBytes() <= 16 * 1024);
+}
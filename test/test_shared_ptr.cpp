@@ -0,0 +1,713 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "smart_ptr/shared_ptr.h"
+#include "smart_ptr/sp_instrument_report.h"
+
+namespace {
+
+int g_allocations = 0;
+
+template <typename Tp>
+struct CountingAlloc {
+    using value_type = Tp;
+
+    CountingAlloc() = default;
+
+    template <typename Up>
+    CountingAlloc(const CountingAlloc<Up>&) {}
+
+    Tp* allocate(std::size_t n) {
+        ++g_allocations;
+        return std::allocator<Tp>().allocate(n);
+    }
+
+    void deallocate(Tp* p, std::size_t n) {
+        --g_allocations;
+        std::allocator<Tp>().deallocate(p, n);
+    }
+
+    template <typename Up>
+    bool operator==(const CountingAlloc<Up>&) const {
+        return true;
+    }
+
+    template <typename Up>
+    bool operator!=(const CountingAlloc<Up>&) const {
+        return false;
+    }
+};
+
+struct Tracked {
+    static int alive;
+
+    explicit Tracked(int v) : value(v) {
+        ++alive;
+    }
+
+    ~Tracked() {
+        --alive;
+    }
+
+    int value;
+};
+
+int Tracked::alive = 0;
+
+}  // namespace
+
+TEST_CASE("make_shared constructs the object in place", "[shared_ptr]") {
+    tiny_std::shared_ptr<std::string> p = tiny_std::make_shared<std::string>(3, 'x');
+    REQUIRE(p != nullptr);
+    REQUIRE(*p == "xxx");
+    REQUIRE(p->size() == 3);
+    REQUIRE(p.use_count() == 1);
+
+    tiny_std::shared_ptr<std::string> q = p;
+    REQUIRE(p.use_count() == 2);
+    q.reset();
+    REQUIRE(p.use_count() == 1);
+}
+
+TEST_CASE("allocate_shared uses a single allocation", "[shared_ptr]") {
+    g_allocations = 0;
+    {
+        auto p = tiny_std::allocate_shared<Tracked>(CountingAlloc<Tracked>(), 42);
+        REQUIRE(g_allocations == 1);
+        REQUIRE(Tracked::alive == 1);
+        REQUIRE(p->value == 42);
+    }
+    REQUIRE(Tracked::alive == 0);
+    REQUIRE(g_allocations == 0);
+}
+
+TEST_CASE("make_shared releases memory when the constructor throws", "[shared_ptr]") {
+    struct Throws {
+        Throws() {
+            throw 1;
+        }
+    };
+
+    g_allocations = 0;
+    REQUIRE_THROWS(tiny_std::allocate_shared<Throws>(CountingAlloc<Throws>()));
+    REQUIRE(g_allocations == 0);
+}
+
+TEST_CASE("make_shared hooks up enable_shared_from_this", "[shared_ptr]") {
+    struct Node : tiny_std::enable_shared_from_this<Node> {
+        int value = 7;
+    };
+
+    auto p = tiny_std::make_shared<Node>();
+    tiny_std::shared_ptr<Node> q = p->shared_from_this();
+    REQUIRE(q.get() == p.get());
+    REQUIRE(p.use_count() == 2);
+}
+
+namespace {
+
+template <tiny_std::LockPolicy Lp>
+void CheckLockPolicy() {
+    struct Node : tiny_std::EnableSharedFromThis<Node, Lp> {
+        int value = 3;
+    };
+
+    tiny_std::SharedPtr<Node, Lp> p = tiny_std::MakeShared<Node, Lp>();
+    REQUIRE(p->value == 3);
+    REQUIRE(p.use_count() == 1);
+    {
+        tiny_std::SharedPtr<Node, Lp> q = p;
+        tiny_std::WeakPtr<Node, Lp> w = q;
+        REQUIRE(p.use_count() == 2);
+        REQUIRE(w.use_count() == 2);
+        REQUIRE(p->SharedFromThis().get() == p.get());
+    }
+    REQUIRE(p.use_count() == 1);
+
+    tiny_std::SharedPtr<int, Lp> raw(new int(5));
+    REQUIRE(*raw == 5);
+    raw.reset();
+    REQUIRE(raw.use_count() == 0);
+}
+
+}  // namespace
+
+TEST_CASE("SharedPtr works with every lock policy", "[shared_ptr]") {
+    CheckLockPolicy<tiny_std::SINGLE>();
+    CheckLockPolicy<tiny_std::MUTEX>();
+    CheckLockPolicy<tiny_std::ATOMIC>();
+    CheckLockPolicy<tiny_std::BIASED>();
+}
+
+TEST_CASE("last release with a live weak reference keeps the block", "[shared_ptr]") {
+    g_allocations = 0;
+    tiny_std::WeakPtr<Tracked> w;
+    {
+        tiny_std::SharedPtr<Tracked> p = tiny_std::AllocateShared<Tracked>(CountingAlloc<Tracked>(), 1);
+        w = p;
+        REQUIRE(w.use_count() == 1);
+    }
+    REQUIRE(Tracked::alive == 0);
+    REQUIRE(w.Expired());
+    REQUIRE(g_allocations == 1);
+    w.reset();
+    REQUIRE(g_allocations == 0);
+}
+
+TEST_CASE("biased counts merge when the owner drops its last reference", "[shared_ptr]") {
+    auto p = tiny_std::make_biased_shared<Tracked>(1);
+    tiny_std::SharedPtr<Tracked, tiny_std::BIASED> other;
+    int seen = 0;
+    std::thread t([&] {
+        auto copy = p;
+        seen = copy.use_count();
+        other = copy;
+    });
+    t.join();
+    REQUIRE(seen == 2);
+    REQUIRE(p.use_count() == 2);
+    p.reset();
+    REQUIRE(Tracked::alive == 1);
+
+    std::thread([&] { other.reset(); }).join();
+    REQUIRE(Tracked::alive == 0);
+}
+
+TEST_CASE("biased counts released on another thread are collected by the owner", "[shared_ptr]") {
+    auto p = tiny_std::make_biased_shared<Tracked>(2);
+    auto handed_off = p;
+    p.reset();
+    // The owner's count for handed_off is only merged when asked to.
+    std::thread([moved = std::move(handed_off)]() mutable { moved.reset(); }).join();
+    REQUIRE(Tracked::alive == 1);
+    tiny_std::biased_collect();
+    REQUIRE(Tracked::alive == 0);
+}
+
+TEST_CASE("biased counts are merged when the owner thread exits", "[shared_ptr]") {
+    tiny_std::SharedPtr<Tracked, tiny_std::BIASED> p;
+    tiny_std::WeakPtr<Tracked, tiny_std::BIASED> w;
+    std::thread([&] {
+        p = tiny_std::make_biased_shared<Tracked>(3);
+        w = p;
+    }).join();
+    REQUIRE(p.use_count() == 1);
+    REQUIRE(p->value == 3);
+    p.reset();
+    REQUIRE(Tracked::alive == 0);
+    REQUIRE(w.Expired());
+}
+
+namespace {
+
+struct EmptyDeleter {
+    void operator()(Tracked* p) const {
+        delete p;
+    }
+};
+
+struct PoolDeleter {
+    int* returned;
+
+    void operator()(Tracked* p) const {
+        ++*returned;
+        delete p;
+    }
+};
+
+}  // namespace
+
+TEST_CASE("custom deleters are stored in the control block", "[shared_ptr]") {
+    int returned = 0;
+    {
+        tiny_std::SharedPtr<Tracked> p(new Tracked(1), PoolDeleter{&returned});
+        auto q = p;
+        REQUIRE(Tracked::alive == 1);
+    }
+    REQUIRE(returned == 1);
+    REQUIRE(Tracked::alive == 0);
+
+    tiny_std::SharedPtr<int[]> array(new int[4]());
+    REQUIRE(array[3] == 0);
+}
+
+TEST_CASE("empty deleters take no space", "[shared_ptr]") {
+    using Plain = tiny_std::SpCountedPtr<Tracked*, tiny_std::ATOMIC>;
+    using WithDeleter = tiny_std::SpCountedDeleter<Tracked*, EmptyDeleter, std::allocator<void>, tiny_std::ATOMIC>;
+    STATIC_REQUIRE(sizeof(WithDeleter) == sizeof(Plain));
+}
+
+TEST_CASE("instrumentation compiles out by default", "[shared_ptr]") {
+    STATIC_REQUIRE(!tiny_std::sp_instrument_enabled);
+    STATIC_REQUIRE(!std::is_base_of<tiny_std::SpInstrumentState, tiny_std::SpCountedBase<tiny_std::ATOMIC>>::value);
+    STATIC_REQUIRE(sizeof(tiny_std::SpCountedPtr<Tracked*, tiny_std::ATOMIC>) == 3 * sizeof(void*));
+    auto p = tiny_std::make_shared<Tracked>(1);
+    REQUIRE(tiny_std::sp_instrument_snapshot().empty());
+}
+
+TEST_CASE("get_deleter finds the deleter by type", "[shared_ptr]") {
+    int returned = 0;
+    tiny_std::SharedPtr<Tracked> p(new Tracked(2), PoolDeleter{&returned});
+    PoolDeleter* d = tiny_std::get_deleter<PoolDeleter>(p);
+    REQUIRE(d != nullptr);
+    REQUIRE(d->returned == &returned);
+    REQUIRE(tiny_std::get_deleter<EmptyDeleter>(p) == nullptr);
+
+    tiny_std::SharedPtr<Tracked> plain(new Tracked(3));
+    REQUIRE(tiny_std::get_deleter<PoolDeleter>(plain) == nullptr);
+}
+
+TEST_CASE("deleter control blocks use the given allocator", "[shared_ptr]") {
+    g_allocations = 0;
+    {
+        tiny_std::SharedPtr<Tracked> p(new Tracked(4), EmptyDeleter{}, CountingAlloc<Tracked>());
+        REQUIRE(g_allocations == 1);
+        tiny_std::SharedPtr<Tracked> n(nullptr, EmptyDeleter{}, CountingAlloc<Tracked>());
+        REQUIRE(g_allocations == 2);
+    }
+    REQUIRE(g_allocations == 0);
+    REQUIRE(Tracked::alive == 0);
+}
+
+TEST_CASE("unique_ptr hands its deleter to the control block", "[shared_ptr]") {
+    int returned = 0;
+    {
+        tiny_std::unique_ptr<Tracked, PoolDeleter> u(new Tracked(5), PoolDeleter{&returned});
+        tiny_std::SharedPtr<Tracked> p(std::move(u));
+        REQUIRE(u.get() == nullptr);
+        REQUIRE(p->value == 5);
+        REQUIRE(p.use_count() == 1);
+        REQUIRE(tiny_std::get_deleter<PoolDeleter>(p)->returned == &returned);
+    }
+    REQUIRE(returned == 1);
+    REQUIRE(Tracked::alive == 0);
+
+    tiny_std::unique_ptr<Tracked> empty;
+    tiny_std::SharedPtr<Tracked> p(std::move(empty));
+    REQUIRE(p.use_count() == 0);
+}
+
+TEST_CASE("shareable unique_ptr promotes in place", "[shared_ptr]") {
+    {
+        auto u = tiny_std::make_unique_shareable<Tracked>(6);
+        REQUIRE(u->value == 6);
+        Tracked* raw = u.get();
+        tiny_std::SharedPtr<Tracked> p(std::move(u));
+        REQUIRE(p.get() == raw);
+        tiny_std::WeakPtr<Tracked> w = p;
+        p.reset();
+        REQUIRE(Tracked::alive == 0);
+        REQUIRE(w.Expired());
+    }
+    {
+        // Never shared: the deleter frees the reserved room as well.
+        auto u = tiny_std::make_unique_shareable<Tracked>(7);
+        REQUIRE(Tracked::alive == 1);
+    }
+    REQUIRE(Tracked::alive == 0);
+}
+
+TEST_CASE("make_shared<T[]> keeps the elements in the control block", "[shared_ptr]") {
+    g_allocations = 0;
+    {
+        auto p = tiny_std::allocate_shared<int[]>(CountingAlloc<int>(), 5);
+        REQUIRE(g_allocations == 1);
+        for (int i = 0; i < 5; ++i) REQUIRE(p[i] == 0);
+
+        auto filled = tiny_std::allocate_shared<int[]>(CountingAlloc<int>(), 3, 7);
+        REQUIRE(filled[2] == 7);
+    }
+    REQUIRE(g_allocations == 0);
+
+    auto bounded = tiny_std::make_shared<std::string[2]>("x");
+    REQUIRE(bounded[0] == "x");
+    REQUIRE(bounded[1] == "x");
+
+    int row[3] = {1, 2, 3};
+    auto grid = tiny_std::make_shared<int[][3]>(2, row);
+    REQUIRE(grid[1][2] == 3);
+}
+
+namespace {
+
+struct Thrower {
+    Thrower() {
+        if (++built == 3)
+            throw 1;
+        ++Tracked::alive;
+    }
+
+    ~Thrower() {
+        --Tracked::alive;
+    }
+
+    static int built;
+};
+
+int Thrower::built = 0;
+
+}  // namespace
+
+TEST_CASE("make_shared<T[]> destroys the elements it built when one throws", "[shared_ptr]") {
+    REQUIRE_THROWS(tiny_std::make_shared<Thrower[]>(4));
+    REQUIRE(Tracked::alive == 0);
+}
+
+TEST_CASE("for_overwrite variants default-initialize", "[shared_ptr]") {
+    auto buffer = tiny_std::make_shared_for_overwrite<unsigned char[]>(4096);
+    buffer[4095] = 1;
+    REQUIRE(buffer[4095] == 1);
+
+    auto one = tiny_std::make_shared_for_overwrite<std::string>();
+    REQUIRE(one->empty());
+
+    auto fixed = tiny_std::make_shared_for_overwrite<std::string[4]>();
+    REQUIRE(fixed[3].empty());
+
+    auto unique = tiny_std::make_unique_for_overwrite<char[]>(64);
+    unique[0] = 'a';
+    REQUIRE(unique[0] == 'a');
+}
+
+TEST_CASE("owner_before, owner_hash and owner_equal compare control blocks", "[shared_ptr]") {
+    struct Pair {
+        int first = 1;
+        int second = 2;
+    };
+    auto p = tiny_std::make_shared<Pair>();
+    tiny_std::SharedPtr<int> first(p, &p->first);
+    tiny_std::SharedPtr<int> second(p, &p->second);
+    tiny_std::WeakPtr<Pair> weak = p;
+    auto other = tiny_std::make_shared<Pair>();
+
+    REQUIRE(first.owner_equal(second));
+    REQUIRE(first.owner_equal(weak));
+    REQUIRE(weak.owner_equal(p));
+    REQUIRE(first.owner_hash() == weak.owner_hash());
+    REQUIRE(!first.owner_equal(other));
+    REQUIRE(!first.owner_before(second));
+    REQUIRE(!second.owner_before(first));
+    REQUIRE(p.owner_before(other) != other.owner_before(p));
+
+    std::set<tiny_std::WeakPtr<Pair>, tiny_std::owner_less<>> owners;
+    owners.insert(weak);
+    owners.insert(tiny_std::WeakPtr<Pair>(p));
+    owners.insert(tiny_std::WeakPtr<Pair>(other));
+    REQUIRE(owners.size() == 2);
+
+    std::unordered_set<tiny_std::WeakPtr<Pair>, tiny_std::owner_hash, tiny_std::owner_equal> hashed;
+    hashed.insert(weak);
+    p.reset();
+    first.reset();
+    second.reset();
+    // Still found by owner after the object is gone.
+    REQUIRE(weak.Expired());
+    REQUIRE(hashed.count(weak) == 1);
+}
+
+TEST_CASE("Lock does not bring an expired object back", "[shared_ptr]") {
+    tiny_std::WeakPtr<int> weak;
+    {
+        auto p = tiny_std::make_shared<int>(1);
+        weak = p;
+        REQUIRE(*weak.Lock() == 1);
+    }
+    REQUIRE(!weak.Lock());
+    REQUIRE(!weak.Lock());
+    REQUIRE(weak.use_count() == 0);
+}
+
+TEST_CASE("constructing a SharedPtr from an expired WeakPtr throws bad_weak_ptr", "[shared_ptr]") {
+    tiny_std::WeakPtr<int> weak;
+    REQUIRE_THROWS_AS(tiny_std::SharedPtr<int>(weak), tiny_std::bad_weak_ptr);
+    {
+        auto p = tiny_std::make_shared<int>(1);
+        weak = p;
+        tiny_std::SharedPtr<int> q(weak);
+        REQUIRE(q.use_count() == 2);
+    }
+    REQUIRE_THROWS_AS(tiny_std::SharedPtr<int>(weak), tiny_std::bad_weak_ptr);
+    STATIC_REQUIRE(noexcept(weak.Lock()));
+
+    struct Node : tiny_std::enable_shared_from_this<Node> {};
+    Node unowned;
+    REQUIRE_THROWS_AS(unowned.shared_from_this(), tiny_std::bad_weak_ptr);
+}
+
+namespace {
+
+struct Upgraded {
+    static constexpr int LIVE = 0x11fe;
+    static constexpr int DEAD = 0xdead;
+    static std::atomic<int> destroyed;
+
+    ~Upgraded() {
+        state.store(DEAD, std::memory_order_relaxed);
+        destroyed.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::atomic<int> state{LIVE};
+};
+
+std::atomic<int> Upgraded::destroyed{0};
+
+template <tiny_std::LockPolicy Lp>
+void CheckUpgradeUnderExpiry() {
+    constexpr int objects = 2000;
+    constexpr int threads = 4;
+    Upgraded::destroyed = 0;
+
+    std::vector<tiny_std::SharedPtr<Upgraded, Lp>> owners;
+    for (int i = 0; i < objects; ++i) owners.push_back(tiny_std::SharedPtr<Upgraded, Lp>(new Upgraded));
+    std::vector<tiny_std::WeakPtr<Upgraded, Lp>> weak(owners.begin(), owners.end());
+
+    std::atomic<bool> done{false};
+    std::atomic<int> resurrected{0};
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t) {
+        pool.emplace_back([&, t, weak] {
+            while (!done.load(std::memory_order_acquire)) {
+                for (int i = t; i < objects; i += threads) {
+                    if (auto p = weak[i].Lock()) {
+                        if (p->state.load(std::memory_order_relaxed) != Upgraded::LIVE)
+                            resurrected.fetch_add(1);
+                    }
+                }
+            }
+        });
+    }
+    for (auto& owner : owners) owner.reset();
+    done.store(true, std::memory_order_release);
+    for (auto& t : pool) t.join();
+
+    INFO("lock policy " << Lp);
+    REQUIRE(resurrected.load() == 0);
+    REQUIRE(Upgraded::destroyed.load() == objects);
+    // Everything has expired by now: no upgrade may succeed.
+    for (const auto& w : weak) {
+        REQUIRE(!w.Lock());
+        REQUIRE(w.use_count() == 0);
+    }
+}
+
+}  // namespace
+
+TEST_CASE("Lock races with the last release without resurrecting", "[shared_ptr]") {
+    CheckUpgradeUnderExpiry<tiny_std::ATOMIC>();
+    CheckUpgradeUnderExpiry<tiny_std::MUTEX>();
+    CheckUpgradeUnderExpiry<tiny_std::BIASED>();
+}
+
+TEST_CASE("share_n hands out n copies with the right counts", "[shared_ptr]") {
+    Tracked::alive = 0;
+    {
+        auto p = tiny_std::make_shared<Tracked>(5);
+        std::vector<tiny_std::shared_ptr<Tracked>> queues;
+        p.share_n(4, std::back_inserter(queues));
+        REQUIRE(queues.size() == 4);
+        REQUIRE(p.use_count() == 5);
+        for (const auto& q : queues) {
+            REQUIRE(q.get() == p.get());
+            REQUIRE(q.owner_equal(p));
+        }
+        p.share_n(0, std::back_inserter(queues));
+        REQUIRE(queues.size() == 4);
+
+        // Copies of an empty pointer are empty.
+        tiny_std::shared_ptr<Tracked> empty;
+        empty.share_n(2, std::back_inserter(queues));
+        REQUIRE(!queues[5]);
+        REQUIRE(queues[5].use_count() == 0);
+    }
+    REQUIRE(Tracked::alive == 0);
+}
+
+TEST_CASE("share_n drops the unclaimed references when the output throws", "[shared_ptr]") {
+    struct ThrowingSink {
+        int* stored;
+
+        ThrowingSink& operator*() {
+            return *this;
+        }
+
+        ThrowingSink& operator++() {
+            return *this;
+        }
+
+        ThrowingSink& operator=(tiny_std::SharedPtr<int>&&) {
+            if (++*stored == 3)
+                throw 1;
+            return *this;
+        }
+    };
+
+    auto p = tiny_std::make_shared<int>(1);
+    int stored = 0;
+    REQUIRE_THROWS(p.share_n(8, ThrowingSink{&stored}));
+    REQUIRE(p.use_count() == 1);
+}
+
+TEST_CASE("release_batch resets every pointer once per control block", "[shared_ptr]") {
+    Tracked::alive = 0;
+    auto a = tiny_std::make_shared<Tracked>(1);
+    auto b = tiny_std::make_shared<Tracked>(2);
+    std::vector<tiny_std::shared_ptr<Tracked>> batch;
+    a.share_n(3, std::back_inserter(batch));
+    batch.push_back(nullptr);
+    b.share_n(2, std::back_inserter(batch));
+    batch.push_back(a);
+    REQUIRE(a.use_count() == 5);
+    REQUIRE(b.use_count() == 3);
+
+    tiny_std::release_batch(batch.begin(), batch.end());
+    for (const auto& p : batch) {
+        REQUIRE(!p);
+        REQUIRE(p.use_count() == 0);
+    }
+    REQUIRE(a.use_count() == 1);
+    REQUIRE(b.use_count() == 1);
+
+    // The last references are dropped through the batch, too.
+    std::vector<tiny_std::shared_ptr<Tracked>> last;
+    for (int i = 0; i < 100; ++i) last.push_back(i % 2 ? std::move(a) : std::move(b));
+    tiny_std::release_batch(last.begin(), last.end());
+    REQUIRE(Tracked::alive == 0);
+}
+
+namespace {
+
+template <tiny_std::LockPolicy Lp>
+void CheckBatchedCounts() {
+    Tracked::alive = 0;
+    tiny_std::SharedPtr<Tracked, Lp> p(new Tracked(9));
+    tiny_std::WeakPtr<Tracked, Lp> w(p);
+    std::vector<tiny_std::SharedPtr<Tracked, Lp>> copies(2);
+    p.share_n(copies.size(), copies.begin());
+    p.share_n(3, std::back_inserter(copies));
+    INFO("lock policy " << Lp);
+    REQUIRE(p.use_count() == 6);
+
+    p.reset();
+    tiny_std::release_batch(copies.begin(), copies.end() - 1);
+    REQUIRE(w.use_count() == 1);
+    REQUIRE(Tracked::alive == 1);
+    tiny_std::release_batch(copies.end() - 1, copies.end());
+    REQUIRE(w.Expired());
+    REQUIRE(Tracked::alive == 0);
+}
+
+}  // namespace
+
+TEST_CASE("share_n and release_batch work with every lock policy", "[shared_ptr]") {
+    CheckBatchedCounts<tiny_std::SINGLE>();
+    CheckBatchedCounts<tiny_std::MUTEX>();
+    CheckBatchedCounts<tiny_std::ATOMIC>();
+    CheckBatchedCounts<tiny_std::BIASED>();
+}
+
+TEST_CASE("batched references taken and dropped on other threads balance", "[shared_ptr]") {
+    Tracked::alive = 0;
+    auto p = tiny_std::make_shared<Tracked>(3);
+    constexpr int threads = 4;
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t) {
+        pool.emplace_back([&p] {
+            std::vector<tiny_std::shared_ptr<Tracked>> fan;
+            for (int i = 0; i < 1000; ++i) {
+                p.share_n(16, std::back_inserter(fan));
+                tiny_std::release_batch(fan.begin(), fan.end());
+                fan.clear();
+            }
+        });
+    }
+    for (auto& t : pool) t.join();
+    REQUIRE(p.use_count() == 1);
+    p.reset();
+    REQUIRE(Tracked::alive == 0);
+}
+
+TEST_CASE("control blocks dispatch through an ops table, not a vtable", "[shared_ptr]") {
+    STATIC_REQUIRE(!std::is_polymorphic<tiny_std::SpCountedBase<tiny_std::ATOMIC>>::value);
+    STATIC_REQUIRE(sizeof(tiny_std::SpCountedBase<tiny_std::ATOMIC>) == 16);
+    STATIC_REQUIRE(sizeof(tiny_std::SpCountedPtr<int*, tiny_std::ATOMIC>) == 24);
+
+    // get_deleter still finds the deleter through the table.
+    struct Deleter {
+        void operator()(int* p) const {
+            delete p;
+        }
+    };
+    tiny_std::SharedPtr<int> p(new int(1), Deleter());
+    REQUIRE(tiny_std::get_deleter<Deleter>(p) != nullptr);
+    REQUIRE(tiny_std::get_deleter<int>(p) == nullptr);
+}
+
+namespace {
+
+struct Animal {
+    virtual ~Animal() = default;
+};
+
+struct Dog : Animal {};
+
+struct Cat : Animal {};
+
+struct Shape {
+    virtual ~Shape() = default;
+};
+
+struct Circle : virtual Shape {};
+
+}  // namespace
+
+TEST_CASE("pointer casts of rvalues move the ownership", "[shared_ptr]") {
+    tiny_std::shared_ptr<Animal> animal = tiny_std::make_shared<Dog>();
+    Animal* raw = animal.get();
+
+    // A failed dynamic cast leaves the source alone.
+    tiny_std::shared_ptr<Cat> cat = tiny_std::dynamic_pointer_cast<Cat>(std::move(animal));
+    REQUIRE(!cat);
+    REQUIRE(animal.get() == raw);
+
+    tiny_std::shared_ptr<Dog> dog = tiny_std::dynamic_pointer_cast<Dog>(std::move(animal));
+    REQUIRE(!animal);
+    REQUIRE(dog.get() == raw);
+    REQUIRE(dog.use_count() == 1);
+
+    tiny_std::SharedPtr<Animal> base = tiny_std::static_pointer_cast<Animal>(tiny_std::SharedPtr<Dog>(std::move(dog)));
+    REQUIRE(base.get() == raw);
+    REQUIRE(base.use_count() == 1);
+
+    tiny_std::shared_ptr<Dog> a = tiny_std::make_shared<Dog>();
+    tiny_std::shared_ptr<Dog> b;
+    tiny_std::swap(a, b);
+    REQUIRE(!a);
+    REQUIRE(b);
+}
+
+TEST_CASE("WeakPtr converts the pointer of an expired object", "[shared_ptr]") {
+    tiny_std::weak_ptr<Dog> weak_dog;
+    tiny_std::weak_ptr<Circle> weak_circle;
+    {
+        auto dog = tiny_std::make_shared<Dog>();
+        auto circle = tiny_std::make_shared<Circle>();
+        weak_dog = dog;
+        weak_circle = circle;
+    }
+    tiny_std::weak_ptr<Animal> weak_animal = weak_dog;
+    tiny_std::weak_ptr<Shape> weak_shape = weak_circle;
+    tiny_std::weak_ptr<Animal> moved = std::move(weak_dog);
+    REQUIRE(weak_animal.Expired());
+    REQUIRE(weak_shape.Expired());
+    REQUIRE(moved.Expired());
+    REQUIRE(!weak_shape.lock());
+    REQUIRE(weak_dog.use_count() == 0);
+}
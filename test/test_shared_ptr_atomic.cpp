@@ -0,0 +1,124 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "smart_ptr/shared_ptr.h"
+
+TEST_CASE("atomic<SharedPtr> load/store/exchange", "[shared_ptr_atomic]") {
+    tiny_std::atomic<tiny_std::SharedPtr<int>> a;
+    REQUIRE(a.is_lock_free());
+    REQUIRE(a.load() == nullptr);
+
+    auto one = tiny_std::MakeShared<int>(1);
+    a.store(one);
+    REQUIRE(one.use_count() == 2);
+    tiny_std::SharedPtr<int> loaded = a.load();
+    REQUIRE(loaded.get() == one.get());
+    REQUIRE(one.use_count() == 3);
+
+    auto old = a.exchange(tiny_std::MakeShared<int>(2));
+    REQUIRE(old.get() == one.get());
+    REQUIRE(*a.load() == 2);
+
+    a.store(nullptr);
+    REQUIRE(a.load() == nullptr);
+    old.reset();
+    loaded.reset();
+    REQUIRE(one.use_count() == 1);
+}
+
+TEST_CASE("atomic<SharedPtr> compare_exchange", "[shared_ptr_atomic]") {
+    auto one = tiny_std::MakeShared<int>(1);
+    auto two = tiny_std::MakeShared<int>(2);
+    tiny_std::atomic<tiny_std::SharedPtr<int>> a(one);
+
+    tiny_std::SharedPtr<int> expected = two;
+    REQUIRE_FALSE(a.compare_exchange_strong(expected, two));
+    REQUIRE(expected.get() == one.get());
+
+    REQUIRE(a.compare_exchange_strong(expected, two));
+    REQUIRE(a.load().get() == two.get());
+    REQUIRE(one.use_count() == 2);
+    expected.reset();
+    REQUIRE(one.use_count() == 1);
+}
+
+TEST_CASE("atomic<WeakPtr> follows its owner", "[shared_ptr_atomic]") {
+    auto p = tiny_std::MakeShared<int>(5);
+    tiny_std::atomic<tiny_std::WeakPtr<int>> a{tiny_std::WeakPtr<int>(p)};
+    REQUIRE(a.load().use_count() == 1);
+    p.reset();
+    REQUIRE(a.load().Expired());
+}
+
+namespace {
+
+struct Counted {
+    explicit Counted(int v) : value(v) {
+        alive.fetch_add(1);
+    }
+
+    ~Counted() {
+        alive.fetch_sub(1);
+    }
+
+    int value;
+    static std::atomic<int> alive;
+};
+
+std::atomic<int> Counted::alive{0};
+
+}  // namespace
+
+TEST_CASE("atomic<SharedPtr> survives concurrent readers and writers", "[shared_ptr_atomic]") {
+    std::atomic<int> bad_reads{0};
+    {
+        tiny_std::atomic<tiny_std::shared_ptr<Counted>> a(tiny_std::make_shared<Counted>(0));
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&a, &bad_reads] {
+                // Enough loads to go through several claim-counter refills.
+                for (int i = 0; i < 100000; ++i) {
+                    auto p = a.load();
+                    if (p == nullptr || p->value < 0)
+                        bad_reads.fetch_add(1);
+                }
+            });
+        }
+        threads.emplace_back([&a] {
+            for (int i = 1; i < 2000; ++i) a.store(tiny_std::make_shared<Counted>(i));
+        });
+        for (auto& t : threads) t.join();
+        REQUIRE(bad_reads.load() == 0);
+        REQUIRE(Counted::alive.load() == 1);
+    }
+    REQUIRE(Counted::alive.load() == 0);
+}
+
+TEST_CASE("atomic<SharedPtr> keeps its holder under a storm of loads", "[shared_ptr_atomic]") {
+    auto value = tiny_std::make_shared<int>(7);
+    tiny_std::atomic<tiny_std::shared_ptr<int>> a(value);
+    REQUIRE(value.use_count() == 2);
+
+    // Readers only: every refill of the claim counter races with other
+    // readers' claims, and none of them may lose a reference.
+    unsigned readers = std::max(8u, std::thread::hardware_concurrency());
+    std::atomic<int> bad_reads{0};
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < readers; ++t) {
+        threads.emplace_back([&a, &bad_reads] {
+            for (int i = 0; i < 100000; ++i) {
+                auto p = a.load();
+                if (p == nullptr || *p != 7)
+                    bad_reads.fetch_add(1);
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    REQUIRE(bad_reads.load() == 0);
+    REQUIRE(value.use_count() == 2);
+    REQUIRE(a.load() == value);
+}
@@ -0,0 +1,204 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "smart_ptr/intrusive_ptr.h"
+#include "smart_ptr/shared_ptr.h"
+#include "smart_ptr/sp_instrument_report.h"
+
+namespace {
+
+struct Widget {
+    int value = 0;
+};
+
+struct Gadget {
+    char payload[40];
+};
+
+struct Counted : tiny_std::intrusive_ref_counter<Counted> {};
+
+template <typename Tp>
+tiny_std::sp_stats_snapshot StatsOf() {
+    const char* name = tiny_std::SpInstrument::StatsOf<Tp>()->type_name;
+    for (const auto& s : tiny_std::sp_instrument_snapshot()) {
+        if (s.type_name == name)
+            return s;
+    }
+    FAIL("type not registered");
+    return {};
+}
+
+// Reference count updates that fn() makes on the blocks of Tp objects, which
+// is the number of atomic RMWs for the ATOMIC policy.
+template <typename Tp, typename Fn>
+std::uint64_t RmwsOf(Fn fn) {
+    auto before = StatsOf<Tp>();
+    fn();
+    auto after = StatsOf<Tp>();
+    return (after.copies - before.copies) + (after.releases - before.releases) +
+           (after.weak_copies - before.weak_copies) + (after.weak_releases - before.weak_releases);
+}
+
+struct Animal {
+    virtual ~Animal() = default;
+};
+
+struct Dog : Animal {};
+
+struct Shape {
+    virtual ~Shape() = default;
+};
+
+struct Circle : virtual Shape {};
+
+std::uint64_t Lifetimes(const tiny_std::sp_stats_snapshot& s) {
+    std::uint64_t total = 0;
+    for (std::uint64_t n : s.lifetime_ns) total += n;
+    return total;
+}
+
+}  // namespace
+
+TEST_CASE("instrumentation is compiled in", "[sp_instrument]") {
+    STATIC_REQUIRE(tiny_std::sp_instrument_enabled);
+    STATIC_REQUIRE(std::is_base_of<tiny_std::SpInstrumentState, tiny_std::SpCountedBase<tiny_std::ATOMIC>>::value);
+    STATIC_REQUIRE(std::is_base_of<tiny_std::SpInstrumentState, tiny_std::SpCountedBase<tiny_std::BIASED>>::value);
+}
+
+TEST_CASE("shared_ptr reports copies, weak references and lifetime", "[sp_instrument]") {
+    auto before = StatsOf<Widget>();
+    {
+        auto p = tiny_std::make_shared<Widget>();
+        auto live = StatsOf<Widget>();
+        REQUIRE(live.live_objects == before.live_objects + 1);
+        REQUIRE(live.live_bytes == before.live_bytes + static_cast<std::int64_t>(sizeof(Widget)));
+
+        tiny_std::shared_ptr<Widget> q = p;
+        tiny_std::shared_ptr<Widget> r = q;
+        tiny_std::weak_ptr<Widget> w = p;
+    }
+    auto after = StatsOf<Widget>();
+    REQUIRE(std::string(after.type_name).find("Widget") != std::string::npos);
+    REQUIRE(after.allocations == before.allocations + 1);
+    REQUIRE(after.live_objects == before.live_objects);
+    REQUIRE(after.live_bytes == before.live_bytes);
+    REQUIRE(after.copies == before.copies + 2);
+    REQUIRE(after.releases == before.releases + 3);
+    REQUIRE(after.weak_copies == before.weak_copies + 1);
+    REQUIRE(Lifetimes(after) == Lifetimes(before) + 1);
+}
+
+TEST_CASE("every way of creating a control block is attributed", "[sp_instrument]") {
+    auto before = StatsOf<Gadget>();
+    {
+        tiny_std::shared_ptr<Gadget> a(new Gadget);
+        tiny_std::shared_ptr<Gadget> b(new Gadget, [](Gadget* p) { delete p; });
+        tiny_std::shared_ptr<Gadget> c(tiny_std::make_unique<Gadget>());
+        auto d = tiny_std::make_shared<Gadget[]>(3);
+        REQUIRE(StatsOf<Gadget>().live_objects == before.live_objects + 4);
+        REQUIRE(StatsOf<Gadget>().live_bytes == before.live_bytes + 6 * static_cast<std::int64_t>(sizeof(Gadget)));
+    }
+    auto after = StatsOf<Gadget>();
+    REQUIRE(after.allocations == before.allocations + 4);
+    REQUIRE(after.live_objects == before.live_objects);
+    REQUIRE(after.live_bytes == before.live_bytes);
+}
+
+TEST_CASE("intrusive counts report to the derived type", "[sp_instrument]") {
+    auto before = StatsOf<Counted>();
+    {
+        auto p = tiny_std::make_intrusive<Counted>();
+        tiny_std::intrusive_ptr<Counted> q = p;
+    }
+    auto after = StatsOf<Counted>();
+    REQUIRE(after.allocations == before.allocations + 1);
+    REQUIRE(after.live_objects == before.live_objects);
+    REQUIRE(after.copies == before.copies + 2);
+}
+
+TEST_CASE("unique_ptr reports the objects it deletes", "[sp_instrument]") {
+    auto before = StatsOf<Widget>().unique_deletes;
+    {
+        auto p = tiny_std::make_unique<Widget>();
+        p.reset(new Widget);
+        p.reset();
+        p.reset(new Widget);
+    }
+    REQUIRE(StatsOf<Widget>().unique_deletes == before + 3);
+}
+
+TEST_CASE("copies from several threads are all counted", "[sp_instrument]") {
+    auto before = StatsOf<Widget>();
+    auto p = tiny_std::make_shared<Widget>();
+    constexpr int threads = 4;
+    constexpr int iterations = 10000;
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t) {
+        pool.emplace_back([&p] {
+            for (int i = 0; i < iterations; ++i) tiny_std::shared_ptr<Widget> copy = p;
+        });
+    }
+    for (auto& t : pool) t.join();
+    auto after = StatsOf<Widget>();
+    REQUIRE(after.copies == before.copies + threads * iterations);
+    REQUIRE(after.releases == before.releases + threads * iterations);
+    REQUIRE(after.contended_rmws >= before.contended_rmws);
+}
+
+TEST_CASE("export writes one line per type", "[sp_instrument]") {
+    auto p = tiny_std::make_shared<Widget>();
+    std::ostringstream os;
+    tiny_std::sp_instrument_export(os);
+    std::string out = os.str();
+    REQUIRE(out.find("Widget") != std::string::npos);
+    REQUIRE(out.find("live_objects=") != std::string::npos);
+    REQUIRE(out.find("lifetime_log2_ns=") != std::string::npos);
+}
+
+TEST_CASE("copies and moves cost one and zero count updates", "[sp_instrument]") {
+    auto dog = tiny_std::make_shared<Dog>();
+    tiny_std::shared_ptr<Dog> copy;
+    tiny_std::shared_ptr<Dog> moved;
+    REQUIRE(RmwsOf<Dog>([&] { copy = dog; }) == 1);
+    REQUIRE(RmwsOf<Dog>([&] { moved = std::move(copy); }) == 0);
+    REQUIRE(RmwsOf<Dog>([&] { moved.reset(); }) == 1);
+}
+
+TEST_CASE("pointer casts of rvalues take no new reference", "[sp_instrument]") {
+    tiny_std::shared_ptr<Animal> animal = tiny_std::make_shared<Dog>();
+    tiny_std::shared_ptr<Dog> dog;
+    tiny_std::shared_ptr<const Dog> cdog;
+    tiny_std::shared_ptr<Animal> back;
+    REQUIRE(RmwsOf<Dog>([&] { dog = tiny_std::static_pointer_cast<Dog>(animal); }) == 1);
+    REQUIRE(RmwsOf<Dog>([&] { dog = tiny_std::dynamic_pointer_cast<Dog>(std::move(animal)); }) == 1);
+    REQUIRE(!animal);
+    REQUIRE(RmwsOf<Dog>([&] { cdog = tiny_std::const_pointer_cast<const Dog>(std::move(dog)); }) == 0);
+    REQUIRE(RmwsOf<Dog>([&] { dog = tiny_std::const_pointer_cast<Dog>(std::move(cdog)); }) == 0);
+    REQUIRE(RmwsOf<Dog>([&] { animal = tiny_std::static_pointer_cast<Animal>(std::move(dog)); }) == 0);
+    REQUIRE(RmwsOf<Dog>([&] { dog = tiny_std::reinterpret_pointer_cast<Dog>(std::move(animal)); }) == 0);
+    // Converting move assignment.
+    REQUIRE(RmwsOf<Dog>([&] { back = std::move(dog); }) == 0);
+    REQUIRE(back.use_count() == 1);
+}
+
+TEST_CASE("WeakPtr conversions do not lock", "[sp_instrument]") {
+    auto dog = tiny_std::make_shared<Dog>();
+    tiny_std::weak_ptr<Dog> weak_dog = dog;
+    tiny_std::weak_ptr<Animal> weak_animal;
+    REQUIRE(RmwsOf<Dog>([&] { weak_animal = weak_dog; }) == 1);
+    REQUIRE(RmwsOf<Dog>([&] { tiny_std::weak_ptr<Animal> moved(std::move(weak_dog)); }) == 1);
+    REQUIRE(RmwsOf<Dog>([&] { tiny_std::weak_ptr<Animal> copied(weak_animal); }) == 2);
+    REQUIRE(weak_animal.lock().get() == dog.get());
+
+    // Through a virtual base the pointer can only be adjusted while the
+    // object is alive, so that conversion still locks.
+    auto circle = tiny_std::make_shared<Circle>();
+    tiny_std::weak_ptr<Circle> weak_circle = circle;
+    tiny_std::weak_ptr<Shape> weak_shape;
+    REQUIRE(RmwsOf<Circle>([&] { weak_shape = weak_circle; }) == 3);
+    REQUIRE(weak_shape.lock().get() == static_cast<Shape*>(circle.get()));
+}
@@ -10,3 +10,17 @@ TEST_CASE( "Factorials are computed", "[factorial]" ) {
     tiny_std::unique_ptr<int> ptr;
     REQUIRE( ptr == nullptr );
 }
+
+TEST_CASE("make_unique value-initializes arrays", "[unique_ptr]") {
+    auto p = tiny_std::make_unique<int[]>(3);
+    REQUIRE(p[0] == 0);
+    REQUIRE(p[2] == 0);
+
+    auto q = tiny_std::make_unique_for_overwrite<int[]>(3);
+    q[1] = 4;
+    REQUIRE(q[1] == 4);
+
+    auto one = tiny_std::make_unique_for_overwrite<int>();
+    *one.get() = 2;
+    REQUIRE(*one.get() == 2);
+}
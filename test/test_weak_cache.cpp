@@ -0,0 +1,113 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "smart_ptr/shared_ptr.h"
+#include "smart_ptr/weak_cache.h"
+
+namespace {
+
+struct Blob {
+    explicit Blob(std::string s) : text(std::move(s)) {}
+
+    std::string text;
+};
+
+using BlobPtr = tiny_std::SharedPtr<Blob>;
+
+}  // namespace
+
+TEST_CASE("weak_cache returns the live value", "[weak_cache]") {
+    tiny_std::weak_cache<std::string, Blob> cache;
+    int built = 0;
+    auto make = [&built] {
+        ++built;
+        return tiny_std::make_shared<Blob>("hello");
+    };
+
+    BlobPtr a = cache.get_or_create("k", make);
+    BlobPtr b = cache.get_or_create("k", make);
+    REQUIRE(built == 1);
+    REQUIRE(a.get() == b.get());
+    REQUIRE(cache.find("k").get() == a.get());
+    REQUIRE(!cache.find("missing"));
+}
+
+TEST_CASE("weak_cache does not keep values alive", "[weak_cache]") {
+    tiny_std::weak_cache<int, Blob> cache;
+    int built = 0;
+    auto make = [&built] {
+        ++built;
+        return tiny_std::make_shared<Blob>("x");
+    };
+
+    cache.get_or_create(1, make);
+    REQUIRE(!cache.find(1));
+    BlobPtr again = cache.get_or_create(1, make);
+    REQUIRE(built == 2);
+    REQUIRE(again);
+}
+
+TEST_CASE("weak_cache sweeps expired entries a few buckets at a time", "[weak_cache]") {
+    tiny_std::weak_cache<int, Blob> cache;
+    std::vector<BlobPtr> keep;
+    for (int i = 0; i < 1000; ++i) {
+        BlobPtr p = cache.get_or_create(i, [] { return tiny_std::make_shared<Blob>("v"); });
+        if (i % 10 == 0)
+            keep.push_back(p);
+    }
+    // Insertions already swept part of the cache.
+    REQUIRE(cache.size() < 1000);
+    for (int i = 0; i < 1000 && cache.size() > keep.size(); ++i) cache.sweep(4);
+    REQUIRE(cache.size() == keep.size());
+    REQUIRE(cache.find(990).get() == keep.back().get());
+}
+
+TEST_CASE("weak_cache retries after a failed create", "[weak_cache]") {
+    tiny_std::weak_cache<int, Blob> cache;
+    REQUIRE_THROWS_AS(cache.get_or_create(7, []() -> BlobPtr { throw std::runtime_error("boom"); }),
+                      std::runtime_error);
+    BlobPtr p = cache.get_or_create(7, [] { return tiny_std::make_shared<Blob>("ok"); });
+    REQUIRE(p->text == "ok");
+}
+
+TEST_CASE("weak_cache builds each value once under concurrency", "[weak_cache]") {
+    tiny_std::weak_cache<int, Blob> cache;
+    std::atomic<int> built{0};
+    constexpr int threads = 8;
+    constexpr int keys = 64;
+    std::vector<BlobPtr> results[threads];
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t) {
+        pool.emplace_back([&, t] {
+            for (int k = 0; k < keys; ++k) {
+                results[t].push_back(cache.get_or_create(k, [&] {
+                    built.fetch_add(1);
+                    std::this_thread::yield();
+                    return tiny_std::make_shared<Blob>(std::to_string(k));
+                }));
+            }
+        });
+    }
+    for (auto& t : pool) t.join();
+    REQUIRE(built.load() == keys);
+    for (int t = 1; t < threads; ++t) {
+        for (int k = 0; k < keys; ++k) REQUIRE(results[t][k].get() == results[0][k].get());
+    }
+}
+
+TEST_CASE("weak_cache can be keyed by owner", "[weak_cache]") {
+    using Key = tiny_std::WeakPtr<Blob>;
+    tiny_std::weak_cache<Key, std::string, tiny_std::owner_hash, tiny_std::owner_equal> cache;
+    auto doc = tiny_std::make_shared<Blob>("doc");
+    tiny_std::SharedPtr<std::string> text(doc, &doc->text);
+
+    auto summary = cache.get_or_create(Key(doc), [] { return tiny_std::make_shared<std::string>("summary"); });
+    // An aliasing pointer into the same object finds the same entry.
+    REQUIRE(cache.find(Key(tiny_std::SharedPtr<Blob>(doc))).get() == summary.get());
+    REQUIRE(Key(doc).owner_equal(text));
+}